@@ -23,6 +23,7 @@
 #include <QApplication>
 #include <QDir>
 #include <QDomDocument>
+#include <QFileInfo>
 #include <QString>
 #include <QStringList>
 #include <QObject>
@@ -52,6 +53,20 @@ int main(int argc, char **argv)
             pid = args.at(0).section(QLatin1Char(':'), 1).toInt();
             args.removeFirst();
         }
+        // Do we want a segmented render
+        QStringList segments;
+        QString ffmpeg;
+        if (args.count() > 2 && args.at(0) == QLatin1String("-segments")) {
+            int count = args.at(1).toInt();
+            ffmpeg = args.at(2);
+            // Segment playlists are named like the scenelist, with a -segN suffix before the extension
+            const QString extension = QFileInfo(playlist).suffix();
+            const QString base = extension.isEmpty() ? playlist : playlist.left(playlist.size() - extension.size() - 1);
+            for (int i = 1; i <= count; i++) {
+                segments << base + QStringLiteral("-seg%1").arg(i) + (extension.isEmpty() ? QString() : QStringLiteral(".%1").arg(extension));
+            }
+            args = args.mid(3);
+        }
         // Do we want a split render
         if (args.count() > 0 && args.at(0) == QLatin1String("-split")) {
             args.removeFirst();
@@ -140,6 +155,9 @@ int main(int argc, char **argv)
         }
 
         auto *rJob = new RenderJob(render, playlist, target, pid, in, out, qApp);
+        if (!segments.isEmpty()) {
+            rJob->setSegments(segments, ffmpeg);
+        }
         rJob->start();
         QObject::connect(rJob, &RenderJob::renderingFinished, [&, rJob]() {
             rJob->deleteLater();
@@ -151,6 +169,7 @@ int main(int argc, char **argv)
                 "Kdenlive video renderer for MLT.\nUsage: "
                 "kdenlive_render [-erase] [-kuiserver] [-locale:LOCALE] [in=pos] [out=pos] [render] [profile] [rendermodule] [player] [src] [dest] [[arg1] "
                 "[arg2] ...]\n"
+                "       kdenlive_render [render] [src] [dest] [-pid:PID] -segments [count] [ffmpeg]\n"
                 "  -erase: if that parameter is present, src file will be erased at the end\n"
                 "  -kuiserver: if that parameter is present, use KDE job tracker\n"
                 "  -locale:LOCALE : set a locale for rendering. For example, -locale:fr_FR.UTF-8 will use a french locale (comma as numeric separator)\n"
@@ -162,7 +181,8 @@ int main(int argc, char **argv)
                 "  player: path to video player to play when rendering is over, use '-' to disable playing\n"
                 "  src: source file (usually MLT XML)\n"
                 "  dest: destination file\n"
-                "  args: space separated libavformat arguments\n");
+                "  args: space separated libavformat arguments\n"
+                "  -segments: render the src-segN playlists in parallel and join them in dest with ffmpeg\n");
         return 1;
     }
 }
@@ -19,6 +19,7 @@
 
 #include "renderjob.h"
 
+#include <QDomDocument>
 #include <QFile>
 #include <QStringList>
 #include <QThread>
@@ -49,6 +50,8 @@ RenderJob::RenderJob(const QString &render, const QString &scenelist, const QStr
     , m_frame(0)
     , m_pid(pid)
     , m_dualpass(false)
+    , m_concatProcess(nullptr)
+    , m_segmentFailed(false)
 {
     m_renderProcess = new QProcess;
     m_renderProcess->setReadChannel(QProcess::StandardError);
@@ -92,10 +95,53 @@ void RenderJob::slotAbort(const QString &url)
     }
 }
 
+void RenderJob::setSegments(const QStringList &playlists, const QString &ffmpeg)
+{
+    m_ffmpeg = ffmpeg;
+    for (const QString &playlist : playlists) {
+        QFile f(playlist);
+        QDomDocument doc;
+        doc.setContent(&f, false);
+        f.close();
+        QDomElement consumer = doc.documentElement().firstChildElement(QStringLiteral("consumer"));
+        if (consumer.isNull()) {
+            qWarning() << "Invalid segment playlist: " << playlist;
+            continue;
+        }
+        QString source = playlist;
+        if (consumer.hasAttribute(QLatin1String("s")) || consumer.hasAttribute(QLatin1String("r"))) {
+            // Workaround MLT embedded consumer resize (MLT issue #453)
+            source = QStringLiteral("xml:%1?multi=1").arg(playlist);
+        }
+        m_segmentPlaylists << playlist;
+        m_segmentSources << source;
+        m_segmentFiles << consumer.attribute(QStringLiteral("target"));
+        m_segmentFrames << consumer.attribute(QStringLiteral("out")).toInt() - consumer.attribute(QStringLiteral("in")).toInt() + 1;
+        m_segmentProgress << 0;
+    }
+}
+
 void RenderJob::slotAbort()
 {
     qWarning() << "Job aborted by user...";
-    m_renderProcess->kill();
+    if (!m_segmentSources.isEmpty()) {
+        // The main render process is not used by a segmented render, stop the segments and the concatenation
+        m_segmentFailed = true;
+        for (QProcess *process : qAsConst(m_segmentProcesses)) {
+            if (process->state() != QProcess::NotRunning) {
+                process->kill();
+                process->waitForFinished();
+            }
+        }
+        if (m_concatProcess && m_concatProcess->state() != QProcess::NotRunning) {
+            m_concatProcess->disconnect(this);
+            m_concatProcess->kill();
+            m_concatProcess->waitForFinished();
+        }
+        removeSegments();
+    } else {
+        m_renderProcess->kill();
+    }
 
     if (m_kdenliveinterface) {
         m_dbusargs[1] = -3;
@@ -133,28 +179,160 @@ void RenderJob::receivedStderr()
             m_progress = 50 + m_progress / 2.0;
         }
         int frame = result.section(QLatin1Char(','), 1).section(QLatin1Char(' '), -1).toInt();
-        if ((m_kdenliveinterface != nullptr) && m_kdenliveinterface->isValid()) {
-            m_dbusargs[1] = m_progress;
-            m_kdenliveinterface->callWithArgumentList(QDBus::NoBlock, QStringLiteral("setRenderingProgress"), m_dbusargs);
+        updateProgress(frame);
+    }
+}
+
+void RenderJob::updateProgress(int frame)
+{
+    if ((m_kdenliveinterface != nullptr) && m_kdenliveinterface->isValid()) {
+        m_dbusargs[1] = m_progress;
+        m_kdenliveinterface->callWithArgumentList(QDBus::NoBlock, QStringLiteral("setRenderingProgress"), m_dbusargs);
+    }
+    if (m_jobUiserver) {
+        m_jobUiserver->call(QStringLiteral("setPercent"), (uint)m_progress);
+        int seconds = m_startTime.secsTo(QTime::currentTime());
+        if (seconds < 0) {
+            // 1 day offset, add seconds in a day
+            seconds += 86400;
         }
-        if (m_jobUiserver) {
-            m_jobUiserver->call(QStringLiteral("setPercent"), (uint)m_progress);
-            int seconds = m_startTime.secsTo(QTime::currentTime());
-            if (seconds < 0) {
-                // 1 day offset, add seconds in a day
-                seconds += 86400;
-            }
-            seconds = (int)(seconds * (100 - m_progress) / m_progress);
-            if (seconds == m_seconds) {
-                return;
-            }
-            m_jobUiserver->call(QStringLiteral("setDescriptionField"), (uint)0, QString(),
-                                tr("Remaining time: ") + QTime(0, 0, 0).addSecs(seconds).toString(QStringLiteral("hh:mm:ss")));
-            // m_jobUiserver->call(QStringLiteral("setSpeed"), (frame - m_frame) / (seconds - m_seconds));
-            // m_jobUiserver->call("setSpeed", (frame - m_frame) / (seconds - m_seconds));
-            m_frame = frame;
-            m_seconds = seconds;
+        seconds = (int)(seconds * (100 - m_progress) / m_progress);
+        if (seconds == m_seconds) {
+            return;
+        }
+        m_jobUiserver->call(QStringLiteral("setDescriptionField"), (uint)0, QString(),
+                            tr("Remaining time: ") + QTime(0, 0, 0).addSecs(seconds).toString(QStringLiteral("hh:mm:ss")));
+        // m_jobUiserver->call(QStringLiteral("setSpeed"), (frame - m_frame) / (seconds - m_seconds));
+        // m_jobUiserver->call("setSpeed", (frame - m_frame) / (seconds - m_seconds));
+        m_frame = frame;
+        m_seconds = seconds;
+    }
+}
+
+void RenderJob::startSegments()
+{
+    for (int i = 0; i < m_segmentSources.count(); i++) {
+        auto *process = new QProcess(this);
+        process->setReadChannel(QProcess::StandardError);
+        m_segmentProcesses << process;
+        connect(process, &QProcess::readyReadStandardError, this, [this, i]() { receivedSegmentStderr(i); });
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+                [this, i](int exitCode, QProcess::ExitStatus status) { segmentFinished(i, exitCode, status); });
+        const QStringList args{QStringLiteral("-progress"), m_segmentSources.at(i)};
+        process->start(m_prog, args);
+        qDebug() << "Started segment render process: " << m_prog << ' ' << args.join(QLatin1Char(' '));
+        m_logstream << "Started segment render process: " << m_prog << ' ' << args.join(QLatin1Char(' ')) << "\n";
+    }
+    m_logstream.flush();
+}
+
+void RenderJob::receivedSegmentStderr(int ix)
+{
+    QString result = QString::fromLocal8Bit(m_segmentProcesses.at(ix)->readAllStandardError()).simplified();
+    if (!result.startsWith(QLatin1String("Current Frame"))) {
+        m_errorMessage.append(result + QStringLiteral("<br>"));
+        return;
+    }
+    m_logstream << "melt " << ix + 1 << ": " << result << "\n";
+    int pro = result.section(QLatin1Char(' '), -1).toInt();
+    if (pro <= m_segmentProgress.at(ix) || pro <= 0 || pro > 100) {
+        return;
+    }
+    m_segmentProgress[ix] = pro;
+    // Overall progress is the sum of the segments progress weighted by their length, keep the last percent for the concatenation
+    qint64 done = 0;
+    qint64 total = 0;
+    for (int i = 0; i < m_segmentFrames.count(); i++) {
+        done += qint64(m_segmentProgress.at(i)) * m_segmentFrames.at(i);
+        total += m_segmentFrames.at(i);
+    }
+    if (total <= 0) {
+        return;
+    }
+    int progress = int(99 * done / (100 * total));
+    if (progress <= m_progress || progress <= 0) {
+        return;
+    }
+    m_progress = progress;
+    updateProgress(int(done / 100));
+}
+
+void RenderJob::segmentFinished(int ix, int exitCode, QProcess::ExitStatus status)
+{
+    if (m_segmentFailed) {
+        return;
+    }
+    if (status == QProcess::CrashExit || exitCode != 0) {
+        // One segment failed, abort the others
+        m_segmentFailed = true;
+        m_logstream << "Segment " << ix + 1 << " failed" << "\n";
+        for (QProcess *process : qAsConst(m_segmentProcesses)) {
+            process->kill();
         }
+        removeSegments();
+        slotIsOver(QProcess::CrashExit);
+        return;
+    }
+    m_logstream << "Segment " << ix + 1 << " finished" << "\n";
+    for (QProcess *process : qAsConst(m_segmentProcesses)) {
+        if (process->state() != QProcess::NotRunning) {
+            return;
+        }
+    }
+    concatSegments();
+}
+
+void RenderJob::concatSegments()
+{
+    // Join the segments with ffmpeg's concat demuxer, without re-encoding
+    QFile list(m_logfile.fileName().section(QLatin1Char('.'), 0, -2) + QStringLiteral(".concat"));
+    if (!list.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        m_errorMessage.append(tr("Cannot write to file %1").arg(list.fileName()));
+        removeSegments();
+        slotIsOver(QProcess::CrashExit);
+        return;
+    }
+    QTextStream listStream(&list);
+    for (const QString &file : qAsConst(m_segmentFiles)) {
+        QString escaped = file;
+        escaped.replace(QLatin1Char('\''), QStringLiteral("'\\''"));
+        listStream << "file '" << escaped << "'\n";
+    }
+    listStream.flush();
+    list.close();
+    const QStringList args{QStringLiteral("-y"),  QStringLiteral("-f"), QStringLiteral("concat"), QStringLiteral("-safe"), QStringLiteral("0"),
+                           QStringLiteral("-i"),  list.fileName(),      QStringLiteral("-map"),   QStringLiteral("0"),     QStringLiteral("-c"),
+                           QStringLiteral("copy"), m_dest};
+    m_concatProcess = new QProcess(this);
+    m_concatProcess->setReadChannel(QProcess::StandardError);
+    connect(m_concatProcess, &QProcess::readyReadStandardError, this,
+            [this]() { m_errorMessage.append(QString::fromLocal8Bit(m_concatProcess->readAllStandardError()).simplified() + QStringLiteral("<br>")); });
+    connect(m_concatProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &RenderJob::concatFinished);
+    m_concatProcess->start(m_ffmpeg, args);
+    m_logstream << "Started concat process: " << m_ffmpeg << ' ' << args.join(QLatin1Char(' ')) << "\n";
+    m_logstream.flush();
+}
+
+void RenderJob::concatFinished(int exitCode, QProcess::ExitStatus status)
+{
+    if (status == QProcess::NormalExit && (exitCode != 0 || m_concatProcess->error() != QProcess::UnknownError)) {
+        m_logstream << "Concat process failed with exit code " << exitCode << "\n";
+        status = QProcess::CrashExit;
+    }
+    slotIsOver(status);
+}
+
+void RenderJob::removeSegments()
+{
+    for (const QString &file : qAsConst(m_segmentFiles)) {
+        QFile::remove(file);
+    }
+    // The segment playlists are only written for this render
+    for (const QString &playlist : qAsConst(m_segmentPlaylists)) {
+        QFile::remove(playlist);
+    }
+    if (!m_segmentFiles.isEmpty()) {
+        QFile::remove(m_logfile.fileName().section(QLatin1Char('.'), 0, -2) + QStringLiteral(".concat"));
     }
 }
 
@@ -207,6 +385,11 @@ void RenderJob::start()
         slotIsOver(QProcess::NormalExit, false);
     }*/
 
+    if (!m_segmentSources.isEmpty()) {
+        startSegments();
+        return;
+    }
+
     // Because of the logging, we connect to stderr in all cases.
     connect(m_renderProcess, &QProcess::readyReadStandardError, this, &RenderJob::receivedStderr);
     m_renderProcess->start(m_prog, m_args);
@@ -258,6 +441,9 @@ void RenderJob::slotCheckProcess(QProcess::ProcessState state)
 
 void RenderJob::slotIsOver(QProcess::ExitStatus status, bool isWritable)
 {
+    if (!m_segmentFiles.isEmpty()) {
+        removeSegments();
+    }
     if (m_jobUiserver) {
         m_jobUiserver->call(QStringLiteral("setDescriptionField"), (uint)1, tr("Rendered file"), m_dest);
         m_jobUiserver->call(QStringLiteral("terminate"), QString());
@@ -25,6 +25,7 @@
 #include <QProcess>
 #include <QTime>
 #include <QFile>
+#include <QVector>
 // Testing
 #include <QTextStream>
 
@@ -36,6 +37,8 @@ public:
     RenderJob(const QString &render, const QString &scenelist, const QString &target, int pid = -1, int in = -1, int out = -1, QObject *parent = nullptr);
     ~RenderJob();
     void setLocale(const QString &locale);
+    /** @brief Render the segment playlists in parallel instead of the scenelist, then join them with ffmpeg. */
+    void setSegments(const QStringList &playlists, const QString &ffmpeg);
 
 public slots:
     void start();
@@ -71,7 +74,31 @@ private:
     QStringList m_args;
     /** @brief Used to write to the log file. */
     QTextStream m_logstream;
+    /** @brief The segment playlists of a segmented render. */
+    QStringList m_segmentPlaylists;
+    /** @brief The playlist arguments passed to melt for each segment. */
+    QStringList m_segmentSources;
+    /** @brief The file rendered by each segment. */
+    QStringList m_segmentFiles;
+    /** @brief The length in frames of each segment, used to weight the progress. */
+    QVector<int> m_segmentFrames;
+    QVector<int> m_segmentProgress;
+    QList<QProcess *> m_segmentProcesses;
+    /** @brief The ffmpeg process joining the segments. */
+    QProcess *m_concatProcess;
+    bool m_segmentFailed;
+    /** @brief The ffmpeg executable used to join the segments. */
+    QString m_ffmpeg;
     void initKdenliveDbusInterface();
+    /** @brief Send m_progress to Kdenlive and the job tracker. */
+    void updateProgress(int frame);
+    void startSegments();
+    void receivedSegmentStderr(int ix);
+    void segmentFinished(int ix, int exitCode, QProcess::ExitStatus status);
+    /** @brief All segments are rendered, stream copy them into the destination file. */
+    void concatSegments();
+    void concatFinished(int exitCode, QProcess::ExitStatus status);
+    void removeSegments();
 
 signals:
     void renderingFinished();
@@ -22,6 +22,7 @@
 #include "treeitem.hpp"
 #include "abstracttreemodel.hpp"
 #include <QDebug>
+#include <algorithm>
 #include <numeric>
 #include <utility>
 
@@ -86,9 +87,7 @@ bool TreeItem::appendChild(const std::shared_ptr<TreeItem> &child)
     if (auto ptr = m_model.lock()) {
         ptr->notifyRowAboutToAppend(shared_from_this());
         child->updateParent(shared_from_this());
-        int id = child->getId();
-        auto it = m_childItems.insert(m_childItems.end(), child);
-        m_iteratorTable[id] = it;
+        insertChildAt((int)m_childItems.size(), child);
         registerSelf(child);
         ptr->notifyRowAppended(child);
         return true;
@@ -104,18 +103,13 @@ void TreeItem::moveChild(int ix, const std::shared_ptr<TreeItem> &child)
         auto parentPtr = child->m_parentItem.lock();
         if (parentPtr && parentPtr->getId() != m_id) {
             parentPtr->removeChild(child);
-        } else {
+        } else if (m_rowTable.count(child->getId()) > 0) {
             // deletion of child
-            auto it = m_iteratorTable[child->getId()];
-            m_childItems.erase(it);
+            eraseChild(child->getId());
         }
         ptr->notifyRowAboutToAppend(shared_from_this());
         child->updateParent(shared_from_this());
-        int id = child->getId();
-        auto pos = m_childItems.begin();
-        std::advance(pos, ix);
-        auto it = m_childItems.insert(pos, child);
-        m_iteratorTable[id] = it;
+        insertChildAt(ix, child);
         ptr->notifyRowAppended(child);
         m_isInModel = true;
     } else {
@@ -127,14 +121,10 @@ void TreeItem::moveChild(int ix, const std::shared_ptr<TreeItem> &child)
 void TreeItem::removeChild(const std::shared_ptr<TreeItem> &child)
 {
     if (auto ptr = m_model.lock()) {
-        ptr->notifyRowAboutToDelete(shared_from_this(), child->row());
-        // get iterator corresponding to child
-        Q_ASSERT(m_iteratorTable.count(child->getId()) > 0);
-        auto it = m_iteratorTable[child->getId()];
+        Q_ASSERT(m_rowTable.count(child->getId()) > 0);
+        ptr->notifyRowAboutToDelete(shared_from_this(), childRow(child->getId()));
         // deletion of child
-        m_childItems.erase(it);
-        // clean iterator table
-        m_iteratorTable.erase(child->getId());
+        eraseChild(child->getId());
         child->m_depth = 0;
         child->m_parentItem.reset();
         child->deregisterSelf();
@@ -170,9 +160,7 @@ bool TreeItem::changeParent(std::shared_ptr<TreeItem> newParent)
 std::shared_ptr<TreeItem> TreeItem::child(int row) const
 {
     Q_ASSERT(row >= 0 && row < (int)m_childItems.size());
-    auto it = m_childItems.cbegin();
-    std::advance(it, row);
-    return (*it);
+    return m_childItems[(size_t)row];
 }
 
 int TreeItem::childCount() const
@@ -203,13 +191,40 @@ std::weak_ptr<TreeItem> TreeItem::parentItem() const
 int TreeItem::row() const
 {
     if (auto ptr = m_parentItem.lock()) {
-        // we compute the distance in the parent's children list
-        auto it = ptr->m_childItems.begin();
-        return (int)std::distance(it, (decltype(it))ptr->m_iteratorTable.at(m_id));
+        return ptr->childRow(m_id);
     }
     return -1;
 }
 
+int TreeItem::childRow(int childId) const
+{
+    Q_ASSERT(m_rowTable.count(childId) > 0);
+    return m_rowTable.at(childId);
+}
+
+void TreeItem::updateRows(int from)
+{
+    for (int i = from; i < (int)m_childItems.size(); ++i) {
+        m_rowTable[m_childItems[(size_t)i]->getId()] = i;
+    }
+}
+
+void TreeItem::insertChildAt(int row, const std::shared_ptr<TreeItem> &child)
+{
+    Q_ASSERT(row >= 0 && row <= (int)m_childItems.size());
+    m_childItems.insert(m_childItems.begin() + row, child);
+    // the following children are shifted, appending only sets the row of the new child
+    updateRows(row);
+}
+
+void TreeItem::eraseChild(int childId)
+{
+    int row = childRow(childId);
+    m_childItems.erase(m_childItems.begin() + row);
+    m_rowTable.erase(childId);
+    updateRows(row);
+}
+
 int TreeItem::depth() const
 {
     return m_depth;
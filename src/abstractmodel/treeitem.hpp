@@ -27,6 +27,7 @@
 #include <QVariant>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 /* @brief This class is a generic class to represent items of a tree-like model
    It works in tandem with AbstractTreeModel or one of its derived classes.
@@ -155,9 +156,22 @@ protected:
     */
     virtual void updateParent(std::shared_ptr<TreeItem> parent);
 
-    std::list<std::shared_ptr<TreeItem>> m_childItems;
-    std::unordered_map<int, std::list<std::shared_ptr<TreeItem>>::iterator>
-        m_iteratorTable; // this logs the iterator associated which each child id. This allows easy access of a child based on its id.
+    /* @brief Return the index of the child with given id amongst the children of this item, in constant time.
+       It does not modify the item, so it is safe under the model read lock.
+    */
+    int childRow(int childId) const;
+
+    /* @brief Update the cached rows of the children starting at given row, after an insertion or a removal */
+    void updateRows(int from);
+
+    /* @brief Insert the child in the children list at given row, and update the row cache accordingly */
+    void insertChildAt(int row, const std::shared_ptr<TreeItem> &child);
+
+    /* @brief Remove the child from the children list, and update the row cache accordingly */
+    void eraseChild(int childId);
+
+    std::vector<std::shared_ptr<TreeItem>> m_childItems;
+    std::unordered_map<int, int> m_rowTable; // this logs the row associated with each child id
 
     QList<QVariant> m_itemData;
     std::weak_ptr<TreeItem> m_parentItem;
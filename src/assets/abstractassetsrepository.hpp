@@ -29,6 +29,8 @@
 #include <mutex>
 #include <unordered_map>
 
+class AssetDescriptor;
+
 /** @brief This class is the base class for assets (transitions or effets) repositories
  */
 
@@ -59,6 +61,9 @@ public:
     /* @brief Returns a DomElement representing the asset's properties */
     QDomElement getXml(const QString &assetId) const;
 
+    /* @brief Returns the parameter definitions of the asset, shared by all its instances */
+    std::shared_ptr<const AssetDescriptor> getDescriptor(const QString &assetId) const;
+
 protected:
     struct Info
     {
@@ -108,6 +113,26 @@ protected:
     /* @brief Returns the path to the assets' preferred list*/
     virtual QString assetPreferredListPath() const = 0;
 
+    /* @brief Returns the name of the cache storing the parsed assets between launches*/
+    virtual QString assetCacheName() const = 0;
+
+    // Version of the cache file format, increase it when Info changes
+    static const quint32 AssetCacheVersion = 1;
+
+    /* @brief Returns a key identifying everything the parsed assets depend on: versions, locale, MLT modules and custom XML files
+       @param mltAssets is the list of assets available in MLT
+       @param customFiles is the list of custom XML files
+     */
+    QByteArray cacheKey(Mlt::Properties *mltAssets, const QStringList &customFiles) const;
+
+    /* @brief Fill the assets from the cache file
+       @return false if there is no cache or if it was built with another key
+     */
+    bool loadCache(const QByteArray &key);
+
+    /* @brief Write the parsed assets to the cache file */
+    void saveCache(const QByteArray &key) const;
+
     std::unordered_map<QString, Info> m_assets;
 
     QSet<QString> m_blacklist;
@@ -19,15 +19,27 @@
  *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
  ***************************************************************************/
 
+#include "assets/model/assetdescriptor.hpp"
 #include "xml/xml.hpp"
+#include "kdenlive_debug.h"
 #include "kdenlivesettings.h"
+#include "utils/startuptimer.hpp"
+#include <config-kdenlive.h>
 
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
 #include <QStandardPaths>
 #include <QString>
 #include <QTextStream>
 #include <KLocalizedString>
+#include <framework/mlt_version.h>
 
 #include <locale>
 #ifdef Q_OS_MAC
@@ -51,8 +63,31 @@ template <typename AssetType> void AbstractAssetsRepository<AssetType>::init()
     // Parse preferred list
     parseAssetList(assetPreferredListPath(), m_preferred_list);
 
+    QElapsedTimer timer;
+    timer.start();
     // Retrieve the list of MLT's available assets.
     QScopedPointer<Mlt::Properties> assets(retrieveListFromMlt());
+
+    // Set the directories to look into for custom effects, in reverse order to prioritize local install
+    QStringList asset_dirs = assetDirs();
+    QStringList customFiles;
+    QListIterator<QString> dirs_it(asset_dirs);
+    for (dirs_it.toBack(); dirs_it.hasPrevious();) {
+        QDir current_dir(dirs_it.previous());
+        QStringList filter {QStringLiteral("*.xml")};
+        QStringList fileList = current_dir.entryList(filter, QDir::Files);
+        for (const auto &file : fileList) {
+            customFiles << current_dir.absoluteFilePath(file);
+        }
+    }
+
+    // Querying MLT metadata and parsing custom files is slow, reuse the result of the last launch if nothing changed
+    const QByteArray key = cacheKey(assets.data(), customFiles);
+    if (loadCache(key)) {
+        StartupTimer::record(QStringLiteral("%1 (cached)").arg(assetCacheName()), timer.elapsed());
+        return;
+    }
+
     int max = assets->count();
     QString sox = QStringLiteral("sox.");
     for (int i = 0; i < max; ++i) {
@@ -77,25 +112,14 @@ template <typename AssetType> void AbstractAssetsRepository<AssetType>::init()
 
     // We now parse custom effect xml
 
-    // Set the directories to look into for effects.
-    QStringList asset_dirs = assetDirs();
-
     /* Parsing of custom xml works as follows: we parse all custom files.
        Each of them contains a tag, which is the corresponding mlt asset, and an id that is the name of the asset. Note that several custom files can correspond
        to the same tag, and in that case they must have different ids. We do the parsing in a map from ids to parse info, and then we add them to the asset
        list, while discarding the bare version of each tag (the one with no file associated)
     */
     std::unordered_map<QString, Info> customAssets;
-    // reverse order to prioritize local install
-    QListIterator<QString> dirs_it(asset_dirs);
-    for (dirs_it.toBack(); dirs_it.hasPrevious();) { auto dir=dirs_it.previous();
-        QDir current_dir(dir);
-        QStringList filter {QStringLiteral("*.xml")};
-        QStringList fileList = current_dir.entryList(filter, QDir::Files);
-        for (const auto &file : fileList) {
-            QString path = current_dir.absoluteFilePath(file);
-            parseCustomAssetFile(path, customAssets);
-        }
+    for (const QString &path : qAsConst(customFiles)) {
+        parseCustomAssetFile(path, customAssets);
     }
 
     // We add the custom assets
@@ -111,6 +135,126 @@ template <typename AssetType> void AbstractAssetsRepository<AssetType>::init()
             qDebug() << "Error: conflicting asset name " << custom.first;
         }*/
     }
+    saveCache(key);
+    StartupTimer::record(assetCacheName(), timer.elapsed());
+}
+
+template <typename AssetType> QByteArray AbstractAssetsRepository<AssetType>::cacheKey(Mlt::Properties *mltAssets, const QStringList &customFiles) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    auto addFile = [&hash](const QFileInfo &info) {
+        hash.addData(info.absoluteFilePath().toUtf8());
+        hash.addData(QByteArray::number(info.size()));
+        hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    };
+    hash.addData(QByteArray(KDENLIVE_VERSION));
+    hash.addData(QByteArray(mlt_version_get_string()));
+    // Names and descriptions are translated, float values formatted with the current locale
+    hash.addData(QLocale().name().toUtf8());
+    hash.addData(KLocalizedString::languages().join(QLatin1Char(',')).toUtf8());
+    for (int i = 0; i < mltAssets->count(); ++i) {
+        hash.addData(QByteArray(mltAssets->get_name(i)));
+    }
+    // MLT modules and their metadata files
+    const char *modules = mlt_environment("MLT_REPOSITORY");
+    if (modules != nullptr) {
+        const QFileInfoList moduleFiles = QDir(QString::fromUtf8(modules)).entryInfoList(QDir::Files, QDir::Name);
+        for (const QFileInfo &info : moduleFiles) {
+            addFile(info);
+        }
+    }
+    const char *data = mlt_environment("MLT_DATA");
+    if (data != nullptr) {
+        QStringList metadataFiles;
+        QDirIterator it(QString::fromUtf8(data), {QStringLiteral("*.yml")}, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            metadataFiles << it.next();
+        }
+        metadataFiles.sort();
+        for (const QString &path : qAsConst(metadataFiles)) {
+            addFile(QFileInfo(path));
+        }
+    }
+    for (const QString &path : customFiles) {
+        addFile(QFileInfo(path));
+    }
+    return hash.result();
+}
+
+template <typename AssetType> bool AbstractAssetsRepository<AssetType>::loadCache(const QByteArray &key)
+{
+    QFile file(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/assets/") + assetCacheName() + QStringLiteral(".cache"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    quint32 version;
+    QByteArray cachedKey;
+    stream >> version >> cachedKey;
+    if (version != AssetCacheVersion || cachedKey != key) {
+        return false;
+    }
+    qint32 count;
+    QString xmlData;
+    stream >> count >> xmlData;
+    // All the assets xml are stored in a single document, parsed only once
+    QDomDocument doc;
+    if (stream.status() != QDataStream::Ok || !doc.setContent(xmlData, false)) {
+        return false;
+    }
+    QDomNodeList xmlNodes = doc.documentElement().childNodes();
+    if (xmlNodes.count() != count) {
+        return false;
+    }
+    std::unordered_map<QString, Info> assets;
+    for (int i = 0; i < count; ++i) {
+        QString assetKey;
+        Info info;
+        qint32 type;
+        stream >> assetKey >> info.id >> info.mltId >> info.name >> info.description >> info.author >> info.version_str >> info.version >> type;
+        info.type = static_cast<AssetType>(type);
+        QDomElement xml = xmlNodes.at(i).toElement();
+        if (xml.tagName() != QLatin1String("none")) {
+            info.xml = xml;
+        }
+        assets[assetKey] = info;
+    }
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+    m_assets = std::move(assets);
+    return true;
+}
+
+template <typename AssetType> void AbstractAssetsRepository<AssetType>::saveCache(const QByteArray &key) const
+{
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    if (!dir.mkpath(QStringLiteral("assets"))) {
+        return;
+    }
+    QSaveFile file(dir.absoluteFilePath(QStringLiteral("assets/") + assetCacheName() + QStringLiteral(".cache")));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(KDENLIVE_LOG) << "Cannot write asset cache" << file.fileName();
+        return;
+    }
+    QDomDocument doc;
+    QDomElement root = doc.createElement(QStringLiteral("assets"));
+    doc.appendChild(root);
+    for (const auto &asset : m_assets) {
+        if (asset.second.xml.isNull()) {
+            root.appendChild(doc.createElement(QStringLiteral("none")));
+        } else {
+            root.appendChild(doc.importNode(asset.second.xml, true));
+        }
+    }
+    QDataStream stream(&file);
+    stream << AssetCacheVersion << key << qint32(m_assets.size()) << doc.toString(-1);
+    for (const auto &asset : m_assets) {
+        const Info &info = asset.second;
+        stream << asset.first << info.id << info.mltId << info.name << info.description << info.author << info.version_str << info.version
+               << qint32(info.type);
+    }
+    file.commit();
 }
 
 template <typename AssetType> void AbstractAssetsRepository<AssetType>::parseAssetList(const QString &filePath, QSet<QString> &destination)
@@ -349,3 +493,12 @@ template <typename AssetType> QDomElement AbstractAssetsRepository<AssetType>::g
     }
     return m_assets.at(assetId).xml.cloneNode().toElement();
 }
+
+template <typename AssetType> std::shared_ptr<const AssetDescriptor> AbstractAssetsRepository<AssetType>::getDescriptor(const QString &assetId) const
+{
+    if (m_assets.count(assetId) == 0) {
+        qDebug() << "Error : Requesting descriptor of unknown asset " << assetId;
+        return nullptr;
+    }
+    return AssetDescriptor::shared(assetCacheName() + QLatin1Char('/') + assetId, m_assets.at(assetId).xml);
+}
@@ -28,10 +28,12 @@
 #include "rotoscoping/rotohelper.hpp"
 
 #include <QSize>
+#include <QMutexLocker>
 #include <QLineF>
 #include <QDebug>
 #include <QJsonDocument>
 #include <mlt++/Mlt.h>
+#include <algorithm>
 #include <utility>
 
 KeyframeModel::KeyframeModel(std::weak_ptr<AssetParameterModel> model, const QModelIndex &index, std::weak_ptr<DocUndoStack> undo_stack, QObject *parent)
@@ -373,6 +375,7 @@ Fun KeyframeModel::updateKeyframe_lambda(GenTime pos, KeyframeType type, const Q
         int row = static_cast<int>(std::distance(m_keyframeList.begin(), m_keyframeList.find(pos)));
         m_keyframeList[pos].first = type;
         m_keyframeList[pos].second = value;
+        invalidateCompiled();
         if (notify) emit dataChanged(index(row), index(row), {ValueRole, NormalizedValueRole, TypeRole});
         return true;
     };
@@ -393,6 +396,7 @@ Fun KeyframeModel::addKeyframe_lambda(GenTime pos, KeyframeType type, const QVar
         if (notify) beginInsertRows(QModelIndex(), insertionRow, insertionRow);
         m_keyframeList[pos].first = type;
         m_keyframeList[pos].second = value;
+        invalidateCompiled();
         if (notify) endInsertRows();
         return true;
     };
@@ -409,6 +413,7 @@ Fun KeyframeModel::deleteKeyframe_lambda(GenTime pos, bool notify)
         int row = static_cast<int>(std::distance(m_keyframeList.begin(), m_keyframeList.find(pos)));
         if (notify) beginRemoveRows(QModelIndex(), row, row);
         m_keyframeList.erase(pos);
+        invalidateCompiled();
         if (notify) endRemoveRows();
         qDebug() << "after" << getAnimProperty();
         return true;
@@ -909,6 +914,65 @@ QVariant KeyframeModel::getNormalizedValue(double newVal) const
     return QVariant();
 }
 
+void KeyframeModel::invalidateCompiled()
+{
+    QMutexLocker lock(&m_compiledMutex);
+    m_compiledValid = false;
+}
+
+void KeyframeModel::compileKeyframes() const
+{
+    double fps = pCore->getCurrentFps();
+    if (m_compiledValid && qFuzzyCompare(fps, m_compiledFps)) {
+        return;
+    }
+    m_compiled.clear();
+    m_compiled.reserve(m_keyframeList.size());
+    m_compiledFps = fps;
+    m_compiledUsable = m_paramType == ParamType::KeyframeParam || m_paramType == ParamType::AnimatedRect;
+    m_compiledOpacity = false;
+    if (m_paramType == ParamType::AnimatedRect) {
+        if (auto ptr = m_model.lock()) {
+            m_compiledOpacity = ptr->data(m_index, AssetParameterModel::OpacityRole).toBool();
+        }
+    }
+    QLocale locale;
+    for (const auto &keyframe : m_keyframeList) {
+        if (!m_compiledUsable) {
+            break;
+        }
+        CompiledKeyframe compiled{keyframe.first.frames(fps), keyframe.second.first, {0., 0., 0., 0., 1.}};
+        if (m_paramType == ParamType::AnimatedRect) {
+            // Rects are stored as "x y w h [opacity]", opacity uses the current locale
+            const QStringList vals = keyframe.second.second.toString().split(QLatin1Char(' '));
+            int ix = 0;
+            for (const QString &val : vals) {
+                if (val.isEmpty() || ix > 4) {
+                    continue;
+                }
+                bool ok;
+                double v = val.toDouble(&ok);
+                if (!ok) {
+                    v = locale.toDouble(val, &ok);
+                }
+                if (!ok) {
+                    // Percent values are resolved by MLT
+                    m_compiledUsable = false;
+                    break;
+                }
+                compiled.values[ix++] = v;
+            }
+            if (ix < 4) {
+                m_compiledUsable = false;
+            }
+        } else {
+            compiled.values[0] = keyframe.second.second.toDouble();
+        }
+        m_compiled.push_back(compiled);
+    }
+    m_compiledValid = true;
+}
+
 QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
 {
     if (m_keyframeList.count(pos) > 0) {
@@ -917,6 +981,56 @@ QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
     if (m_keyframeList.size() == 0) {
         return QVariant();
     }
+    if (m_paramType == ParamType::KeyframeParam || m_paramType == ParamType::AnimatedRect) {
+        QMutexLocker lock(&m_compiledMutex);
+        compileKeyframes();
+        if (m_compiledUsable && !m_compiled.empty()) {
+            // Same interpolation as MLT's animation, without parsing the animation string
+            int frame = pos.frames(m_compiledFps);
+            auto next = std::upper_bound(m_compiled.cbegin(), m_compiled.cend(), frame, [](int f, const CompiledKeyframe &k) { return f < k.frame; });
+            auto prev = next;
+            double values[5];
+            int count = m_paramType == ParamType::AnimatedRect ? 5 : 1;
+            if (next == m_compiled.cbegin() || next == m_compiled.cend()) {
+                prev = next == m_compiled.cbegin() ? next : next - 1;
+                std::copy(prev->values, prev->values + count, values);
+            } else {
+                --prev;
+                double t = double(frame - prev->frame) / (next->frame - prev->frame);
+                for (int i = 0; i < count; i++) {
+                    switch (prev->type) {
+                    case KeyframeType::Discrete:
+                        values[i] = prev->values[i];
+                        break;
+                    case KeyframeType::Curve: {
+                        // Catmull-Rom spline, using the surrounding keyframes
+                        double y0 = prev == m_compiled.cbegin() ? prev->values[i] : (prev - 1)->values[i];
+                        double y1 = prev->values[i];
+                        double y2 = next->values[i];
+                        double y3 = next + 1 == m_compiled.cend() ? next->values[i] : (next + 1)->values[i];
+                        double a0 = -0.5 * y0 + 1.5 * y1 - 1.5 * y2 + 0.5 * y3;
+                        double a1 = y0 - 2.5 * y1 + 2 * y2 - 0.5 * y3;
+                        double a2 = -0.5 * y0 + 0.5 * y2;
+                        values[i] = ((a0 * t + a1) * t + a2) * t + y1;
+                        break;
+                    }
+                    default:
+                        values[i] = prev->values[i] + (next->values[i] - prev->values[i]) * t;
+                        break;
+                    }
+                }
+            }
+            if (m_paramType == ParamType::KeyframeParam) {
+                return QVariant(values[0]);
+            }
+            QString res = QStringLiteral("%1 %2 %3 %4").arg((int)values[0]).arg((int)values[1]).arg((int)values[2]).arg((int)values[3]);
+            if (m_compiledOpacity) {
+                QLocale locale;
+                res.append(QStringLiteral(" %1").arg(locale.toString(values[4])));
+            }
+            return QVariant(res);
+        }
+    }
     Mlt::Properties mlt_prop;
     QString animData;
     int in = 0;
@@ -28,10 +28,12 @@
 #include "undohelper.hpp"
 
 #include <QAbstractListModel>
+#include <QMutex>
 #include <QReadWriteLock>
 
 #include <map>
 #include <memory>
+#include <vector>
 
 class AssetParameterModel;
 class DocUndoStack;
@@ -199,7 +201,19 @@ protected:
     void parseAnimProperty(const QString &prop);
     void parseRotoProperty(const QString &prop);
 
+    /** @brief Build m_compiled from the keyframe list, if it was modified since the last call. m_compiledMutex must be locked */
+    void compileKeyframes() const;
+    /** @brief Mark the compiled keyframes as outdated, must be called on each change of m_keyframeList */
+    void invalidateCompiled();
+
 private:
+    /** @brief A keyframe converted for interpolation: numeric params use one value, rects use x, y, w, h and opacity */
+    struct CompiledKeyframe
+    {
+        int frame;
+        KeyframeType type;
+        double values[5];
+    };
     std::weak_ptr<AssetParameterModel> m_model;
     std::weak_ptr<DocUndoStack> m_undoStack;
     QPersistentModelIndex m_index;
@@ -209,6 +223,15 @@ private:
 
     std::map<GenTime, std::pair<KeyframeType, QVariant>> m_keyframeList;
 
+    /** @brief Keyframes sorted by frame, used by getInterpolatedValue to avoid parsing the MLT animation on each call */
+    mutable std::vector<CompiledKeyframe> m_compiled;
+    mutable QMutex m_compiledMutex;
+    mutable bool m_compiledValid{false};
+    /** @brief False if some values cannot be compiled (like percent rects), MLT is then used for interpolation */
+    mutable bool m_compiledUsable{false};
+    mutable bool m_compiledOpacity{false};
+    mutable double m_compiledFps{0};
+
 signals:
     void modelChanged();
 
@@ -0,0 +1,145 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "assetdescriptor.hpp"
+#include "assetparametermodel.hpp"
+#include "klocalizedstring.h"
+#include <QLocale>
+#include <QMutex>
+#include <QMutexLocker>
+
+AssetDescriptor::AssetDescriptor(const QDomElement &assetXml)
+    : m_source(assetXml)
+{
+    m_hideKeyframesByDefault = assetXml.hasAttribute(QStringLiteral("hideKeyframes"));
+    m_isAudio = assetXml.attribute(QStringLiteral("type")) == QLatin1String("audio");
+
+    QDomElement xml = assetXml;
+    bool needsLocaleConversion = false;
+    QChar separator, oldSeparator;
+    // Check locale, default effects xml has no LC_NUMERIC defined and always uses the C locale
+    QLocale locale;
+    locale.setNumberOptions(QLocale::OmitGroupSeparator);
+    if (assetXml.hasAttribute(QStringLiteral("LC_NUMERIC"))) {
+        QLocale effectLocale = QLocale(assetXml.attribute(QStringLiteral("LC_NUMERIC")));
+        if (QLocale::c().decimalPoint() != effectLocale.decimalPoint()) {
+            needsLocaleConversion = true;
+            separator = QLocale::c().decimalPoint();
+            oldSeparator = effectLocale.decimalPoint();
+            // Work on a copy, the description belongs to the caller
+            xml = assetXml.cloneNode().toElement();
+        }
+    }
+
+    QDomNodeList nodeList = xml.elementsByTagName(QStringLiteral("parameter"));
+    m_parameters.reserve(nodeList.count());
+    for (int i = 0; i < nodeList.count(); ++i) {
+        QDomElement currentParameter = nodeList.item(i).toElement();
+
+        // Convert parameters if we need to
+        if (needsLocaleConversion) {
+            QDomNamedNodeMap attrs = currentParameter.attributes();
+            for (int k = 0; k < attrs.count(); ++k) {
+                QString nodeName = attrs.item(k).nodeName();
+                if (nodeName != QLatin1String("type") && nodeName != QLatin1String("name")) {
+                    QString val = attrs.item(k).nodeValue();
+                    if (val.contains(oldSeparator)) {
+                        QString newVal = val.replace(oldSeparator, separator);
+                        attrs.item(k).setNodeValue(newVal);
+                    }
+                }
+            }
+        }
+        Parameter param;
+        param.name = currentParameter.attribute(QStringLiteral("name"));
+        QString type = currentParameter.attribute(QStringLiteral("type"));
+        param.type = AssetParameterModel::paramTypeFromStr(type);
+        param.xml = currentParameter;
+        param.isFixed = (type == QLatin1String("fixed"));
+        param.ownerDefault = currentParameter.attribute(QStringLiteral("default")).contains(QLatin1Char('%'));
+        if (!param.ownerDefault) {
+            // Without keyword, the default value does not depend on the owner
+            QVariant defaultValue = AssetParameterModel::parseAttribute({ObjectType::NoItem, -1}, QStringLiteral("default"), currentParameter);
+            param.defaultValue = defaultValue.type() == QVariant::Double ? locale.toString(defaultValue.toDouble()) : defaultValue.toString();
+        }
+        if (!param.name.isEmpty()) {
+            m_paramOrder.push_back(param.name);
+        }
+        if (!param.isFixed) {
+            QString title = i18n(currentParameter.firstChildElement(QStringLiteral("name")).text().toUtf8().data());
+            param.title = title.isEmpty() ? param.name : title;
+            m_rowIndex.emplace(param.name, m_rows.size());
+            m_rows.push_back(m_parameters.size());
+        }
+        m_parameters.push_back(param);
+    }
+}
+
+// static
+std::shared_ptr<const AssetDescriptor> AssetDescriptor::shared(const QString &key, const QDomElement &assetXml)
+{
+    static QMutex mutex;
+    static std::unordered_map<QString, std::shared_ptr<const AssetDescriptor>> descriptors;
+    QMutexLocker lk(&mutex);
+    auto it = descriptors.find(key);
+    // QDomElement comparison checks that this is the same node, not a copy
+    if (it != descriptors.end() && it->second->m_source == assetXml) {
+        return it->second;
+    }
+    auto descriptor = std::make_shared<AssetDescriptor>(assetXml);
+    descriptors[key] = descriptor;
+    return descriptor;
+}
+
+const QVector<AssetDescriptor::Parameter> &AssetDescriptor::parameters() const
+{
+    return m_parameters;
+}
+
+int AssetDescriptor::rowCount() const
+{
+    return m_rows.size();
+}
+
+const AssetDescriptor::Parameter &AssetDescriptor::row(int row) const
+{
+    return m_parameters.at(m_rows.at(row));
+}
+
+int AssetDescriptor::rowOf(const QString &name) const
+{
+    auto it = m_rowIndex.find(name);
+    return it == m_rowIndex.end() ? -1 : it->second;
+}
+
+const QVector<QString> &AssetDescriptor::paramOrder() const
+{
+    return m_paramOrder;
+}
+
+bool AssetDescriptor::hideKeyframesByDefault() const
+{
+    return m_hideKeyframesByDefault;
+}
+
+bool AssetDescriptor::isAudio() const
+{
+    return m_isAudio;
+}
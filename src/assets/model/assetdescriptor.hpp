@@ -0,0 +1,89 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef ASSETDESCRIPTOR_H
+#define ASSETDESCRIPTOR_H
+
+#include "definitions.h"
+#include <QDomElement>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include <unordered_map>
+
+enum class ParamType;
+
+/* @brief This class holds the definition of the parameters of an asset, as parsed from its XML description.
+   It does not depend on a particular instance of the asset, so one descriptor is shared by all the AssetParameterModel of the same asset: these only
+   store the parameter values. A descriptor is immutable once built.
+ */
+class AssetDescriptor
+{
+public:
+    struct Parameter
+    {
+        QString name;
+        ParamType type;
+        // The parameter description, never modified since it is shared
+        QDomElement xml;
+        // Translated display name
+        QString title;
+        bool isFixed;
+        // Value used when the parameter has none. Only valid if ownerDefault is false, otherwise the default depends on the owner (%out...)
+        QString defaultValue;
+        bool ownerDefault;
+    };
+
+    /* @brief Parse the parameters of an asset
+       @param assetXml is the XML description of the asset. It is not modified
+     */
+    explicit AssetDescriptor(const QDomElement &assetXml);
+
+    /* @brief Returns the descriptor of an asset from a repository, parsing it on first use
+       @param key identifies the asset among all repositories
+       @param assetXml is the description stored in the repository. If it was replaced (reloaded custom effect...), a new descriptor is built
+     */
+    static std::shared_ptr<const AssetDescriptor> shared(const QString &key, const QDomElement &assetXml);
+
+    /* @brief Returns all parameters, in the order of the XML description */
+    const QVector<Parameter> &parameters() const;
+    /* @brief Returns the number of displayed (non fixed) parameters */
+    int rowCount() const;
+    /* @brief Returns the displayed parameter at given row */
+    const Parameter &row(int row) const;
+    /* @brief Returns the row of a displayed parameter, -1 if it doesn't exist or is fixed */
+    int rowOf(const QString &name) const;
+    /* @brief Returns the name of all named parameters (including fixed ones) in XML order. The order is important for some effects like sox */
+    const QVector<QString> &paramOrder() const;
+
+    bool hideKeyframesByDefault() const;
+    bool isAudio() const;
+
+private:
+    QDomElement m_source;
+    QVector<Parameter> m_parameters;
+    QVector<int> m_rows;
+    std::unordered_map<QString, int> m_rowIndex;
+    QVector<QString> m_paramOrder;
+    bool m_hideKeyframesByDefault;
+    bool m_isAudio;
+};
+
+#endif
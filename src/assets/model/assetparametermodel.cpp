@@ -34,65 +34,43 @@
 
 AssetParameterModel::AssetParameterModel(std::unique_ptr<Mlt::Properties> asset, const QDomElement &assetXml, const QString &assetId, ObjectId ownerId,
                                          QObject *parent)
+    : AssetParameterModel(std::move(asset), std::make_shared<AssetDescriptor>(assetXml), assetId, ownerId, QHash<QString, QString>(), parent)
+{
+}
+
+AssetParameterModel::AssetParameterModel(std::unique_ptr<Mlt::Properties> asset, std::shared_ptr<const AssetDescriptor> descriptor, const QString &assetId,
+                                         ObjectId ownerId, const QHash<QString, QString> &values, QObject *parent)
     : QAbstractListModel(parent)
     , monitorId(ownerId.first == ObjectType::BinClip ? Kdenlive::ClipMonitor : Kdenlive::ProjectMonitor)
     , m_assetId(assetId)
     , m_ownerId(ownerId)
+    , m_descriptor(std::move(descriptor))
+    , m_initialValues(values)
     , m_asset(std::move(asset))
     , m_keyframes(nullptr)
 {
     Q_ASSERT(m_asset->is_valid());
-    QDomNodeList nodeList = assetXml.elementsByTagName(QStringLiteral("parameter"));
-    m_hideKeyframesByDefault = assetXml.hasAttribute(QStringLiteral("hideKeyframes"));
-    m_isAudio = assetXml.attribute(QStringLiteral("type")) == QLatin1String("audio");
+    m_hideKeyframesByDefault = m_descriptor->hideKeyframesByDefault();
+    m_isAudio = m_descriptor->isAudio();
+    m_values.resize(m_descriptor->rowCount());
 
-    bool needsLocaleConversion = false;
-    QChar separator, oldSeparator;
-    // Check locale, default effects xml has no LC_NUMERIC defined and always uses the C locale
     QLocale locale;
     locale.setNumberOptions(QLocale::OmitGroupSeparator);
-    if (assetXml.hasAttribute(QStringLiteral("LC_NUMERIC"))) {
-        QLocale effectLocale = QLocale(assetXml.attribute(QStringLiteral("LC_NUMERIC")));
-        if (QLocale::c().decimalPoint() != effectLocale.decimalPoint()) {
-            needsLocaleConversion = true;
-            separator = QLocale::c().decimalPoint();
-            oldSeparator = effectLocale.decimalPoint();
-        }
-    }
-
-    qDebug() << "XML parsing of " << assetId << ". found : " << nodeList.count();
-    for (int i = 0; i < nodeList.count(); ++i) {
-        QDomElement currentParameter = nodeList.item(i).toElement();
-
-        // Convert parameters if we need to
-        if (needsLocaleConversion) {
-            QDomNamedNodeMap attrs = currentParameter.attributes();
-            for (int k = 0; k < attrs.count(); ++k) {
-                QString nodeName = attrs.item(k).nodeName();
-                if (nodeName != QLatin1String("type") && nodeName != QLatin1String("name")) {
-                    QString val = attrs.item(k).nodeValue();
-                    if (val.contains(oldSeparator)) {
-                        QString newVal = val.replace(oldSeparator, separator);
-                        attrs.item(k).setNodeValue(newVal);
-                    }
-                }
-            }
-        }
-        // Parse the basic attributes of the parameter
-        QString name = currentParameter.attribute(QStringLiteral("name"));
-        QString type = currentParameter.attribute(QStringLiteral("type"));
-        QString value = currentParameter.attribute(QStringLiteral("value"));
-        ParamRow currentRow;
-        currentRow.type = paramTypeFromStr(type);
-        currentRow.xml = currentParameter;
+    int row = 0;
+    for (const AssetDescriptor::Parameter &param : m_descriptor->parameters()) {
+        const QString &name = param.name;
+        QString value = m_initialValues.contains(name) ? m_initialValues.value(name) : param.xml.attribute(QStringLiteral("value"));
         if (value.isEmpty()) {
-            QVariant defaultValue = parseAttribute(m_ownerId, QStringLiteral("default"), currentParameter);
-            value = defaultValue.type() == QVariant::Double ? locale.toString(defaultValue.toDouble()) : defaultValue.toString();
+            if (param.ownerDefault) {
+                QVariant defaultValue = parseAttribute(m_ownerId, QStringLiteral("default"), param.xml);
+                value = defaultValue.type() == QVariant::Double ? locale.toString(defaultValue.toDouble()) : defaultValue.toString();
+            } else {
+                value = param.defaultValue;
+            }
         }
-        bool isFixed = (type == QLatin1String("fixed"));
-        if (isFixed) {
+        if (param.isFixed) {
             m_fixedParams[name] = value;
-        } else if (currentRow.type == ParamType::Position) {
+        } else if (param.type == ParamType::Position) {
             int val = value.toInt();
             if (val < 0) {
                 int in = pCore->getItemIn(m_ownerId);
@@ -100,48 +78,39 @@ AssetParameterModel::AssetParameterModel(std::unique_ptr<Mlt::Properties> asset,
                 val += out;
                 value = QString::number(val);
             }
-        } else if (currentRow.type == ParamType::KeyframeParam || currentRow.type == ParamType::AnimatedRect) {
+        } else if (param.type == ParamType::KeyframeParam || param.type == ParamType::AnimatedRect) {
             if (!value.contains(QLatin1Char('='))) {
                 value.prepend(QStringLiteral("%1=").arg(pCore->getItemIn(m_ownerId)));
             }
         }
         if (!name.isEmpty()) {
             internalSetParameter(name, value);
-            // Keep track of param order
-            m_paramOrder.push_back(name);
         }
-        if (isFixed) {
+        if (param.isFixed) {
             // fixed parameters are not displayed so we don't store them.
             continue;
         }
-        currentRow.value = value;
-        QString title = i18n(currentParameter.firstChildElement(QStringLiteral("name")).text().toUtf8().data());
-        currentRow.name = title.isEmpty() ? name : title;
-        m_params[name] = currentRow;
-        m_rows.push_back(name);
+        m_values[row++] = value;
     }
     if (m_assetId.startsWith(QStringLiteral("sox_"))) {
         // Sox effects need to have a special "Effect" value set
         QStringList effectParam = {m_assetId.section(QLatin1Char('_'), 1)};
-        for (const QString &pName : m_paramOrder) {
+        for (const QString &pName : m_descriptor->paramOrder()) {
             effectParam << m_asset->get(pName.toUtf8().constData());
         }
         m_asset->set("effect", effectParam.join(QLatin1Char(' ')).toUtf8().constData());
     }
-    qDebug() << "END parsing of " << assetId << ". Number of found parameters" << m_rows.size();
     emit modelChanged();
 }
 
 void AssetParameterModel::prepareKeyframes()
 {
     if (m_keyframes) return;
-    int ix = 0;
-    for (const auto &name : m_rows) {
-        if (m_params.at(name).type == ParamType::KeyframeParam || m_params.at(name).type == ParamType::AnimatedRect ||
-            m_params.at(name).type == ParamType::Roto_spline) {
+    for (int ix = 0; ix < m_descriptor->rowCount(); ++ix) {
+        ParamType type = m_descriptor->row(ix).type;
+        if (type == ParamType::KeyframeParam || type == ParamType::AnimatedRect || type == ParamType::Roto_spline) {
             addKeyframeParam(index(ix, 0));
         }
-        ix++;
     }
     if (m_keyframes) {
         // Make sure we have keyframes at same position for all parameters
@@ -152,13 +121,11 @@ void AssetParameterModel::prepareKeyframes()
 QStringList AssetParameterModel::getKeyframableParameters() const
 {
     QStringList paramNames;
-    int ix = 0;
-    for (const auto &name : m_rows) {
-        if (m_params.at(name).type == ParamType::KeyframeParam || m_params.at(name).type == ParamType::AnimatedRect) {
-            //addKeyframeParam(index(ix, 0));
-            paramNames << name;
+    for (int ix = 0; ix < m_descriptor->rowCount(); ++ix) {
+        const AssetDescriptor::Parameter &param = m_descriptor->row(ix);
+        if (param.type == ParamType::KeyframeParam || param.type == ParamType::AnimatedRect) {
+            paramNames << param.name;
         }
-        ix++;
     }
     return paramNames;
 }
@@ -167,16 +134,12 @@ void AssetParameterModel::setParameter(const QString &name, int value, bool upda
 {
     Q_ASSERT(m_asset->is_valid());
     m_asset->set(name.toLatin1().constData(), value);
-    if (m_fixedParams.count(name) == 0) {
-        m_params[name].value = value;
-    } else {
-        m_fixedParams[name] = value;
-    }
+    storeValue(name, value);
     if (m_assetId.startsWith(QStringLiteral("sox_"))) {
         // Warning, SOX effect, need unplug/replug
         qDebug() << "// Warning, SOX effect, need unplug/replug";
         QStringList effectParam = {m_assetId.section(QLatin1Char('_'), 1)};
-        for (const QString &pName : m_paramOrder) {
+        for (const QString &pName : m_descriptor->paramOrder()) {
             effectParam << m_asset->get(pName.toUtf8().constData());
         }
         m_asset->set("effect", effectParam.join(QLatin1Char(' ')).toUtf8().constData());
@@ -187,7 +150,7 @@ void AssetParameterModel::setParameter(const QString &name, int value, bool upda
     }
     if (update) {
         emit modelChanged();
-        emit dataChanged(index(0, 0), index(m_rows.count() - 1, 0), {});
+        emit dataChanged(index(0, 0), index(m_descriptor->rowCount() - 1, 0), {});
         // Update fades in timeline
         pCore->updateItemModel(m_ownerId, m_assetId);
         if (!m_isAudio) {
@@ -213,7 +176,7 @@ void AssetParameterModel::internalSetParameter(const QString &name, const QStrin
 #endif
         int points = vals.size();
         m_asset->set("3", points / 10.);
-        m_params[QStringLiteral("3")].value = points / 10.;
+        storeValue(QStringLiteral("3"), points / 10.);
         // for the curve, inpoints are numbered: 6, 8, 10, 12, 14
         // outpoints, 7, 9, 11, 13,15 so we need to deduce these enums
         for (int i = 0; i < points; i++) {
@@ -222,12 +185,12 @@ void AssetParameterModel::internalSetParameter(const QString &name, const QStrin
             QString pName = QString::number(idx);
             double val = pointVal.section(QLatin1Char('/'), 0, 0).toDouble();
             m_asset->set(pName.toLatin1().constData(), val);
-            m_params[pName].value = val;
+            storeValue(pName, val);
             idx++;
             pName = QString::number(idx);
             val = pointVal.section(QLatin1Char('/'), 1, 1).toDouble();
             m_asset->set(pName.toLatin1().constData(), val);
-            m_params[pName].value = val;
+            storeValue(pName, val);
         }
     }
     bool conversionSuccess = true;
@@ -240,25 +203,17 @@ void AssetParameterModel::internalSetParameter(const QString &name, const QStrin
     }
     if (conversionSuccess) {
         m_asset->set(name.toLatin1().constData(), doubleValue);
-        if (m_fixedParams.count(name) == 0) {
-            m_params[name].value = doubleValue;
-        } else {
-            m_fixedParams[name] = doubleValue;
-        }
+        storeValue(name, doubleValue);
     } else {
         m_asset->set(name.toLatin1().constData(), paramValue.toUtf8().constData());
         qDebug() << " = = SET EFFECT PARAM: " << name << " = " << paramValue;
-        if (m_fixedParams.count(name) == 0) {
-            m_params[name].value = paramValue;
-            if (m_keyframes) {
-                KeyframeModel *km = m_keyframes->getKeyModel(paramIndex);
-                if (km) {
-                    km->refresh();
-                }
-                //m_keyframes->refresh();
+        storeValue(name, paramValue);
+        if (m_fixedParams.count(name) == 0 && m_keyframes) {
+            KeyframeModel *km = m_keyframes->getKeyModel(paramIndex);
+            if (km) {
+                km->refresh();
             }
-        } else {
-            m_fixedParams[name] = paramValue;
+            //m_keyframes->refresh();
         }
     }
 }
@@ -271,7 +226,7 @@ void AssetParameterModel::setParameter(const QString &name, const QString &param
     if (m_assetId.startsWith(QStringLiteral("sox_"))) {
         // Warning, SOX effect, need unplug/replug
         QStringList effectParam = {m_assetId.section(QLatin1Char('_'), 1)};
-        for (const QString &pName : m_paramOrder) {
+        for (const QString &pName : m_descriptor->paramOrder()) {
             effectParam << m_asset->get(pName.toUtf8().constData());
         }
         m_asset->set("effect", effectParam.join(QLatin1Char(' ')).toUtf8().constData());
@@ -286,7 +241,7 @@ void AssetParameterModel::setParameter(const QString &name, const QString &param
         if (paramIndex.isValid()) {
             emit dataChanged(paramIndex, paramIndex);
         } else {
-            QModelIndex ix = index(m_rows.indexOf(name), 0);
+            QModelIndex ix = index(m_descriptor->rowOf(name), 0);
             emit dataChanged(ix, ix);
         }
         emit modelChanged();
@@ -312,22 +267,36 @@ void AssetParameterModel::setParameter(const QString &name, const QString &param
 
 AssetParameterModel::~AssetParameterModel() = default;
 
+void AssetParameterModel::storeValue(const QString &name, const QVariant &value)
+{
+    if (m_fixedParams.count(name) > 0) {
+        m_fixedParams[name] = value;
+        return;
+    }
+    int row = m_descriptor->rowOf(name);
+    if (row >= 0) {
+        m_values[row] = value;
+    } else {
+        m_extraParams[name] = value;
+    }
+}
+
 QVariant AssetParameterModel::data(const QModelIndex &index, int role) const
 {
-    if (index.row() < 0 || index.row() >= m_rows.size() || !index.isValid()) {
+    if (index.row() < 0 || index.row() >= m_descriptor->rowCount() || !index.isValid()) {
         return QVariant();
     }
-    QString paramName = m_rows[index.row()];
-    Q_ASSERT(m_params.count(paramName) > 0);
-    const QDomElement &element = m_params.at(paramName).xml;
+    const AssetDescriptor::Parameter &param = m_descriptor->row(index.row());
+    const QString &paramName = param.name;
+    const QDomElement &element = param.xml;
     switch (role) {
     case Qt::DisplayRole:
     case Qt::EditRole:
-        return m_params.at(paramName).name;
+        return param.title;
     case NameRole:
         return paramName;
     case TypeRole:
-        return QVariant::fromValue<ParamType>(m_params.at(paramName).type);
+        return QVariant::fromValue<ParamType>(param.type);
     case CommentRole: {
         QDomElement commentElem = element.firstChildElement(QStringLiteral("comment"));
         QString comment;
@@ -375,7 +344,7 @@ QVariant AssetParameterModel::data(const QModelIndex &index, int role) const
         if (child.toElement().hasAttribute(QStringLiteral("conditional"))) {
             return child.toElement().attribute(QStringLiteral("conditional"));
         }
-        return m_params.at(paramName).name;
+        return param.title;
     }
     case SuffixRole:
         return element.attribute(QStringLiteral("suffix"));
@@ -389,9 +358,11 @@ QVariant AssetParameterModel::data(const QModelIndex &index, int role) const
         return element.attribute(QStringLiteral("alpha")) == QLatin1String("1");
     case ValueRole: {
         QString value(m_asset->get(paramName.toUtf8().constData()));
-        return value.isEmpty() ? (element.attribute(QStringLiteral("value")).isNull() ? parseAttribute(m_ownerId, QStringLiteral("default"), element)
-                                                                                      : element.attribute(QStringLiteral("value")))
-                               : value;
+        if (!value.isEmpty()) {
+            return value;
+        }
+        QString initialValue = m_initialValues.contains(paramName) ? m_initialValues.value(paramName) : element.attribute(QStringLiteral("value"));
+        return initialValue.isNull() ? parseAttribute(m_ownerId, QStringLiteral("default"), element) : initialValue;
     }
     case ListValuesRole:
         return element.attribute(QStringLiteral("paramlist")).split(QLatin1Char(';'));
@@ -439,9 +410,9 @@ QVariant AssetParameterModel::data(const QModelIndex &index, int role) const
 
 int AssetParameterModel::rowCount(const QModelIndex &parent) const
 {
-    qDebug() << "===================================================== Requested rowCount" << parent << m_rows.size();
+    qDebug() << "===================================================== Requested rowCount" << parent << m_descriptor->rowCount();
     if (parent.isValid()) return 0;
-    return m_rows.size();
+    return m_descriptor->rowCount();
 }
 
 // static
@@ -601,19 +572,29 @@ QString AssetParameterModel::getAssetId() const
     return m_assetId;
 }
 
+std::shared_ptr<const AssetDescriptor> AssetParameterModel::getDescriptor() const
+{
+    return m_descriptor;
+}
+
 QVector<QPair<QString, QVariant>> AssetParameterModel::getAllParameters() const
 {
     QVector<QPair<QString, QVariant>> res;
-    res.reserve((int)m_fixedParams.size() + (int)m_params.size());
+    res.reserve((int)m_fixedParams.size() + m_values.size() + (int)m_extraParams.size());
     for (const auto &fixed : m_fixedParams) {
         res.push_back(QPair<QString, QVariant>(fixed.first, fixed.second));
     }
 
-    for (const auto &param : m_params) {
-        if (!param.first.isEmpty()) {
-            res.push_back(QPair<QString, QVariant>(param.first, param.second.value));
+    for (int row = 0; row < m_values.size(); ++row) {
+        const QString &name = m_descriptor->row(row).name;
+        // Parameters with the same name share their value, only list them once
+        if (!name.isEmpty() && m_descriptor->rowOf(name) == row) {
+            res.push_back(QPair<QString, QVariant>(name, m_values.at(row)));
         }
     }
+    for (const auto &extra : m_extraParams) {
+        res.push_back(QPair<QString, QVariant>(extra.first, extra.second));
+    }
     return res;
 }
 
@@ -623,7 +604,7 @@ QJsonDocument AssetParameterModel::toJson(bool includeFixed) const
     if (includeFixed) {
         for (const auto &fixed : m_fixedParams) {
             QJsonObject currentParam;
-            QModelIndex ix = index(m_rows.indexOf(fixed.first), 0);
+            QModelIndex ix = index(m_descriptor->rowOf(fixed.first), 0);
             currentParam.insert(QLatin1String("name"), QJsonValue(fixed.first));
             currentParam.insert(QLatin1String("value"), fixed.second.type() == QVariant::Double ? QJsonValue(fixed.second.toDouble()) : QJsonValue(fixed.second.toString()));
             int type = data(ix, AssetParameterModel::TypeRole).toInt();
@@ -645,14 +626,19 @@ QJsonDocument AssetParameterModel::toJson(bool includeFixed) const
         }
     }
 
-    for (const auto &param : m_params) {
-        if (!includeFixed && param.second.type != ParamType::KeyframeParam && param.second.type != ParamType::AnimatedRect) {
+    for (int row = 0; row < m_values.size(); ++row) {
+        const AssetDescriptor::Parameter &param = m_descriptor->row(row);
+        if (m_descriptor->rowOf(param.name) != row) {
+            continue;
+        }
+        if (!includeFixed && param.type != ParamType::KeyframeParam && param.type != ParamType::AnimatedRect) {
             continue;
         }
+        const QVariant &value = m_values.at(row);
         QJsonObject currentParam;
-        QModelIndex ix = index(m_rows.indexOf(param.first), 0);
-        currentParam.insert(QLatin1String("name"), QJsonValue(param.first));
-        currentParam.insert(QLatin1String("value"), param.second.value.type() == QVariant::Double ? QJsonValue(param.second.value.toDouble()) : QJsonValue(param.second.value.toString()));
+        QModelIndex ix = index(row, 0);
+        currentParam.insert(QLatin1String("name"), QJsonValue(param.name));
+        currentParam.insert(QLatin1String("value"), value.type() == QVariant::Double ? QJsonValue(value.toDouble()) : QJsonValue(value.toString()));
         int type = data(ix, AssetParameterModel::TypeRole).toInt();
         double min = data(ix, AssetParameterModel::MinRole).toDouble();
         double max = data(ix, AssetParameterModel::MaxRole).toDouble();
@@ -854,7 +840,7 @@ void AssetParameterModel::setParameters(const QVector<QPair<QString, QVariant>>
     if (!update) {
         m_ownerId.first = itemId;
     }
-    emit dataChanged(index(0), index(m_rows.count()), {});
+    emit dataChanged(index(0), index(m_descriptor->rowCount()), {});
 }
 
 ObjectId AssetParameterModel::getOwnerId() const
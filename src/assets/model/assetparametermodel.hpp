@@ -22,10 +22,12 @@
 #ifndef ASSETPARAMETERMODEL_H
 #define ASSETPARAMETERMODEL_H
 
+#include "assetdescriptor.hpp"
 #include "definitions.h"
 #include "klocalizedstring.h"
 #include <QAbstractListModel>
 #include <QDomElement>
+#include <QHash>
 #include <QJsonDocument>
 #include <unordered_map>
 
@@ -37,6 +39,7 @@ class KeyframeModelList;
    The behaviour of a transition or an effect is typically  controlled by several parameters. This class exposes this parameters as a list that can be rendered
    using the relevant widgets.
    Note that internally parameters are not sorted in any ways, because some effects like sox need a precise order
+   The parameter definitions come from an AssetDescriptor that is shared by all instances of the asset, this class only stores the values.
 
  */
 
@@ -73,6 +76,11 @@ class AssetParameterModel : public QAbstractListModel, public enable_shared_from
 public:
     explicit AssetParameterModel(std::unique_ptr<Mlt::Properties> asset, const QDomElement &assetXml, const QString &assetId, ObjectId ownerId,
                                  QObject *parent = nullptr);
+    /* @brief Build the model of an asset from its shared descriptor
+       @param values overrides the initial value of the given parameters, otherwise the value defined in the descriptor is used
+     */
+    explicit AssetParameterModel(std::unique_ptr<Mlt::Properties> asset, std::shared_ptr<const AssetDescriptor> descriptor, const QString &assetId,
+                                 ObjectId ownerId, const QHash<QString, QString> &values = QHash<QString, QString>(), QObject *parent = nullptr);
     ~AssetParameterModel() override;
     enum DataRoles {
         NameRole = Qt::UserRole + 1,
@@ -128,6 +136,9 @@ public:
     /* @brief Returns the id of the asset represented by this object */
     QString getAssetId() const;
 
+    /* @brief Returns the parameter definitions of this asset */
+    std::shared_ptr<const AssetDescriptor> getDescriptor() const;
+
     /* @brief Set the parameter with given name to the given value
      */
     Q_INVOKABLE void setParameter(const QString &name, const QString &paramValue, bool update = true, const QModelIndex &paramIndex = QModelIndex());
@@ -173,6 +184,7 @@ public:
     QStringList getKeyframableParameters() const;
 
 protected:
+    friend class AssetDescriptor;
     /* @brief Helper function to retrieve the type of a parameter given the string corresponding to it*/
     static ParamType paramTypeFromStr(const QString &type);
 
@@ -191,20 +203,16 @@ protected:
     */
     void addKeyframeParam(const QModelIndex &index);
 
-    struct ParamRow
-    {
-        ParamType type;
-        QDomElement xml;
-        QVariant value;
-        QString name;
-    };
+    /* @brief Store the value of a parameter in the row, fixed or extra parameters */
+    void storeValue(const QString &name, const QVariant &value);
 
     QString m_assetId;
     ObjectId m_ownerId;
-    std::vector<QString> m_paramOrder;                   // Keep track of parameter order, important for sox
-    std::unordered_map<QString, ParamRow> m_params;      // Store all parameters by name
+    std::shared_ptr<const AssetDescriptor> m_descriptor; // Parameter definitions, shared by all instances of the asset
+    QVector<QVariant> m_values;                          // Values of the displayed parameters, by row
     std::unordered_map<QString, QVariant> m_fixedParams; // We store values of fixed parameters aside
-    QVector<QString> m_rows;                             // We store the params name in order of parsing. The order is important (cf some effects like sox)
+    std::unordered_map<QString, QVariant> m_extraParams; // Values set for parameters that are not described (curve points)
+    QHash<QString, QString> m_initialValues;             // Initial values that replace the ones of the descriptor
 
     std::unique_ptr<Mlt::Properties> m_asset;
 
@@ -33,6 +33,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "jobs/thumbjob.hpp"
 #include "jobs/cachejob.hpp"
 #include "kdenlivesettings.h"
+#include "lib/audio/audioPeaks.h"
 #include "lib/audio/audioStreamInfo.h"
 #include "mltcontroller/clipcontroller.h"
 #include "mltcontroller/clippropertiescontroller.h"
@@ -46,7 +47,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "timecode.h"
 #include "timeline2/model/snapmodel.hpp"
 
+#include "utils/mediaprobecache.hpp"
 #include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailproducerpool.hpp"
 #include "xml/xml.hpp"
 #include <QPainter>
 #include <jobs/proxyclipjob.h>
@@ -169,6 +172,7 @@ ProjectClip::~ProjectClip()
     m_requestedThumbs.clear();
     m_thumbMutex.unlock();
     m_thumbThread.waitForFinished();
+    ThumbnailProducerPool::get()->invalidateClip(clipId());
 }
 
 void ProjectClip::connectEffectStack()
@@ -320,6 +324,7 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool audioStreamChanged, bool
         ThumbnailCache::get()->invalidateThumbsForClip(clipId(), false);
         pCore->jobManager()->discardJobs(clipId(), AbstractClipJob::THUMBJOB);
         m_thumbsProducer.reset();
+        ThumbnailProducerPool::get()->invalidateClip(clipId());
         pCore->jobManager()->startJob<ThumbJob>({clipId()}, loadjobId, QString(), -1, true, true);
     } else {
         // If another load job is running?
@@ -334,6 +339,7 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool audioStreamChanged, bool
         if (!xml.isNull()) {
             pCore->jobManager()->discardJobs(clipId(), AbstractClipJob::THUMBJOB);
             m_thumbsProducer.reset();
+            ThumbnailProducerPool::get()->invalidateClip(clipId());
             ClipType::ProducerType type = clipType();
             if (type != ClipType::Color && type != ClipType::Image && type != ClipType::SlideShow) {
                 xml.removeAttribute("out");
@@ -419,6 +425,7 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool repl
     QMutexLocker locker(&m_producerMutex);
     updateProducer(producer);
     m_thumbsProducer.reset();
+    ThumbnailProducerPool::get()->invalidateClip(clipId());
     connectEffectStack();
 
     // Update info
@@ -530,36 +537,59 @@ std::shared_ptr<Mlt::Producer> ProjectClip::thumbProducer()
         return nullptr;
     }
     QMutexLocker lock(&m_thumbMutex);
+    if (!m_thumbsProducer) {
+        m_thumbsProducer = buildThumbProducer();
+    }
+    return m_thumbsProducer;
+}
+
+std::shared_ptr<Mlt::Producer> ProjectClip::createThumbProducer(bool fast)
+{
+    if (clipType() == ClipType::Unknown) {
+        return nullptr;
+    }
+    QMutexLocker lock(&m_thumbMutex);
+    return buildThumbProducer(fast);
+}
+
+std::shared_ptr<Mlt::Producer> ProjectClip::buildThumbProducer(bool fast)
+{
     std::shared_ptr<Mlt::Producer> prod = originalProducer();
     if (!prod->is_valid()) {
         return nullptr;
     }
+    std::shared_ptr<Mlt::Producer> thumbProducer;
     if (KdenliveSettings::gpu_accel()) {
         // TODO: when the original producer changes, we must reload this thumb producer
-        m_thumbsProducer = softClone(ClipController::getPassPropertiesList());
+        thumbProducer = softClone(ClipController::getPassPropertiesList());
     } else {
         QString mltService = m_masterProducer->get("mlt_service");
         const QString mltResource = m_masterProducer->get("resource");
         if (mltService == QLatin1String("avformat")) {
             mltService = QStringLiteral("avformat-novalidate");
         }
-        m_thumbsProducer.reset(new Mlt::Producer(*pCore->thumbProfile(), mltService.toUtf8().constData(), mltResource.toUtf8().constData()));
-        if (m_thumbsProducer->is_valid()) {
+        thumbProducer.reset(new Mlt::Producer(*pCore->thumbProfile(), mltService.toUtf8().constData(), mltResource.toUtf8().constData()));
+        if (thumbProducer->is_valid()) {
             Mlt::Properties original(m_masterProducer->get_properties());
-            Mlt::Properties cloneProps(m_thumbsProducer->get_properties());
+            Mlt::Properties cloneProps(thumbProducer->get_properties());
             cloneProps.pass_list(original, ClipController::getPassPropertiesList());
             Mlt::Filter scaler(*pCore->thumbProfile(), "swscale");
             Mlt::Filter padder(*pCore->thumbProfile(), "resize");
             Mlt::Filter converter(*pCore->thumbProfile(), "avcolor_space");
-            m_thumbsProducer->set("audio_index", -1);
+            thumbProducer->set("audio_index", -1);
+            if (fast && mltService == QLatin1String("avformat-novalidate")) {
+                // Passed to the decoder when it is opened
+                thumbProducer->set("skip_frame", "nokey");
+                thumbProducer->set("skip_loop_filter", "all");
+            }
             // Required to make get_playtime() return > 1
-            m_thumbsProducer->set("out", m_thumbsProducer->get_length() -1);
-            m_thumbsProducer->attach(scaler);
-            m_thumbsProducer->attach(padder);
-            m_thumbsProducer->attach(converter);
+            thumbProducer->set("out", thumbProducer->get_length() -1);
+            thumbProducer->attach(scaler);
+            thumbProducer->attach(padder);
+            thumbProducer->attach(converter);
         }
     }
-    return m_thumbsProducer;
+    return thumbProducer;
 }
 
 void ProjectClip::createDisabledMasterProducer()
@@ -921,27 +951,17 @@ const QString ProjectClip::getFileHash()
         fileData = getProducerProperty(QStringLiteral("resource")).toUtf8();
         fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
         break;
-    default:
-        QFile file(clipUrl());
-        if (file.open(QIODevice::ReadOnly)) { // write size and hash only if resource points to a file
-            /*
-             * 1 MB = 1 second per 450 files (or faster)
-             * 10 MB = 9 seconds per 450 files (or faster)
-             */
-            if (file.size() > 2000000) {
-                fileData = file.read(1000000);
-                if (file.seek(file.size() - 1000000)) {
-                    fileData.append(file.readAll());
-                }
-            } else {
-                fileData = file.readAll();
-            }
-            file.close();
-            ClipController::setProducerProperty(QStringLiteral("kdenlive:file_size"), QString::number(file.size()));
-            fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
+    default: {
+        // Only read the file if it changed since it was last hashed
+        qint64 fileSize = 0;
+        const QString cachedHash = MediaProbeCache::get()->fileHash(clipUrl(), &fileSize);
+        if (!cachedHash.isEmpty()) { // write size and hash only if resource points to a file
+            ClipController::setProducerProperty(QStringLiteral("kdenlive:file_size"), QString::number(fileSize));
+            fileHash = QByteArray::fromHex(cachedHash.toLatin1());
         }
         break;
     }
+    }
     if (fileHash.isEmpty()) {
         qDebug() << "// WARNING EMPTY CLIP HASH: ";
         return QString();
@@ -1306,10 +1326,25 @@ const QString ProjectClip::getAudioThumbPath(int stream, bool miniThumb)
         return audioPath;
     }
     int roundedFps = (int)pCore->getCurrentFps();
-    audioPath.append(QStringLiteral("_%1_audio.png").arg(roundedFps));
+    audioPath.append(QStringLiteral("_%1_audio.peaks").arg(roundedFps));
     return audioPath;
 }
 
+const QString ProjectClip::getAudioEnvelopePath(int stream)
+{
+    if (audioInfo() == nullptr) {
+        return QString();
+    }
+    bool ok = false;
+    QDir thumbFolder = pCore->currentDoc()->getCacheDir(CacheAudio, &ok);
+    const QString clipHash = hash();
+    if (!ok || clipHash.isEmpty()) {
+        return QString();
+    }
+    // The envelope has one entry per frame, so it depends on the project fps
+    return thumbFolder.absoluteFilePath(QStringLiteral("%1_%2_%3_envelope.data").arg(clipHash).arg(stream).arg(pCore->getCurrentFps()));
+}
+
 QStringList ProjectClip::updatedAnalysisData(const QString &name, const QString &data, int offset)
 {
     if (data.isEmpty()) {
@@ -1538,32 +1573,21 @@ void ProjectClip::setRating(uint rating)
     pCore->currentDoc()->setModified(true);
 }
 
-QVector <uint8_t> ProjectClip::audioFrameCache(int stream)
+std::shared_ptr<AudioPeaks> ProjectClip::audioPeaks(int stream)
 {
-    QVector <uint8_t> audioLevels;
     if (stream == -1) {
         if (m_audioInfo) {
             stream = m_audioInfo->ffmpeg_audio_index();
         } else {
-            return audioLevels;
+            return nullptr;
         }
     }
-    // convert cached image
-    const QString cachePath = getAudioThumbPath(stream);
-    // checking for cached thumbs
-    QImage image(cachePath);
-    if (!image.isNull()) {
-        int channels = m_audioInfo->channels();
-        int n = image.width() * image.height();
-        for (int i = 0; i < n; i++) {
-            QRgb p = image.pixel(i / channels, i % channels);
-            audioLevels << (uint8_t)qRed(p);
-            audioLevels << (uint8_t)qGreen(p);
-            audioLevels << (uint8_t)qBlue(p);
-            audioLevels << (uint8_t)qAlpha(p);
-        }
+    // The peak file is memory mapped, nothing is decoded here
+    auto peaks = std::make_shared<AudioPeaks>();
+    if (!peaks->open(getAudioThumbPath(stream))) {
+        return nullptr;
     }
-    return audioLevels;
+    return peaks;
 }
 
 void ProjectClip::setClipStatus(AbstractProjectItem::CLIPSTATUS status)
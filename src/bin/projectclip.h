@@ -32,6 +32,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMutex>
 #include <memory>
 
+class AudioPeaks;
 class ClipPropertiesController;
 class ProjectFolder;
 class ProjectSubClip;
@@ -151,6 +152,10 @@ public:
 
     /** @brief Returns this clip's producer. */
     std::shared_ptr<Mlt::Producer> thumbProducer() override;
+    /** @brief Returns a new producer for thumbnails, that is not shared with other callers.
+     *  @param fast if true, the decoder only outputs keyframes and skips the loop filter, so seeking to a frame returns the next keyframe.
+     *  This makes thumbnails of long GOP footage much cheaper, at the cost of frame accuracy. */
+    std::shared_ptr<Mlt::Producer> createThumbProducer(bool fast = false);
 
     /** @brief Recursively disable/enable bin effects. */
     void setBinEffectsEnabled(bool enabled) override;
@@ -188,6 +193,8 @@ public:
     void discardAudioThumb();
     /** @brief Get path for this clip's audio thumbnail */
     const QString getAudioThumbPath(int stream, bool miniThumb = false);
+    /** @brief Get path for the audio envelope of a stream, used for audio alignment */
+    const QString getAudioEnvelopePath(int stream);
     /** @brief Returns true if this producer has audio and can be splitted on timeline*/
     bool isSplittable() const;
 
@@ -223,9 +230,9 @@ public:
     /** @brief Display Bin thumbnail given a percent
      */
     void getThumbFromPercent(int percent);
-    /** @brief Return audio cache for a stream
+    /** @brief Return the memory mapped audio peaks for a stream, or nullptr if they were not computed yet
      */
-    QVector <uint8_t> audioFrameCache(int stream = -1);
+    std::shared_ptr<AudioPeaks> audioPeaks(int stream = -1);
     /** @brief Return FFmpeg's audio stream index for an MLT audio stream index
      */
     int getAudioStreamFfmpegIndex(int mltStream);
@@ -270,6 +277,8 @@ private:
     const QString getFileHash();
     QMutex m_producerMutex;
     QMutex m_thumbMutex;
+    /** @brief Creates a thumbnail producer, m_thumbMutex must be locked. */
+    std::shared_ptr<Mlt::Producer> buildThumbProducer(bool fast = false);
     QFuture<void> m_thumbThread;
     QList<int> m_requestedThumbs;
     const QString geometryWithOffset(const QString &data, int offset);
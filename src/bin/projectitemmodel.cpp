@@ -39,6 +39,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "projectclip.h"
 #include "projectfolder.h"
 #include "projectsubclip.h"
+#include "utils/mediaprobecache.hpp"
 #include "xml/xml.hpp"
 
 #include <KLocalizedString>
@@ -390,19 +391,19 @@ std::shared_ptr<ProjectClip> ProjectItemModel::getClipByBinID(const QString &bin
     return nullptr;
 }
 
-const QVector<uint8_t> ProjectItemModel::getAudioLevelsByBinID(const QString &binId, int stream)
+std::shared_ptr<AudioPeaks> ProjectItemModel::getAudioPeaksByBinID(const QString &binId, int stream)
 {
     READ_LOCK();
     if (binId.contains(QLatin1Char('_'))) {
-        return getAudioLevelsByBinID(binId.section(QLatin1Char('_'), 0, 0), stream);
+        return getAudioPeaksByBinID(binId.section(QLatin1Char('_'), 0, 0), stream);
     }
     for (const auto &clip : m_allItems) {
         auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
         if (c->itemType() == AbstractProjectItem::ClipItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectClip>(c)->audioFrameCache(stream);
+            return std::static_pointer_cast<ProjectClip>(c)->audioPeaks(stream);
         }
     }
-    return QVector<uint8_t>();
+    return nullptr;
 }
 
 bool ProjectItemModel::hasClip(const QString &binId)
@@ -1018,6 +1019,13 @@ void ProjectItemModel::loadBinPlaylist(Mlt::Tractor *documentTractor, Mlt::Tract
                     parentId = QStringLiteral("-1");
                 }
                 i.value()->set("_kdenlive_processed", 1);
+                const QString resource = QString::fromUtf8(i.value()->get("resource"));
+                if (i.value()->get_int("_probecached") == 1) {
+                    MediaProbeCache::get()->revalidate(newId, resource);
+                } else if (qstrcmp(i.value()->get("mlt_service"), "avformat") == 0 && KdenliveSettings::mediaprobecache()) {
+                    // The avformat producer probed the file, but the project may override its length and stream indexes
+                    MediaProbeCache::get()->store(resource, i.value().get(), true);
+                }
                 requestAddBinClip(newId, std::move(i.value()), parentId, undo, redo);
                 binIdCorresp[QString::number(i.key())] = newId;
                 qDebug() << "Loaded clip " << i.key() << "under id" << newId;
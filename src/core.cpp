@@ -29,6 +29,7 @@ the Free Software Foundation, either version 3 of the License, or
 #include "timeline2/model/timelineitemmodel.hpp"
 #include "timeline2/view/timelinecontroller.h"
 #include "timeline2/view/timelinewidget.h"
+#include "utils/startuptimer.hpp"
 
 #include <mlt++/MltRepository.h>
 
@@ -100,9 +101,11 @@ void Core::build(bool isAppImage, const QString &MltPath)
         // Open connection with Mlt
         MltConnection::construct(MltPath);
     }
+    StartupTimer::mark(QStringLiteral("MLT"));
 
     // load the profile from disk
     ProfileRepository::get()->refresh();
+    StartupTimer::mark(QStringLiteral("Profiles"));
     // load default profile
     m_self->m_profile = KdenliveSettings::default_profile();
     if (m_self->m_profile.isEmpty()) {
@@ -118,6 +121,7 @@ void Core::build(bool isAppImage, const QString &MltPath)
     m_self->m_projectItemModel = ProjectItemModel::construct();
     // Job manager must be created before bin to correctly connect
     m_self->m_jobManager.reset(new JobManager(m_self.get()));
+    StartupTimer::mark(QStringLiteral("Core"));
 }
 
 void Core::initGUI(const QUrl &Url, const QString &clipsToLoad)
@@ -200,7 +204,9 @@ void Core::initGUI(const QUrl &Url, const QString &clipsToLoad)
     // TODO
     connect(m_producerQueue, SIGNAL(removeInvalidProxy(QString,bool)), m_binWidget, SLOT(slotRemoveInvalidProxy(QString,bool)));*/
 
+    StartupTimer::mark(QStringLiteral("Widgets"));
     m_mainWindow->init();
+    StartupTimer::mark(QStringLiteral("Main window"));
     projectManager()->init(Url, clipsToLoad);
     if (qApp->isSessionRestored()) {
         // NOTE: we are restoring only one window, because Kdenlive only uses one MainWindow
@@ -208,7 +214,8 @@ void Core::initGUI(const QUrl &Url, const QString &clipsToLoad)
     }
     QMetaObject::invokeMethod(pCore->projectManager(), "slotLoadOnOpen", Qt::QueuedConnection);
     m_mainWindow->show();
-    QThreadPool::globalInstance()->setMaxThreadCount(qMin(4, QThreadPool::globalInstance()->maxThreadCount()));
+    StartupTimer::mark(QStringLiteral("Show"));
+    StartupTimer::report();
 }
 
 void Core::buildLumaThumbs(const QStringList &values)
@@ -20,6 +20,7 @@
 #include "renderwidget.h"
 #include "bin/projectitemmodel.h"
 #include "bin/bin.h"
+#include "bin/binplaylist.hpp"
 #include "core.h"
 #include "dialogs/profilesdialog.h"
 #include "doc/kdenlivedoc.h"
@@ -356,9 +357,12 @@ RenderWidget::RenderWidget(bool enableProxy, QWidget *parent)
 #endif
     m_view.parallel_process->setChecked(KdenliveSettings::parallelrender());
     connect(m_view.parallel_process, &QCheckBox::stateChanged, [](int state) { KdenliveSettings::setParallelrender(state == Qt::Checked); });
+    m_view.segmented_render->setChecked(KdenliveSettings::segmentedrender());
+    connect(m_view.segmented_render, &QCheckBox::stateChanged, [](int state) { KdenliveSettings::setSegmentedrender(state == Qt::Checked); });
     if (KdenliveSettings::gpu_accel()) {
         // Disable parallel rendering for movit
         m_view.parallel_process->setEnabled(false);
+        m_view.segmented_render->setEnabled(false);
     }
     m_view.field_order->setEnabled(false);
     connect(m_view.scanning_list, QOverload<int>::of(&QComboBox::currentIndexChanged), [this](int index) { m_view.field_order->setEnabled(index == 2); });
@@ -1605,6 +1609,46 @@ void RenderWidget::generateRenderFiles(QDomDocument doc, const QString &playlist
         file.close();
     }
 
+    // Segmented render: each segment is rendered from its own playlist, then kdenlive_render joins them
+    QStringList segmentArgs;
+    if (passes == 1 && !delayedRendering && m_view.segmented_render->isChecked() && m_view.segmented_render->isEnabled() &&
+        !renderedFile.contains(QLatin1Char('%'))) {
+        int segments = KdenliveSettings::rendersegments();
+        if (segments <= 0) {
+            segments = qMax(2, QThread::idealThreadCount() / 4);
+        }
+        QDomElement mainConsumer = doc.elementsByTagName(QStringLiteral("consumer")).at(0).toElement();
+        const double fps = pCore->getCurrentFps();
+        QVector<int> guides;
+        const QList<CommentedTime> markers = pCore->currentDoc()->getGuideModel()->getAllMarkers();
+        for (const CommentedTime &guide : markers) {
+            guides << guide.time().frames(fps);
+        }
+        const QVector<int> bounds = segmentBoundaries(doc, mainConsumer.attribute(QStringLiteral("in")).toInt(),
+                                                      mainConsumer.attribute(QStringLiteral("out")).toInt(), segments, fps, guides);
+        // A single segment is rendered from the main playlist
+        if (bounds.count() > 2) {
+            for (int i = 0; i < bounds.count() - 1; i++) {
+                QDomDocument segment = doc.cloneNode(true).toDocument();
+                QDomElement segmentConsumer = segment.elementsByTagName(QStringLiteral("consumer")).at(0).toElement();
+                segmentConsumer.setAttribute(QStringLiteral("in"), bounds.at(i));
+                segmentConsumer.setAttribute(QStringLiteral("out"), bounds.at(i + 1) - 1);
+                segmentConsumer.setAttribute(QStringLiteral("target"), segmentFileName(renderedFile, QStringLiteral("-part%1").arg(i + 1)));
+                // Each segment encoder only gets its share of the cpu
+                segmentConsumer.setAttribute(QStringLiteral("real_time"), -1);
+                const QString segmentName = segmentFileName(playlistPath, QStringLiteral("-seg%1").arg(i + 1));
+                QFile file(segmentName);
+                if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+                    pCore->displayMessage(i18n("Cannot write to file %1", segmentName), ErrorMessage);
+                    return;
+                }
+                file.write(segment.toString().toUtf8());
+                file.close();
+            }
+            segmentArgs = QStringList{QStringLiteral("-segments"), QString::number(bounds.count() - 1), KdenliveSettings::ffmpegpath()};
+        }
+    }
+
     // Create job
     RenderJobItem *renderItem = nullptr;
     QList<QTreeWidgetItem *> existing = m_view.running_jobs->findItems(renderedFile, Qt::MatchExactly, 1);
@@ -1626,6 +1670,7 @@ void RenderWidget::generateRenderFiles(QDomDocument doc, const QString &playlist
             renderItem->setData(1, Qt::UserRole, i18n("Waiting..."));
             QStringList argsJob = {KdenliveSettings::rendererpath(), playlistPath, renderedFile,
                                    QStringLiteral("-pid:%1").arg(QCoreApplication::applicationPid())};
+            argsJob << segmentArgs;
             renderItem->setData(1, ParametersRole, argsJob);
             renderItem->setData(1, TimeRole, QDateTime::currentDateTime());
             if (!exportAudio) {
@@ -1648,6 +1693,7 @@ void RenderWidget::generateRenderFiles(QDomDocument doc, const QString &playlist
         renderItem = new RenderJobItem(m_view.running_jobs, QStringList() << QString() << renderedFile);
         renderItem->setData(1, TimeRole, QDateTime::currentDateTime());
         QStringList argsJob = {KdenliveSettings::rendererpath(), pl, renderedFile, QStringLiteral("-pid:%1").arg(QCoreApplication::applicationPid())};
+        argsJob << segmentArgs;
         renderItem->setData(1, ParametersRole, argsJob);
         qDebug() << "* CREATED JOB WITH ARGS: " << argsJob;
         if (!exportAudio) {
@@ -1695,6 +1741,81 @@ void RenderWidget::generateRenderFiles(QDomDocument doc, const QString &playlist
     // slotExport(delayedRendering, in, out, project->metadata(), playlistPaths, trackNames, renderName, exportAudio);
 }
 
+QString RenderWidget::segmentFileName(const QString &path, const QString &suffix)
+{
+    const QString extension = QFileInfo(path).suffix();
+    if (extension.isEmpty()) {
+        return path + suffix;
+    }
+    return path.left(path.size() - extension.size() - 1) + suffix + QLatin1Char('.') + extension;
+}
+
+QVector<int> RenderWidget::segmentBoundaries(const QDomDocument &doc, int in, int out, int segments, double fps, const QVector<int> &guides)
+{
+    QVector<int> bounds{in};
+    int length = out - in + 1;
+    // Segments shorter than 10 seconds are not worth a process
+    segments = qMin(segments, int(length / (10 * fps)));
+    if (segments < 2) {
+        bounds << out + 1;
+        return bounds;
+    }
+    auto toFrames = [fps](const QString &time) {
+        if (!time.contains(QLatin1Char(':'))) {
+            return time.toInt();
+        }
+        const QStringList parts = time.split(QLatin1Char(':'));
+        double seconds = 0;
+        for (const QString &part : parts) {
+            seconds = seconds * 60 + part.toDouble();
+        }
+        return qRound(seconds * fps);
+    };
+    // Collect the cuts of all tracks, and the guides
+    QVector<int> cuts;
+    QDomNodeList playlists = doc.elementsByTagName(QStringLiteral("playlist"));
+    for (int i = 0; i < playlists.count(); ++i) {
+        QDomElement playlist = playlists.at(i).toElement();
+        if (playlist.attribute(QStringLiteral("id")) == BinPlaylist::binPlaylistId) {
+            continue;
+        }
+        int position = 0;
+        QDomNodeList items = playlist.childNodes();
+        for (int j = 0; j < items.count(); ++j) {
+            QDomElement item = items.at(j).toElement();
+            if (item.tagName() == QLatin1String("blank")) {
+                position += toFrames(item.attribute(QStringLiteral("length")));
+            } else if (item.tagName() == QLatin1String("entry")) {
+                cuts << position;
+                position += toFrames(item.attribute(QStringLiteral("out"))) - toFrames(item.attribute(QStringLiteral("in"))) + 1;
+                cuts << position;
+            }
+        }
+    }
+    cuts << guides;
+    std::sort(cuts.begin(), cuts.end());
+    // Snap each ideal split point to the nearest cut if it is close enough
+    int segmentLength = length / segments;
+    for (int i = 1; i < segments; i++) {
+        int target = in + i * segmentLength;
+        int best = target;
+        int bestDistance = segmentLength / 4;
+        auto it = std::lower_bound(cuts.constBegin(), cuts.constEnd(), target);
+        if (it != cuts.constEnd() && *it - target < bestDistance) {
+            best = *it;
+            bestDistance = *it - target;
+        }
+        if (it != cuts.constBegin() && target - *(it - 1) < bestDistance) {
+            best = *(it - 1);
+        }
+        if (best > bounds.last() && best <= out) {
+            bounds << best;
+        }
+    }
+    bounds << out + 1;
+    return bounds;
+}
+
 void RenderWidget::checkRenderStatus()
 {
     // check if we have a job waiting to render
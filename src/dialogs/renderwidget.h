@@ -145,6 +145,11 @@ public:
 
     /** @brief Display warning message in render widget. */
     void errorMessage(RenderError type, const QString &message);
+    /** @brief Returns the frames where a segmented render of in-out is split, cuts and guides (in frames) are preferred.
+     *  The list starts with in and ends with out + 1. */
+    static QVector<int> segmentBoundaries(const QDomDocument &doc, int in, int out, int segments, double fps, const QVector<int> &guides);
+    /** @brief Returns path with suffix inserted before its extension, or appended if it has none. */
+    static QString segmentFileName(const QString &path, const QString &suffix);
 
 protected:
     QSize sizeHint() const override;
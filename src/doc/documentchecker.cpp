@@ -21,6 +21,7 @@
 #include "bin/binplaylist.hpp"
 #include "effects/effectsrepository.hpp"
 #include "kdenlivesettings.h"
+#include "filesearchindex.h"
 #include "kthumb.h"
 #include "titler/titlewidget.h"
 
@@ -731,14 +732,54 @@ void DocumentChecker::slotSearchClips()
     bool fixed = false;
     m_ui.recursiveSearch->setChecked(true);
     // TODO: make non modal
+    m_ui.infoLabel->setVisible(true);
+    auto progress = [this](const QString &message) {
+        m_ui.infoLabel->setText(message);
+        qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
+    };
+    // Walk the folder once, then look for all the missing clips in the index
+    FileSearchIndex index(newpath);
+    index.scan(progress);
+    QVector<QPair<qint64, QString>> requests;
+    QList<QTreeWidgetItem *> requestItems;
+    auto addRequest = [&requests, &requestItems](QTreeWidgetItem *item) {
+        requests << qMakePair(item->data(0, sizeRole).toLongLong(), item->data(0, hashRole).toString());
+        requestItems << item;
+    };
     QTreeWidgetItem *child = m_ui.treeWidget->topLevelItem(ix);
+    while (child != nullptr) {
+        if (child->data(0, statusRole).toInt() == SOURCEMISSING) {
+            for (int j = 0; j < child->childCount(); ++j) {
+                addRequest(child->child(j));
+            }
+        } else if (child->data(0, statusRole).toInt() == CLIPMISSING && (ClipType::ProducerType)child->data(0, clipTypeRole).toInt() != ClipType::SlideShow) {
+            // Slideshows cannot be found with hash / size
+            addRequest(child);
+        }
+        child = m_ui.treeWidget->topLevelItem(++ix);
+    }
+    const QStringList found = index.resolve(requests, progress);
+    QHash<QTreeWidgetItem *, QString> matches;
+    for (int i = 0; i < requestItems.count(); ++i) {
+        if (!found.at(i).isEmpty()) {
+            matches.insert(requestItems.at(i), found.at(i));
+        } else if (requests.at(i).second.isEmpty() && requestItems.at(i)->data(0, sizeRole).toString().isEmpty()) {
+            // No size and hash for this clip, look for its file name
+            matches.insert(requestItems.at(i), index.findByName(QUrl::fromLocalFile(requestItems.at(i)->text(1)).fileName()));
+        }
+    }
+    const FileSearchIndex::Statistics &stats = index.statistics();
+    m_ui.infoLabel->setText(i18n("Scanned %1 files in %2 seconds, checked %3 files (%4 MB/s).", stats.files, QString::number(stats.scanTime / 1000., 'f', 1),
+                                 stats.hashedFiles, QString::number(stats.hashedBytes / 1000. / qMax(qint64(1), stats.hashTime), 'f', 1)));
+
+    ix = 0;
+    child = m_ui.treeWidget->topLevelItem(ix);
     QDir searchDir(newpath);
     while (child != nullptr) {
         if (child->data(0, statusRole).toInt() == SOURCEMISSING) {
             for (int j = 0; j < child->childCount(); ++j) {
                 QTreeWidgetItem *subchild = child->child(j);
-                QString clipPath =
-                    searchFileRecursively(searchDir, subchild->data(0, sizeRole).toString(), subchild->data(0, hashRole).toString(), subchild->text(1));
+                QString clipPath = matches.value(subchild);
                 if (!clipPath.isEmpty()) {
                     fixed = true;
                     subchild->setText(1, clipPath);
@@ -749,13 +790,10 @@ void DocumentChecker::slotSearchClips()
         } else if (child->data(0, statusRole).toInt() == CLIPMISSING) {
             bool perfectMatch = true;
             ClipType::ProducerType type = (ClipType::ProducerType)child->data(0, clipTypeRole).toInt();
-            QString clipPath;
-            if (type != ClipType::SlideShow) {
-                // Slideshows cannot be found with hash / size
-                clipPath = searchFileRecursively(searchDir, child->data(0, sizeRole).toString(), child->data(0, hashRole).toString(), child->text(1));
-            }
+            QString clipPath = matches.value(child);
             if (clipPath.isEmpty()) {
-                clipPath = searchPathRecursively(searchDir, QUrl::fromLocalFile(child->text(1)).fileName(), type);
+                const QString fileName = QUrl::fromLocalFile(child->text(1)).fileName();
+                clipPath = type == ClipType::SlideShow ? searchPathRecursively(searchDir, fileName, type) : index.findByName(fileName);
                 perfectMatch = false;
             }
             if (!clipPath.isEmpty()) {
@@ -775,7 +813,7 @@ void DocumentChecker::slotSearchClips()
         } else if (child->data(0, typeRole).toInt() == TITLE_IMAGE_ELEMENT && child->data(0, statusRole).toInt() == CLIPPLACEHOLDER) {
             // Search missing title images
             QString missingFileName = QUrl::fromLocalFile(child->text(1)).fileName();
-            QString newPath = searchPathRecursively(searchDir, missingFileName);
+            QString newPath = index.findByName(missingFileName);
             if (!newPath.isEmpty()) {
                 // File found
                 fixed = true;
@@ -863,50 +901,6 @@ QString DocumentChecker::searchPathRecursively(const QDir &dir, const QString &f
     return foundFileName;
 }
 
-QString DocumentChecker::searchFileRecursively(const QDir &dir, const QString &matchSize, const QString &matchHash, const QString &fileName) const
-{
-    if (matchSize.isEmpty() && matchHash.isEmpty()) {
-        return searchPathRecursively(dir, QUrl::fromLocalFile(fileName).fileName());
-    }
-    QString foundFileName;
-    QByteArray fileData;
-    QByteArray fileHash;
-    QStringList filesAndDirs = dir.entryList(QDir::Files | QDir::Readable);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        QFile file(dir.absoluteFilePath(filesAndDirs.at(i)));
-        if (QString::number(file.size()) == matchSize) {
-            if (file.open(QIODevice::ReadOnly)) {
-                /*
-                 * 1 MB = 1 second per 450 files (or faster)
-                 * 10 MB = 9 seconds per 450 files (or faster)
-                 */
-                if (file.size() > 1000000 * 2) {
-                    fileData = file.read(1000000);
-                    if (file.seek(file.size() - 1000000)) {
-                        fileData.append(file.readAll());
-                    }
-                } else {
-                    fileData = file.readAll();
-                }
-                file.close();
-                fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
-                if (QString::fromLatin1(fileHash.toHex()) == matchHash) {
-                    return file.fileName();
-                }
-            }
-        }
-        ////qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << file.size() << fileHash.toHex();
-    }
-    filesAndDirs = dir.entryList(QDir::Dirs | QDir::Readable | QDir::Executable | QDir::NoDotAndDotDot);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        foundFileName = searchFileRecursively(dir.absoluteFilePath(filesAndDirs.at(i)), matchSize, matchHash, fileName);
-        if (!foundFileName.isEmpty()) {
-            break;
-        }
-    }
-    return foundFileName;
-}
-
 void DocumentChecker::slotEditItem(QTreeWidgetItem *item, int)
 {
     int t = item->data(0, typeRole).toInt();
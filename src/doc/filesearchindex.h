@@ -0,0 +1,85 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+#ifndef FILESEARCHINDEX_H
+#define FILESEARCHINDEX_H
+
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+/**
+ * @class FileSearchIndex
+ * @brief Index of all the files of a folder tree, used to relocate moved clips.
+ *
+ * The tree is walked only once (its top level folders in parallel) and files are indexed by size and by name.
+ * Missing clips are then resolved all together: only the files whose size matches a missing clip are hashed,
+ * each of them at most once.
+ */
+class FileSearchIndex
+{
+public:
+    struct Statistics
+    {
+        int files{0};
+        int hashedFiles{0};
+        qint64 hashedBytes{0};
+        qint64 scanTime{0}; // ms
+        qint64 hashTime{0}; // ms
+    };
+    /** @brief Called with a message describing the current step */
+    using Progress = std::function<void(const QString &)>;
+
+    explicit FileSearchIndex(QString root);
+
+    /** @brief Walk the folder tree and build the index */
+    void scan(const Progress &progress = nullptr);
+
+    /** @brief Find the files matching a list of (size, hash) pairs
+     *  @returns the path found for each request, or an empty string */
+    QStringList resolve(const QVector<QPair<qint64, QString>> &requests, const Progress &progress = nullptr);
+
+    /** @brief Returns a file with this name, the one closest to the root if there are several */
+    QString findByName(const QString &fileName) const;
+
+    const Statistics &statistics() const;
+
+    /** @brief The hash used to identify clips: md5 of the first and last MB of the file */
+    static QString fileHash(const QString &path, qint64 *readBytes = nullptr);
+
+private:
+    struct Entry
+    {
+        QString path;
+        qint64 size;
+    };
+    static QVector<Entry> scanFolder(const QString &folder);
+    /** @brief Returns the hash of a file and the number of bytes read */
+    static QPair<QString, qint64> hashEntry(const QString &path);
+    QString m_root;
+    QHash<qint64, QStringList> m_bySize;
+    QHash<QString, QString> m_byName;
+    QHash<QString, QString> m_hashes;
+    Statistics m_stats;
+};
+
+#endif
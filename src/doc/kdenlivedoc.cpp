@@ -39,6 +39,8 @@
 #include "profiles/profilerepository.hpp"
 #include "project/projectcommands.h"
 #include "titler/titlewidget.h"
+#include "utils/mediaprobecache.hpp"
+#include "xml/xml.hpp"
 #include "transitions/transitionsrepository.hpp"
 
 #include <config-kdenlive.h>
@@ -231,6 +233,7 @@ KdenliveDoc::KdenliveDoc(const QUrl &url, QString projectFolder, QUndoGroup *und
                         success = !d.hasErrorInClips();
                         if (success) {
                             loadDocumentProperties();
+                            applyMediaProbeCache();
                             if (m_document.documentElement().hasAttribute(QStringLiteral("upgraded"))) {
                                 m_documentOpenStatus = UpgradedProject;
                                 pCore->displayMessage(i18n("Your project was upgraded, a backup will be created on next save"), ErrorMessage);
@@ -790,49 +793,6 @@ const QString KdenliveDoc::description() const
     return m_url.fileName() + QStringLiteral(" [*]/ ") + pCore->getCurrentProfile()->description();
 }
 
-QString KdenliveDoc::searchFileRecursively(const QDir &dir, const QString &matchSize, const QString &matchHash) const
-{
-    QString foundFileName;
-    QByteArray fileData;
-    QByteArray fileHash;
-    QStringList filesAndDirs = dir.entryList(QDir::Files | QDir::Readable);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        QFile file(dir.absoluteFilePath(filesAndDirs.at(i)));
-        if (file.open(QIODevice::ReadOnly)) {
-            if (QString::number(file.size()) == matchSize) {
-                /*
-                 * 1 MB = 1 second per 450 files (or faster)
-                 * 10 MB = 9 seconds per 450 files (or faster)
-                 */
-                if (file.size() > 1000000 * 2) {
-                    fileData = file.read(1000000);
-                    if (file.seek(file.size() - 1000000)) {
-                        fileData.append(file.readAll());
-                    }
-                } else {
-                    fileData = file.readAll();
-                }
-                file.close();
-                fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
-                if (QString::fromLatin1(fileHash.toHex()) == matchHash) {
-                    return file.fileName();
-                }
-                qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << "size match but not hash";
-            }
-        }
-        ////qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << file.size() << fileHash.toHex();
-    }
-    filesAndDirs = dir.entryList(QDir::Dirs | QDir::Readable | QDir::Executable | QDir::NoDotAndDotDot);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        foundFileName = searchFileRecursively(dir.absoluteFilePath(filesAndDirs.at(i)), matchSize, matchHash);
-        if (!foundFileName.isEmpty()) {
-            break;
-        }
-    }
-    return foundFileName;
-}
-
-
 QStringList KdenliveDoc::getBinFolderClipIds(const QString &folderId) const
 {
     return pCore->bin()->getBinFolderClipIds(folderId);
@@ -1275,6 +1235,47 @@ QMap<QString, QString> KdenliveDoc::documentProperties()
     return m_documentProperties;
 }
 
+void KdenliveDoc::applyMediaProbeCache()
+{
+    if (!KdenliveSettings::mediaprobecache()) {
+        return;
+    }
+    QDomNodeList producers = m_document.elementsByTagName(QStringLiteral("producer"));
+    int cached = 0;
+    for (int i = 0; i < producers.count(); ++i) {
+        QDomElement prod = producers.at(i).toElement();
+        if (Xml::getXmlProperty(prod, QStringLiteral("mlt_service")) != QLatin1String("avformat")) {
+            continue;
+        }
+        QString resource = Xml::getXmlProperty(prod, QStringLiteral("resource"));
+        if (QFileInfo(resource).isRelative()) {
+            resource.prepend(m_documentRoot);
+        }
+        QMap<QString, QString> properties;
+        if (!MediaProbeCache::get()->lookup(resource, properties)) {
+            continue;
+        }
+        if (!properties.contains(QStringLiteral("length")) && Xml::getXmlProperty(prod, QStringLiteral("length")).isEmpty()) {
+            // Entry stored from another project, a novalidate producer cannot be used without the length
+            continue;
+        }
+        // Values saved in the project (length, stream indexes...) take precedence over the probed ones
+        QDomNodeList props = prod.childNodes();
+        for (int j = 0; j < props.count(); ++j) {
+            QDomElement e = props.at(j).toElement();
+            if (e.tagName() == QLatin1String("property")) {
+                properties.remove(e.attribute(QStringLiteral("name")));
+            }
+        }
+        Xml::addXmlProperties(prod, properties);
+        // A novalidate producer only opens its file on first use, the clip is probed again in background once the project is loaded
+        Xml::setXmlProperty(prod, QStringLiteral("mlt_service"), QStringLiteral("avformat-novalidate"));
+        Xml::setXmlProperty(prod, QStringLiteral("_probecached"), QStringLiteral("1"));
+        cached++;
+    }
+    qCDebug(KDENLIVE_LOG) << "Media probe cache used for" << cached << "producers";
+}
+
 void KdenliveDoc::loadDocumentProperties()
 {
     QDomNodeList list = m_document.elementsByTagName(QStringLiteral("playlist"));
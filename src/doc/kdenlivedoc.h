@@ -190,8 +190,6 @@ private:
     QMap<QString, QString> m_documentMetadata;
     std::shared_ptr<MarkerListModel> m_guideModel;
 
-    QString searchFileRecursively(const QDir &dir, const QString &matchSize, const QString &matchHash) const;
-
     /** @brief Creates a new project. */
     QDomDocument createEmptyDocument(int videotracks, int audiotracks);
     QDomDocument createEmptyDocument(const QList<TrackInfo> &tracks);
@@ -202,6 +200,8 @@ private:
     void cleanupBackupFiles();
     /** @brief Load document properties from the xml file */
     void loadDocumentProperties();
+    /** @brief Use the media probe cache to avoid probing unchanged files when MLT loads the project */
+    void applyMediaProbeCache();
     /** @brief update document properties to reflect a change in the current profile */
     void updateProjectProfile(bool reloadProducers = false, bool reloadThumbs = false);
     /** @brief initialize proxy settings based on hw status */
@@ -77,6 +77,8 @@ protected:
 
     QStringList assetDirs() const override;
 
+    QString assetCacheName() const override;
+
     void parseType(QScopedPointer<Mlt::Properties> &metadata, Info &res) override;
 
     /* @brief Returns the metadata associated with the given asset*/
@@ -26,10 +26,11 @@
 #include "effectstackmodel.hpp"
 #include <utility>
 
-EffectItemModel::EffectItemModel(const QList<QVariant> &effectData, std::unique_ptr<Mlt::Properties> effect, const QDomElement &xml, const QString &effectId,
+EffectItemModel::EffectItemModel(const QList<QVariant> &effectData, std::unique_ptr<Mlt::Properties> effect,
+                                 std::shared_ptr<const AssetDescriptor> descriptor, const QHash<QString, QString> &values, const QString &effectId,
                                  const std::shared_ptr<AbstractTreeModel> &stack, bool isEnabled)
     : AbstractEffectItem(EffectItemType::Effect, effectData, stack, false, isEnabled)
-    , AssetParameterModel(std::move(effect), xml, effectId, std::static_pointer_cast<EffectStackModel>(stack)->getOwnerId())
+    , AssetParameterModel(std::move(effect), std::move(descriptor), effectId, std::static_pointer_cast<EffectStackModel>(stack)->getOwnerId(), values)
     , m_childId(0)
 {
     connect(this, &AssetParameterModel::updateChildren, [&](const QString &name) {
@@ -49,7 +50,7 @@ EffectItemModel::EffectItemModel(const QList<QVariant> &effectData, std::unique_
 std::shared_ptr<EffectItemModel> EffectItemModel::construct(const QString &effectId, std::shared_ptr<AbstractTreeModel> stack, bool effectEnabled)
 {
     Q_ASSERT(EffectsRepository::get()->exists(effectId));
-    QDomElement xml = EffectsRepository::get()->getXml(effectId);
+    auto descriptor = EffectsRepository::get()->getDescriptor(effectId);
 
     std::unique_ptr<Mlt::Properties> effect = EffectsRepository::get()->getEffect(effectId);
     effect->set("kdenlive_id", effectId.toUtf8().constData());
@@ -57,7 +58,7 @@ std::shared_ptr<EffectItemModel> EffectItemModel::construct(const QString &effec
     QList<QVariant> data;
     data << EffectsRepository::get()->getName(effectId) << effectId;
 
-    std::shared_ptr<EffectItemModel> self(new EffectItemModel(data, std::move(effect), xml, effectId, stack, effectEnabled));
+    std::shared_ptr<EffectItemModel> self(new EffectItemModel(data, std::move(effect), descriptor, QHash<QString, QString>(), effectId, stack, effectEnabled));
 
     baseFinishConstruct(self);
     return self;
@@ -71,20 +72,18 @@ std::shared_ptr<EffectItemModel> EffectItemModel::construct(std::unique_ptr<Mlt:
         effectId = effect->get("mlt_service");
     }
     Q_ASSERT(EffectsRepository::get()->exists(effectId));
-    QDomElement xml = EffectsRepository::get()->getXml(effectId);
-    QDomNodeList params = xml.elementsByTagName(QStringLiteral("parameter"));
-    for (int i = 0; i < params.count(); ++i) {
-        QDomElement currentParameter = params.item(i).toElement();
-        QString paramName = currentParameter.attribute(QStringLiteral("name"));
-        QString paramValue = effect->get(paramName.toUtf8().constData());
-        currentParameter.setAttribute(QStringLiteral("value"), paramValue);
+    auto descriptor = EffectsRepository::get()->getDescriptor(effectId);
+    // The parameter values are those of the existing filter
+    QHash<QString, QString> values;
+    for (const AssetDescriptor::Parameter &param : descriptor->parameters()) {
+        values.insert(param.name, effect->get(param.name.toUtf8().constData()));
     }
 
     QList<QVariant> data;
     data << EffectsRepository::get()->getName(effectId) << effectId;
 
     bool disable = effect->get_int("disable") == 0;
-    std::shared_ptr<EffectItemModel> self(new EffectItemModel(data, std::move(effect), xml, effectId, stack, disable));
+    std::shared_ptr<EffectItemModel> self(new EffectItemModel(data, std::move(effect), descriptor, values, effectId, stack, disable));
     baseFinishConstruct(self);
     return self;
 }
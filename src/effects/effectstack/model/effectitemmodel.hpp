@@ -63,8 +63,8 @@ public:
     bool isValid() const;
 
 protected:
-    EffectItemModel(const QList<QVariant> &effectData, std::unique_ptr<Mlt::Properties> effect, const QDomElement &xml, const QString &effectId,
-                    const std::shared_ptr<AbstractTreeModel> &stack, bool isEnabled = true);
+    EffectItemModel(const QList<QVariant> &effectData, std::unique_ptr<Mlt::Properties> effect, std::shared_ptr<const AssetDescriptor> descriptor,
+                    const QHash<QString, QString> &values, const QString &effectId, const std::shared_ptr<AbstractTreeModel> &stack, bool isEnabled = true);
     QMap<int, std::shared_ptr<EffectItemModel>> m_childEffects;
     void updateEnable(bool updateTimeline = true) override;
     int m_childId;
@@ -30,9 +30,10 @@
 #include "lib/audio/audioStreamInfo.h"
 #include "macros.hpp"
 #include "utils/thumbnailcache.hpp"
+#include <QFile>
 #include <QScopedPointer>
-#include <QTemporaryFile>
 #include <QProcess>
+#include <cstring>
 #include <memory>
 #include <mlt++/MltProducer.h>
 
@@ -49,7 +50,7 @@ const QString AudioThumbJob::getDescription() const
 
 bool AudioThumbJob::computeWithMlt()
 {
-    m_audioLevels.clear();
+    m_peaks.reset();
     m_errorMessage.clear();
     // MLT audio thumbs: slower but safer
     QString service = m_prod->get("mlt_service");
@@ -79,8 +80,10 @@ bool AudioThumbJob::computeWithMlt()
     for (int i = 0; i < m_channels; i++) {
         keys << "meta.media.audio_level." + QString::number(i);
     }
-    double maxLevel = 1;
-    QVector <double> mltLevels;
+    // The audiolevel filter gives one level per frame, use it as the finest peak level
+    m_peaks.reset(new AudioPeaksBuilder(m_channels, m_frequency, framesPerSecond, m_lengthInFrames, m_frequency / framesPerSecond));
+    QVector<double> mltLevels(m_channels, 0.);
+    bool hasLevels = false;
     for (int z = 0; z < m_lengthInFrames; ++z) {
         int val = (int)(100.0 * z / m_lengthInFrames);
         if (last_val != val) {
@@ -92,20 +95,14 @@ bool AudioThumbJob::computeWithMlt()
             int samples = mlt_sample_calculator(float(framesPerSecond), m_frequency, z);
             mltFrame->get_audio(audioFormat, m_frequency, m_channels, samples);
             for (int channel = 0; channel < m_channels; ++channel) {
-                double lev = mltFrame->get_double(keys.at(channel).toUtf8().constData());
-                mltLevels << lev;
-                maxLevel = qMax(lev, maxLevel);
-            }
-        } else if (!mltLevels.isEmpty()) {
-            for (int channel = 0; channel < m_channels; channel++) {
-                mltLevels << mltLevels.last();
+                mltLevels[channel] = mltFrame->get_double(keys.at(channel).toUtf8().constData());
             }
+            m_peaks->addLevels(mltLevels);
+            hasLevels = true;
+        } else if (hasLevels) {
+            m_peaks->addLevels(mltLevels);
         }
     }
-    // Normalize
-    for (double &v : mltLevels) {
-        m_audioLevels << 255 * v / maxLevel;
-    }
 
     m_done = true;
     return true;
@@ -153,124 +150,70 @@ bool AudioThumbJob::computeWithFFMPEG()
         }
     }
     if (!m_dataInCache && !m_done && KdenliveSettings::audiothumbnails()) {
-        // Generate timeline audio thumbnail data
-        m_audioLevels.clear();
-        std::vector<std::unique_ptr<QTemporaryFile>> channelFiles;
-        for (int i = 0; i < m_channels; i++) {
-            std::unique_ptr<QTemporaryFile> channelTmpfile(new QTemporaryFile());
-            if (!channelTmpfile->open()) {
-                m_errorMessage.append(i18n("Audio thumbs: cannot create temporary file, check disk space and permissions\n"));
-                return false;
-            }
-            channelTmpfile->close();
-            channelFiles.emplace_back(std::move(channelTmpfile));
-        }
-        // Always create audio thumbs from the original source file, because proxy 
+        // Generate timeline audio thumbnail data. The decoded samples are read from ffmpeg's output
+        // in fixed size blocks and reduced to the peak pyramid on the fly.
+        m_peaks.reset();
+        // Always create audio thumbs from the original source file, because proxy
         // can have a different audio config (channels / mono/ stereo)
-        QStringList args {QStringLiteral("-hide_banner"), QStringLiteral("-i"), QUrl::fromLocalFile(filePath).toLocalFile(), QStringLiteral("-progress")};
-#ifdef Q_OS_WIN
-        args << QStringLiteral("-");
-#else
-        args << QStringLiteral("/dev/stdout");
-#endif
+        QStringList args {QStringLiteral("-hide_banner"), QStringLiteral("-nostats"), QStringLiteral("-i"), QUrl::fromLocalFile(filePath).toLocalFile()};
         bool isFFmpeg = KdenliveSettings::ffmpegpath().contains(QLatin1String("ffmpeg"));
-        args << QStringLiteral("-filter_complex");
-        if (m_channels == 1) {
-            if (m_audioStream >= 0) {
-                args << QStringLiteral("[a:%1]aformat=channel_layouts=mono,%2=100").arg(audioStreamIndex).arg(isFFmpeg ? "aresample=async" : "sample_rates");
-            } else {
-                args << QStringLiteral("[a]aformat=channel_layouts=mono,%1=100").arg(isFFmpeg ? "aresample=async" : "sample_rates");
-            }
-            /*args << QStringLiteral("-map") << QStringLiteral("0:a%1").arg(m_audioStream > 0 ? ":" + QString::number(audioStreamIndex) : QString())*/
-            args << QStringLiteral("-c:a") << QStringLiteral("pcm_s16le") << QStringLiteral("-frames:v") 
-             << QStringLiteral("1") << QStringLiteral("-y") << QStringLiteral("-f") << QStringLiteral("data")
-             << channelFiles[0]->fileName();
-        } else {
-            QString aformat = QStringLiteral("[a%1]%2=100,channelsplit=channel_layout=%3")
-                              .arg(audioStreamIndex >= 0 ? ":" + QString::number(audioStreamIndex) : QString())
-                              .arg(isFFmpeg ? "aresample=async" : "aformat=sample_rates")
-                              .arg(m_channels > 2 ? "5.1" : "stereo");
-            for (int i = 0; i < m_channels; ++i) {
-                aformat.append(QStringLiteral("[0:%1]").arg(i));
-            }
-            args << aformat;
-            args << QStringLiteral("-frames:v") << QStringLiteral("1");
-            for (int i = 0; i < m_channels; i++) {
-                // Channel 1
-                args << QStringLiteral("-map") << QStringLiteral("[0:%1]").arg(i) << QStringLiteral("-c:a") << QStringLiteral("pcm_s16le") << QStringLiteral("-y")
-                 << QStringLiteral("-f") << QStringLiteral("data") << channelFiles[size_t(i)]->fileName();
-            }
-        }
+        args << QStringLiteral("-filter_complex")
+             << QStringLiteral("[a%1]%2")
+                    .arg(audioStreamIndex >= 0 ? ":" + QString::number(audioStreamIndex) : QString())
+                    .arg(isFFmpeg ? "aresample=async=100" : "anull");
+        args << QStringLiteral("-vn") << QStringLiteral("-ac") << QString::number(m_channels) << QStringLiteral("-ar") << QString::number(m_frequency)
+             << QStringLiteral("-c:a") << QStringLiteral("pcm_s16le") << QStringLiteral("-f") << QStringLiteral("s16le") << QStringLiteral("pipe:1");
         m_ffmpegProcess.reset(new QProcess);
-        connect(m_ffmpegProcess.get(), &QProcess::readyReadStandardOutput, this, &AudioThumbJob::updateFfmpegProgress, Qt::UniqueConnection);
         connect(this, &AudioThumbJob::jobCanceled, [&]() {
             if (m_ffmpegProcess) {
-                disconnect(m_ffmpegProcess.get(), &QProcess::readyReadStandardOutput, this, &AudioThumbJob::updateFfmpegProgress);
                 m_ffmpegProcess->kill();
             }
         });
         m_ffmpegProcess->start(KdenliveSettings::ffmpegpath(), args);
-        m_ffmpegProcess->waitForFinished(-1);
-        disconnect(m_ffmpegProcess.get(), &QProcess::readyReadStandardOutput, this, &AudioThumbJob::updateFfmpegProgress);
-        if (m_ffmpegProcess->exitStatus() != QProcess::CrashExit) {
-            int dataSize = 0;
-            std::vector<const qint16 *> rawChannels;
-            std::vector<QByteArray> sourceChannels;
-            for (auto &channelFile : channelFiles) {
-                channelFile->open();
-                sourceChannels.emplace_back(channelFile->readAll());
-                QByteArray &res = sourceChannels.back();
-                channelFile->close();
-                if (dataSize == 0) {
-                    dataSize = res.size();
-                }
-                if (res.isEmpty() || res.size() != dataSize) {
-                    // Something went wrong, abort
-                    m_errorMessage.append(i18n("Audio thumbs: error reading audio thumbnail created with FFmpeg\n"));
-                    return false;
-                }
-                rawChannels.emplace_back(reinterpret_cast<const qint16 *>(res.constData()));
-            }
+        if (m_ffmpegProcess->waitForStarted()) {
+            const int sampleSize = 2 * m_channels;
+            // Read about 1 second of audio at once, in whole samples
+            const int blockSize = qMax(1, m_frequency) * sampleSize;
+            QByteArray buffer(blockSize, 0);
+            int buffered = 0;
+            const double fps = m_prod->get_fps();
+            const qint64 totalSamples = qMax(qint64(1), qint64(m_lengthInFrames * m_frequency / fps));
+            m_peaks.reset(new AudioPeaksBuilder(m_channels, m_frequency, fps, m_lengthInFrames));
+            qint64 sampleIndex = 0;
             int progress = 0;
-            std::vector<long> channelsData;
-            double offset = (double)dataSize / (2.0 * m_lengthInFrames);
-            int intraOffset = 1;
-            if (offset > 1000) {
-                intraOffset = offset / 60;
-            } else if (offset > 250) {
-                intraOffset = offset / 10;
-            }
-            long maxLevel = 1;
-            QVector <long> ffmpegLevels;
-            for (int i = 0; i < m_lengthInFrames; i++) {
-                channelsData.resize((size_t)rawChannels.size());
-                std::fill(channelsData.begin(), channelsData.end(), 0);
-                int pos = (int)(i * offset);
-                int steps = 0;
-                for (int j = 0; j < (int)offset && (pos + j < dataSize); j += intraOffset) {
-                    steps++;
-                    for (size_t k = 0; k < rawChannels.size(); k++) {
-                        channelsData[k] += abs(rawChannels[k][pos + j]);
-                    }
+            while (true) {
+                if (m_ffmpegProcess->bytesAvailable() == 0 && !m_ffmpegProcess->waitForReadyRead(-1)) {
+                    // Process finished and all data was read
+                    break;
                 }
-                for (long &k : channelsData) {
-                    if (steps != 0) {
-                        k /= steps;
-                    }
-                    maxLevel = qMax(k, maxLevel);
-                    ffmpegLevels << k;
+                qint64 read = m_ffmpegProcess->read(buffer.data() + buffered, blockSize - buffered);
+                if (read <= 0) {
+                    continue;
                 }
-                int p = 80 + (i * 20 / m_lengthInFrames);
+                buffered += int(read);
+                int samples = buffered / sampleSize;
+                m_peaks->addSamples(reinterpret_cast<const qint16 *>(buffer.constData()), samples);
+                sampleIndex += samples;
+                int p = int(qMin(qint64(100), sampleIndex * 100 / totalSamples));
                 if (p != progress) {
                     emit jobProgress(p);
                     progress = p;
                 }
+                // Keep an incomplete sample for the next block
+                int remaining = buffered - samples * sampleSize;
+                if (remaining > 0) {
+                    memmove(buffer.data(), buffer.constData() + samples * sampleSize, size_t(remaining));
+                }
+                buffered = remaining;
             }
-            for (long &v : ffmpegLevels) {
-                m_audioLevels << (uint8_t) (255 * v / maxLevel);
+            m_ffmpegProcess->waitForFinished(-1);
+            m_logDetails += QString::fromUtf8(m_ffmpegProcess->readAllStandardError());
+            if (m_ffmpegProcess->exitStatus() != QProcess::CrashExit && sampleIndex > 0) {
+                m_done = true;
+                return true;
             }
-            m_done = true;
-            return true;
+            m_peaks.reset();
+            m_errorMessage.append(i18n("Audio thumbs: error reading audio thumbnail created with FFmpeg\n"));
         }
     }
     if (!KdenliveSettings::audiothumbnails()) {
@@ -343,10 +286,16 @@ bool AudioThumbJob::startJob()
         // Generate one thumb per stream
         m_audioStream = stream;
         m_cachePath = m_binClip->getAudioThumbPath(stream);
+        // Audio data used to be cached in an image, it is not used anymore
+        QString legacyPath = m_cachePath;
+        legacyPath.replace(QLatin1String("_audio.peaks"), QLatin1String("_audio.png"));
+        if (legacyPath != m_cachePath && QFile::exists(legacyPath)) {
+            QFile::remove(legacyPath);
+        }
 
         // checking for cached thumbs
-        QImage image(m_cachePath);
-        if (!image.isNull()) {
+        AudioPeaks cached;
+        if (cached.open(m_cachePath)) {
             // Audio cache already exists
             continue;
         }
@@ -358,29 +307,10 @@ bool AudioThumbJob::startJob()
         }
         Q_ASSERT(ok == m_done);
 
-        if (ok && m_done && !m_audioLevels.isEmpty()) {
-            // Put into an image for caching.
-            int count = m_audioLevels.size();
-            image = QImage((int)lrint((count + 3) / 4.0 / m_channels), m_channels, QImage::Format_ARGB32);
-            int n = image.width() * image.height();
-            for (int i = 0; i < n; i++) {
-                QRgb p;
-                if ((4 * i + 3) < count) {
-                    p = qRgba(m_audioLevels.at(4 * i), m_audioLevels.at(4 * i + 1), m_audioLevels.at(4 * i + 2),
-                          m_audioLevels.at(4 * i + 3));
-                } else {
-                    int last = m_audioLevels.last();
-                    int r = (4 * i + 0) < count ? m_audioLevels.at(4 * i + 0) : last;
-                    int g = (4 * i + 1) < count ? m_audioLevels.at(4 * i + 1) : last;
-                    int b = (4 * i + 2) < count ? m_audioLevels.at(4 * i + 2) : last;
-                    int a = last;
-                    p = qRgba(r, g, b, a);
-                }
-                image.setPixel(i / m_channels, i % m_channels, p);
-            }
-            image.save(m_cachePath);
+        if (ok && m_done && m_peaks && !m_peaks->isEmpty()) {
+            m_peaks->save(m_cachePath);
         }
-        m_audioLevels.clear();
+        m_peaks.reset();
     }
     if (m_done || !KdenliveSettings::audiothumbnails()) {
         m_successful = true;
@@ -22,6 +22,7 @@
 #pragma once
 
 #include "abstractclipjob.h"
+#include "lib/audio/audioPeaks.h"
 
 #include <memory>
 #include <QImage>
@@ -72,6 +73,6 @@ private:
 
     bool m_done{false}, m_successful{false};
     int m_channels, m_frequency, m_lengthInFrames, m_audioStream;
-    QVector <uint8_t>m_audioLevels;
+    std::unique_ptr<AudioPeaksBuilder> m_peaks;
     std::unique_ptr<QProcess> m_ffmpegProcess;
 };
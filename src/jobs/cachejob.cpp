@@ -28,6 +28,7 @@
 #include "klocalizedstring.h"
 #include "macros.hpp"
 #include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailproducerpool.hpp"
 #include <QImage>
 #include <QScopedPointer>
 #include <QThread>
@@ -80,9 +81,12 @@ bool CacheJob::startJob()
         m_done = true;
         return true;
     }
-    m_prod = m_binClip->thumbProducer();
+    // These thumbnails are used for the clip monitor and bin previews, where keyframe accuracy is enough
+    m_prod = ThumbnailProducerPool::get()->acquire(m_binClip, m_inPoint, true);
     if ((m_prod == nullptr) || !m_prod->is_valid()) {
         qDebug() << "********\nCOULD NOT READ THUMB PRODUCER\n********";
+        ThumbnailProducerPool::get()->release(m_binClip->clipId(), m_prod, m_inPoint);
+        m_prod.reset();
         return false;
     }
     int duration = m_outPoint > 0 ? m_outPoint - m_inPoint : (int)m_binClip->frameDuration();
@@ -98,6 +102,7 @@ bool CacheJob::startJob()
     }
     int size = (int)frames.size();
     int count = 0;
+    int lastFrame = m_inPoint;
     for (int i : frames) {
         emit jobProgress(100 * count / size);
         count++;
@@ -115,10 +120,13 @@ bool CacheJob::startJob()
         frame->set("rescale.interp", "nearest");
         if (frame != nullptr && frame->is_valid()) {
             QImage result = KThumb::getFrame(frame.data(), 0, 0, m_fullWidth);
-            ThumbnailCache::get()->storeThumbnail(m_clipId, i, result, true);
+            ThumbnailCache::get()->storeThumbnail(m_clipId, i, result, true, true);
+            lastFrame = i;
         }
         m_semaphore.release(1);
     }
+    ThumbnailProducerPool::get()->release(m_binClip->clipId(), m_prod, lastFrame);
+    m_prod.reset();
     m_done = true;
     return true;
 }
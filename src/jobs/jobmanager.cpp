@@ -25,24 +25,117 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "bin/projectclip.h"
 #include "bin/projectitemmodel.h"
 #include "core.h"
+#include "kdenlivesettings.h"
 #include "macros.hpp"
 #include "undohelper.hpp"
 
 #include <KMessageWidget>
 #include <QFuture>
 #include <QFutureWatcher>
+#include <QRunnable>
 #include <QThread>
 
+/** @class JobWorker
+ *  @brief Runs the next task of a lane. One worker is started for each queued task, but it only picks the
+ *  task from the queue when it starts, so that priorities are evaluated as late as possible.
+ */
+class JobWorker : public QRunnable
+{
+public:
+    JobWorker(JobManager *manager, JobManager::JobLane lane)
+        : m_manager(manager)
+        , m_lane(lane)
+    {
+    }
+    void run() override { m_manager->runNextTask(m_lane); }
+
+private:
+    JobManager *m_manager;
+    JobManager::JobLane m_lane;
+};
+
 int JobManager::m_currentId = 0;
 JobManager::JobManager(QObject *parent)
     : QAbstractListModel(parent)
     , m_lock(QReadWriteLock::Recursive)
 {
+    updateThreadCount();
 }
 
 JobManager::~JobManager()
 {
     //slotCancelJobs();
+    m_cpuPool.clear();
+    m_processPool.clear();
+    m_thumbnailPool.clear();
+    m_cpuPool.waitForDone();
+    m_processPool.waitForDone();
+    m_thumbnailPool.waitForDone();
+}
+
+void JobManager::updateThreadCount()
+{
+    int cpuThreads = KdenliveSettings::cpujobthreads();
+    if (cpuThreads <= 0) {
+        cpuThreads = QThread::idealThreadCount();
+    }
+    m_cpuPool.setMaxThreadCount(qMax(1, cpuThreads));
+    // The clip job setting covers loading and thumbnail jobs
+    m_thumbnailPool.setMaxThreadCount(qMax(1, cpuThreads));
+    m_processPool.setMaxThreadCount(qMax(1, KdenliveSettings::processjobthreads()));
+}
+
+JobManager::JobLane JobManager::jobLane(AbstractClipJob::JOBTYPE type)
+{
+    switch (type) {
+    case AbstractClipJob::LOADJOB:
+        return CpuLane;
+    case AbstractClipJob::THUMBJOB:
+    case AbstractClipJob::CACHEJOB:
+        return ThumbnailLane;
+    default:
+        return ProcessLane;
+    }
+}
+
+QThreadPool &JobManager::lanePool(JobLane lane)
+{
+    switch (lane) {
+    case CpuLane:
+        return m_cpuPool;
+    case ThumbnailLane:
+        return m_thumbnailPool;
+    default:
+        return m_processPool;
+    }
+}
+
+std::map<std::pair<int, int>, JobTask> &JobManager::laneQueue(JobLane lane)
+{
+    switch (lane) {
+    case CpuLane:
+        return m_cpuQueue;
+    case ThumbnailLane:
+        return m_thumbnailQueue;
+    default:
+        return m_processQueue;
+    }
+}
+
+int JobManager::jobPriority(AbstractClipJob::JOBTYPE type)
+{
+    switch (type) {
+    case AbstractClipJob::LOADJOB:
+        return 30;
+    case AbstractClipJob::THUMBJOB:
+        return 20;
+    case AbstractClipJob::AUDIOTHUMBJOB:
+        return 10;
+    case AbstractClipJob::CACHEJOB:
+        return 5;
+    default:
+        return 0;
+    }
 }
 
 int JobManager::getBlockingJobId(const QString &id, AbstractClipJob::JOBTYPE type)
@@ -239,8 +332,65 @@ void JobManager::createJob(const std::shared_ptr<Job_t> &job)
     connect(&job->m_future, &QFutureWatcher<bool>::started, this, &JobManager::updateJobCount);
     connect(&job->m_future, &QFutureWatcher<bool>::finished, [this, id = job->m_id]() { if (m_jobs.count(id)> 0) slotManageFinishedJob(id); });
     connect(&job->m_future, &QFutureWatcher<bool>::canceled, [this, id = job->m_id]() { slotManageCanceledJob(id); });
-    job->m_actualFuture = QtConcurrent::mapped(job->m_job, AbstractClipJob::execute);
+    job->m_pendingTasks = int(job->m_job.size());
+    job->m_actualFuture = job->m_interface.future();
     job->m_future.setFuture(job->m_actualFuture);
+    if (job->m_job.empty()) {
+        job->m_interface.reportStarted();
+        job->m_interface.reportFinished();
+        return;
+    }
+    JobLane lane = jobLane(job->m_type);
+    int priority = jobPriority(job->m_type);
+    QMutexLocker queueLock(&m_queueMutex);
+    auto &queue = laneQueue(lane);
+    for (size_t i = 0; i < job->m_job.size(); ++i) {
+        queue[{-priority, m_taskSequence++}] = JobTask{job, i};
+        lanePool(lane).start(new JobWorker(this, lane));
+    }
+}
+
+void JobManager::runNextTask(JobLane lane)
+{
+    JobTask task;
+    {
+        QMutexLocker queueLock(&m_queueMutex);
+        auto &queue = laneQueue(lane);
+        if (queue.empty()) {
+            return;
+        }
+        task = queue.begin()->second;
+        queue.erase(queue.begin());
+    }
+    std::shared_ptr<Job_t> job = task.m_job;
+    if (!job->m_interface.isCanceled()) {
+        job->m_interface.reportStarted();
+        bool result = AbstractClipJob::execute(job->m_job[task.m_index]);
+        job->m_interface.reportResult(result, int(task.m_index));
+    }
+    if (--job->m_pendingTasks == 0) {
+        job->m_interface.reportFinished();
+    }
+}
+
+void JobManager::prioritizeClip(const QString &binId)
+{
+    QMutexLocker queueLock(&m_queueMutex);
+    for (auto *queue : {&m_cpuQueue, &m_processQueue, &m_thumbnailQueue}) {
+        std::vector<JobTask> tasks;
+        for (auto it = queue->begin(); it != queue->end();) {
+            if (it->second.m_job->m_job[it->second.m_index]->clipId() == binId) {
+                tasks.push_back(it->second);
+                it = queue->erase(it);
+            } else {
+                ++it;
+            }
+        }
+        // Keep the type priorities between the tasks of this clip, but before all other tasks
+        for (const JobTask &task : tasks) {
+            queue->insert({{-jobPriority(task.m_job->m_type) - 1000, m_taskSequence++}, task});
+        }
+    }
 }
 
 void JobManager::slotManageCanceledJob(int id)
@@ -345,7 +495,7 @@ void JobManager::slotManageFinishedJob(int id)
         std::vector<int> children = m_jobsByParents[id];
         for (int cid : children) {
             if (!m_jobs[cid]->m_processed) {
-                QtConcurrent::run(this, &JobManager::createJob, m_jobs[cid]);
+                createJob(m_jobs[cid]);
             }
         }
         m_jobsByParents.erase(id);
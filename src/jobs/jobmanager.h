@@ -27,9 +27,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "definitions.h"
 
 #include <QAbstractListModel>
+#include <QFutureInterface>
 #include <QFutureWatcher>
+#include <QMutex>
 #include <QObject>
 #include <QReadWriteLock>
+#include <QThreadPool>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <unordered_map>
@@ -52,6 +56,8 @@ struct Job_t
     std::unordered_map<QString, size_t> m_indices;       // keys are binIds, value are ids in the vectors m_job and m_progress;
     QFutureWatcher<bool> m_future;                       // future of the job
     QFuture<bool> m_actualFuture;
+    QFutureInterface<bool> m_interface;                  // reports the results of the tasks of this job to m_actualFuture
+    std::atomic<int> m_pendingTasks{0};                  // number of clips of this job that are not processed yet
     QMutex m_completionMutex; // mutex that is locked during execution of the process
     AbstractClipJob::JOBTYPE m_type;
     QString m_undoString;
@@ -60,6 +66,13 @@ struct Job_t
     bool m_failed = false;    // flag that we set to true when a problem occurred
 };
 
+/** @brief The processing of one clip of a job, waiting for a worker of its lane */
+struct JobTask
+{
+    std::shared_ptr<Job_t> m_job;
+    size_t m_index = 0; // index of the clip in m_job->m_job
+};
+
 
 class JobManager : public QAbstractListModel, public enable_shared_from_this_virtual<JobManager>
 {
@@ -127,14 +140,32 @@ public:
     /** @brief return the message of a given job on a given clip (message, detailed log)*/
     QPair<QString, QString> getJobMessageForClip(int jobId, const QString &binId) const;
 
+    /** @brief Move the pending tasks of a clip (for example the one selected in the bin) in front of their queues */
+    void prioritizeClip(const QString &binId);
+
+    /** @brief Read the worker counts of the job lanes from the settings, called again when the settings change */
+    void updateThreadCount();
+
     // Mandatory overloads
     QVariant data(const QModelIndex &index, int role) const override;
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 
 protected:
+    friend class JobWorker;
     // Helper function to launch a given job.
-    // This has to be launched asynchrnously since it blocks until all parents are finished
+    // Its parents must be finished, the clips are queued in the lane matching the job type
     void createJob(const std::shared_ptr<Job_t> &job);
+    /** @brief The job lanes, each one has its own workers and task queue */
+    enum JobLane { CpuLane, ProcessLane, ThumbnailLane };
+    /** @brief Run the highest priority task of a lane, called by the lane workers */
+    void runNextTask(JobLane lane);
+    /** @brief Jobs mostly waiting for an external process (ffmpeg, melt) run in a separate lane than cpu bound jobs.
+     *  Jobs using the thumbnail producer pool have their own lane, as they may wait for a producer of their clip */
+    static JobLane jobLane(AbstractClipJob::JOBTYPE type);
+    QThreadPool &lanePool(JobLane lane);
+    std::map<std::pair<int, int>, JobTask> &laneQueue(JobLane lane);
+    /** @brief Priority of a job type in its lane, higher runs first */
+    static int jobPriority(AbstractClipJob::JOBTYPE type);
 
     void updateJobCount();
 
@@ -159,6 +190,19 @@ private:
     /** @brief List of all the jobs by clip. */
     std::unordered_map<QString, std::vector<int>> m_jobsByClip;
     std::unordered_map<int, std::vector<int>> m_jobsByParents;
+    /** @brief Workers for cpu bound jobs (loading) */
+    QThreadPool m_cpuPool;
+    /** @brief Workers for jobs running an external process (proxies, transcoding, audio thumbnails) */
+    QThreadPool m_processPool;
+    /** @brief Workers for thumbnail jobs, which can block while all the thumbnail producers of their clip are in use */
+    QThreadPool m_thumbnailPool;
+    /** @brief Protects the task queues */
+    QMutex m_queueMutex;
+    /** @brief Pending tasks, keyed by (-priority, sequence) so that the first one is the next to run */
+    std::map<std::pair<int, int>, JobTask> m_cpuQueue;
+    std::map<std::pair<int, int>, JobTask> m_processQueue;
+    std::map<std::pair<int, int>, JobTask> m_thumbnailQueue;
+    int m_taskSequence{0};
 
 signals:
     void jobCount(int);
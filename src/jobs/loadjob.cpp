@@ -31,6 +31,7 @@
 #include "macros.hpp"
 #include "profiles/profilemodel.hpp"
 #include "project/dialogs/slideshowclip.h"
+#include "utils/mediaprobecache.hpp"
 #include "effects/effectsrepository.hpp"
 #include "effects/effectstack/model/effectstackmodel.hpp"
 #include "monitor/monitor.h"
@@ -268,6 +269,7 @@ bool LoadJob::startJob()
     m_resource = Xml::getXmlProperty(m_xml, QStringLiteral("resource"));
     int duration = 0;
     ClipType::ProducerType type = static_cast<ClipType::ProducerType>(m_xml.attribute(QStringLiteral("type")).toInt());
+    bool fromProbeCache = false;
     QString service = Xml::getXmlProperty(m_xml, QStringLiteral("mlt_service"));
     if (type == ClipType::Unknown) {
         type = getTypeForService(service, m_resource);
@@ -391,6 +393,25 @@ bool LoadJob::startJob()
         break;
     }
     default:
+        if (KdenliveSettings::mediaprobecache() && (service.isEmpty() || service.startsWith(QLatin1String("avformat")))) {
+            // Only files that were opened by avformat are in the cache, no need to check the service further
+            QMap<QString, QString> properties;
+            // Entries stored from a project have no length, the file must be probed
+            if (MediaProbeCache::get()->lookup(m_resource, properties) && properties.contains(QStringLiteral("length"))) {
+                m_producer = loadResource(m_resource, QStringLiteral("avformat-novalidate:"));
+                if (m_producer->is_valid()) {
+                    QMapIterator<QString, QString> i(properties);
+                    while (i.hasNext()) {
+                        i.next();
+                        m_producer->set(i.key().toUtf8().constData(), i.value().toUtf8().constData());
+                    }
+                    fromProbeCache = true;
+                }
+            }
+        }
+        if (fromProbeCache) {
+            break;
+        }
         if (!service.isEmpty()) {
             service.append(QChar(':'));
             m_producer = loadResource(m_resource, service);
@@ -411,6 +432,9 @@ bool LoadJob::startJob()
         m_errorMessage.append(i18n("ERROR: Could not load clip %1: producer is invalid", m_resource));
         return false;
     }
+    if (!fromProbeCache && KdenliveSettings::mediaprobecache() && qstrcmp(m_producer->get("mlt_service"), "avformat") == 0) {
+        MediaProbeCache::get()->store(m_resource, m_producer.get());
+    }
     processProducerProperties(m_producer, m_xml);
     QString clipName = Xml::getXmlProperty(m_xml, QStringLiteral("kdenlive:clipname"));
     if (clipName.isEmpty()) {
@@ -491,7 +515,7 @@ bool LoadJob::startJob()
             m_producer->set("length", fixedLength);
             m_producer->set("out", fixedLength - 1);
         }
-    } else if (mltService == QLatin1String("avformat")) {
+    } else if (mltService == QLatin1String("avformat") || mltService == QLatin1String("avformat-novalidate")) {
         // check if there are multiple streams
         vindex = m_producer->get_int("video_index");
         // List streams
@@ -531,6 +555,10 @@ bool LoadJob::startJob()
             vindex = -1;
         }
     }
+    if (fromProbeCache) {
+        MediaProbeCache::get()->revalidate(m_clipId, m_resource);
+        MediaProbeCache::get()->startRevalidation();
+    }
     m_done = m_successful = true;
     return true;
 }
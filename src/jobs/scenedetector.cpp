@@ -0,0 +1,154 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "scenedetector.hpp"
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Scores below this value are not stored
+const float MinimumThreshold = 0.05f;
+// A mean cell difference of half the luma range is considered a complete change
+const float CellRange = 128.f;
+} // namespace
+
+SceneDetector::Signature SceneDetector::signature(const uchar *luma, int width, int height, int pixelStride, int lineStride)
+{
+    Signature result;
+    if (luma == nullptr || width < GridSize || height < GridSize) {
+        return result;
+    }
+    std::array<int, HistogramBins> bins{};
+    std::array<int, GridSize * GridSize> sums{};
+    std::vector<int> columnCell((size_t)width);
+    for (int x = 0; x < width; ++x) {
+        columnCell[(size_t)x] = x * GridSize / width;
+    }
+    for (int y = 0; y < height; ++y) {
+        const uchar *line = luma + (size_t)y * (size_t)lineStride;
+        int *rowSums = sums.data() + (y * GridSize / height) * GridSize;
+        for (int x = 0; x < width; ++x) {
+            const uchar value = line[x * pixelStride];
+            bins[value * HistogramBins / 256]++;
+            rowSums[columnCell[(size_t)x]] += value;
+        }
+    }
+    const float pixels = float(width) * float(height);
+    for (int i = 0; i < HistogramBins; ++i) {
+        result.histogram[(size_t)i] = float(bins[(size_t)i]) / pixels;
+    }
+    // Cells don't all have the same size when the frame size is not a multiple of the grid size
+    for (int row = 0; row < GridSize; ++row) {
+        const int rows = (row + 1) * height / GridSize - row * height / GridSize;
+        for (int column = 0; column < GridSize; ++column) {
+            const int columns = (column + 1) * width / GridSize - column * width / GridSize;
+            const size_t cell = size_t(row * GridSize + column);
+            result.cells[cell] = float(sums[cell]) / float(rows * columns);
+        }
+    }
+    result.valid = true;
+    return result;
+}
+
+float SceneDetector::score(const Signature &previous, const Signature &current)
+{
+    if (!previous.valid || !current.valid) {
+        return 0.f;
+    }
+    float histogramDistance = 0.f;
+    for (int i = 0; i < HistogramBins; ++i) {
+        histogramDistance += std::abs(previous.histogram[(size_t)i] - current.histogram[(size_t)i]);
+    }
+    // Both histograms sum to 1, so the distance is on [0, 2]
+    histogramDistance /= 2.f;
+    float cellDistance = 0.f;
+    for (size_t i = 0; i < current.cells.size(); ++i) {
+        cellDistance += std::abs(previous.cells[i] - current.cells[i]);
+    }
+    cellDistance = std::min(1.f, cellDistance / float(current.cells.size()) / CellRange);
+    return std::min(1.f, std::sqrt(histogramDistance * cellDistance));
+}
+
+QVector<int> SceneDetector::cuts(const std::vector<float> &scores, int firstFrame, float threshold, int minInterval)
+{
+    QVector<int> result;
+    int lastCut = firstFrame;
+    // The first frame has no previous frame to compare with
+    for (size_t i = 1; i < scores.size(); ++i) {
+        const float value = scores[i];
+        if (value < threshold) {
+            continue;
+        }
+        // A transition spanning several frames is cut at its strongest change
+        if (i + 1 < scores.size() && scores[i + 1] > value) {
+            continue;
+        }
+        const int frame = firstFrame + int(i);
+        if (frame - lastCut < minInterval) {
+            continue;
+        }
+        result << frame;
+        lastCut = frame;
+    }
+    return result;
+}
+
+QString SceneDetector::serializeScores(const std::vector<float> &scores, int firstFrame, const QString &fileHash)
+{
+    // The file hash and the analysed range come first, then the frames with a significant score
+    QStringList result{fileHash, QStringLiteral("%1:%2").arg(firstFrame).arg(firstFrame + int(scores.size()) - 1)};
+    for (size_t i = 0; i < scores.size(); ++i) {
+        if (scores[i] >= MinimumThreshold) {
+            result << QStringLiteral("%1=%2").arg(firstFrame + int(i)).arg(double(scores[i]), 0, 'f', 3);
+        }
+    }
+    return result.join(QLatin1Char(';'));
+}
+
+bool SceneDetector::parseScores(const QString &data, const QString &fileHash, int firstFrame, int lastFrame, std::vector<float> &scores)
+{
+    const QStringList entries = data.split(QLatin1Char(';'), QString::SkipEmptyParts);
+    // Scores of another file, or of a replaced one, are useless
+    if (entries.count() < 2 || fileHash.isEmpty() || entries.constFirst() != fileHash || lastFrame < firstFrame) {
+        return false;
+    }
+    bool okIn = false;
+    bool okOut = false;
+    const int in = entries.at(1).section(QLatin1Char(':'), 0, 0).toInt(&okIn);
+    const int out = entries.at(1).section(QLatin1Char(':'), 1, 1).toInt(&okOut);
+    if (!okIn || !okOut || in > firstFrame || out < lastFrame) {
+        return false;
+    }
+    scores.assign(size_t(lastFrame - firstFrame + 1), 0.f);
+    for (int i = 2; i < entries.count(); ++i) {
+        const QString &entry = entries.at(i);
+        const int frame = entry.section(QLatin1Char('='), 0, 0).toInt();
+        if (frame > firstFrame && frame <= lastFrame) {
+            scores[size_t(frame - firstFrame)] = entry.section(QLatin1Char('='), 1, 1).toFloat();
+        }
+    }
+    return true;
+}
+
+float SceneDetector::minimumThreshold()
+{
+    return MinimumThreshold;
+}
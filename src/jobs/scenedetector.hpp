@@ -0,0 +1,80 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <array>
+#include <vector>
+
+/** @brief This class scores the changes between consecutive video frames to find the scene cuts.
+    Each frame is reduced to a signature computed from its downscaled luma: a histogram, and the mean luma of the cells of a grid.
+    The score of a frame compares its signature with the one of the previous frame. The histogram distance is not sensitive to motion,
+    the grid difference is not sensitive to global lighting changes: the score is their geometric mean, so that both have to be high.
+    Scores are stored in the clip metadata, so that the cuts can be detected again with another threshold without decoding the clip.
+ */
+
+class SceneDetector
+{
+
+public:
+    static const int HistogramBins = 32;
+    static const int GridSize = 8;
+
+    struct Signature
+    {
+        // Part of the pixels in each luma bin
+        std::array<float, HistogramBins> histogram;
+        // Mean luma of each grid cell, row by row
+        std::array<float, GridSize * GridSize> cells;
+        bool valid = false;
+    };
+
+    /* @brief Computes the signature of a luma plane of width x height samples
+       @param pixelStride is the number of bytes between two samples of a line (2 for packed yuv422)
+       @param lineStride is the number of bytes between two lines
+    */
+    static Signature signature(const uchar *luma, int width, int height, int pixelStride, int lineStride);
+
+    /* @brief Returns the change score between two consecutive frames, between 0 (same frame) and 1 */
+    static float score(const Signature &previous, const Signature &current);
+
+    /* @brief Returns the frames starting a new scene
+       @param scores holds the score of each frame, starting at firstFrame
+       @param threshold is the minimum score of a cut
+       @param minInterval is the minimum number of frames between two cuts, and between firstFrame and the first cut
+    */
+    static QVector<int> cuts(const std::vector<float> &scores, int firstFrame, float threshold, int minInterval);
+
+    /* @brief Returns the scores of frames starting at firstFrame as a string suitable for the clip metadata.
+       Scores below the minimum threshold are not stored.
+       @param fileHash is the hash of the analysed file, stored with the scores
+    */
+    static QString serializeScores(const std::vector<float> &scores, int firstFrame, const QString &fileHash);
+
+    /* @brief Reads the scores of frames firstFrame to lastFrame from data created by serializeScores
+       @returns false if data does not cover the whole range, or was not computed from a file with the given hash
+    */
+    static bool parseScores(const QString &data, const QString &fileHash, int firstFrame, int lastFrame, std::vector<float> &scores);
+
+    /* @brief The lowest threshold accepted when detecting cuts from stored scores */
+    static float minimumThreshold();
+};
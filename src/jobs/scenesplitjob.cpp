@@ -22,62 +22,181 @@
  ***************************************************************************/
 
 #include "scenesplitjob.hpp"
-#include "bin/clipcreator.hpp"
 #include "bin/model/markerlistmodel.hpp"
 #include "bin/projectclip.h"
-#include "bin/projectfolder.h"
 #include "bin/projectitemmodel.h"
 #include "core.h"
 #include "jobmanager.h"
 #include "kdenlivesettings.h"
-#include "project/clipstabilize.h"
+#include "klocalizedstring.h"
+#include "macros.hpp"
+#include "profiles/profilemodel.hpp"
+#include "scenedetector.hpp"
 #include "ui_scenecutdialog_ui.h"
+#include "utils/mediaprobecache.hpp"
 
+#include <QApplication>
+#include <QDialog>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QScopedPointer>
+#include <QThread>
+#include <QtConcurrent>
 
 #include <mlt++/Mlt.h>
 
-SceneSplitJob::SceneSplitJob(const QString &binId, bool subClips, int markersType, int minInterval)
-    : MeltJob(binId, STABILIZEJOB, true, -1, -1)
+namespace {
+// Height of the decoded frames, the detector only needs a coarse picture
+const int AnalysisHeight = 90;
+// Minimum number of frames analysed by each thread, opening another producer is not worth it for shorter ranges
+const int MinRangeFrames = 500;
+
+QString scoresProperty()
+{
+    return QStringLiteral("kdenlive:clipanalysis.scenescores");
+}
+} // namespace
+
+SceneSplitJob::SceneSplitJob(const QString &binId, bool subClips, int markersType, int minInterval, double threshold, bool zoneOnly, bool storeData)
+    : AbstractClipJob(ANALYSECLIPJOB, binId)
     , m_subClips(subClips)
     , m_markersType(markersType)
     , m_minInterval(minInterval)
+    , m_threshold(threshold)
+    , m_zoneOnly(zoneOnly)
+    , m_storeData(storeData)
 {
+    connect(this, &SceneSplitJob::jobCanceled, [&]() { m_canceled = true; });
 }
 
 const QString SceneSplitJob::getDescription() const
 {
     return i18n("Scene split");
 }
-void SceneSplitJob::configureConsumer()
+
+std::unique_ptr<Mlt::Producer> SceneSplitJob::createProducer()
 {
-    m_consumer = std::make_unique<Mlt::Consumer>(*m_profile.get(), "null");
-    m_consumer->set("all", 1);
-    m_consumer->set("terminate_on_pause", 1);
-    m_consumer->set("real_time", -KdenliveSettings::mltthreads());
-    // We just want to find scene change, set all methods to the fastests
-    m_consumer->set("rescale", "nearest");
-    m_consumer->set("deinterlace_method", "onefield");
-    m_consumer->set("top_field_first", -1);
+    Mlt::Profile &profile = pCore->getCurrentProfile()->profile();
+    std::unique_ptr<Mlt::Producer> producer;
+    if (KdenliveSettings::gpu_accel()) {
+        producer = m_binClip->getClone();
+        Mlt::Filter converter(profile, "avcolor_space");
+        producer->attach(converter);
+    } else {
+        producer = std::make_unique<Mlt::Producer>(profile, m_binClip->url().toUtf8().constData());
+    }
+    if (producer && producer->is_valid() && QString(producer->get("mlt_service")).startsWith(QLatin1String("avformat"))) {
+        // Deblocking does not change the detected cuts, skip it to decode faster
+        producer->set("skip_loop_filter", "all");
+    }
+    return producer;
 }
 
-void SceneSplitJob::configureFilter()
+void SceneSplitJob::analyseRange(Mlt::Producer *producer, int start, int end)
 {
-    m_filter = std::make_unique<Mlt::Filter>(*m_profile.get(), "motion_est");
-    if ((m_filter == nullptr) || !m_filter->is_valid()) {
-        m_errorMessage.append(i18n("Cannot create filter motion_est. Cannot split scenes"));
-        return;
+    const int total = m_out - m_in + 1;
+    SceneDetector::Signature previous;
+    // The first frame of a range is compared with the last frame of the previous range
+    for (int position = start > m_in ? start - 1 : start; position < end && !m_canceled; ++position) {
+        producer->seek(position);
+        std::unique_ptr<Mlt::Frame> frame(producer->get_frame());
+        SceneDetector::Signature current;
+        if (frame && frame->is_valid()) {
+            frame->set("deinterlace_method", "onefield");
+            frame->set("top_field_first", -1);
+            frame->set("rescale.interp", "nearest");
+            mlt_image_format format = mlt_image_yuv422;
+            int width = m_width;
+            int height = m_height;
+            const uchar *image = frame->get_image(format, width, height);
+            if (format == mlt_image_yuv422) {
+                // Packed Y0 U Y1 V, luma is one byte out of two
+                current = SceneDetector::signature(image, width, height, 2, 2 * width);
+            }
+        }
+        if (position >= start) {
+            m_scores[size_t(position - m_in)] = SceneDetector::score(previous, current);
+            // Only report progress when the percentage changes, from whichever range reaches it first
+            const int progress = 100 * ++m_processedFrames / total;
+            int last = m_lastProgress.load();
+            if (progress > last && m_lastProgress.compare_exchange_strong(last, progress)) {
+                emit jobProgress(progress);
+            }
+        }
+        previous = current;
     }
-
-    m_filter->set("shot_change_list", 0);
-    m_filter->set("denoise", 0);
-    m_filter->set_in_and_out(0, length - 1);
 }
 
-void SceneSplitJob::configureProfile()
+bool SceneSplitJob::startJob()
 {
-    m_profile->set_height(160);
-    m_profile->set_width(m_profile->height() * m_profile->sar());
+    m_binClip = pCore->projectItemModel()->getClipByBinID(m_clipId);
+    if (m_binClip == nullptr || m_canceled) {
+        // Clip was deleted or job aborted
+        m_done = true;
+        return false;
+    }
+    if (m_binClip->url().isEmpty()) {
+        m_errorMessage.append(i18n("No producer for this clip."));
+        m_done = true;
+        return false;
+    }
+    m_in = 0;
+    m_out = (int)m_binClip->frameDuration() - 1;
+    if (m_zoneOnly) {
+        QPoint zone = m_binClip->zone();
+        if (zone.y() > zone.x()) {
+            m_in = qMax(0, zone.x());
+            m_out = qMin(m_out, zone.y());
+        }
+    }
+    if (m_out <= m_in) {
+        m_errorMessage.append(i18n("Invalid clip"));
+        m_done = true;
+        return false;
+    }
+    if (m_storeData) {
+        // Scores stored by a previous analysis of the same file only need the new threshold
+        m_fileHash = MediaProbeCache::get()->fileHash(m_binClip->url());
+        if (SceneDetector::parseScores(m_binClip->getProducerProperty(scoresProperty()), m_fileHash, m_in, m_out, m_scores)) {
+            m_storedScores = true;
+            m_successful = m_done = true;
+            return true;
+        }
+    }
+
+    const int frames = m_out - m_in + 1;
+    m_scores.assign(size_t(frames), 0.f);
+    m_height = AnalysisHeight;
+    m_width = 2 * qRound(AnalysisHeight * pCore->getCurrentDar() / 2);
+    // Long clips are split in ranges analysed in parallel, each range needs its own producer
+    const int rangeCount = qBound(1, frames / MinRangeFrames, QThread::idealThreadCount());
+    std::vector<std::unique_ptr<Mlt::Producer>> producers;
+    for (int i = 0; i < rangeCount; ++i) {
+        std::unique_ptr<Mlt::Producer> producer = createProducer();
+        if (!producer || !producer->is_valid()) {
+            break;
+        }
+        producers.push_back(std::move(producer));
+    }
+    if (producers.empty()) {
+        m_errorMessage.append(i18n("Invalid clip"));
+        m_done = true;
+        return false;
+    }
+    const int rangeSize = (frames + int(producers.size()) - 1) / int(producers.size());
+    QVector<int> ranges;
+    for (int i = 0; i < (int)producers.size(); ++i) {
+        ranges << i;
+    }
+    QtConcurrent::blockingMap(ranges, [&](int range) {
+        const int start = m_in + range * rangeSize;
+        const int end = qMin(m_out + 1, start + rangeSize);
+        analyseRange(producers.at((size_t)range).get(), start, end);
+    });
+    m_done = true;
+    m_successful = !m_canceled;
+    return m_successful;
 }
 
 // static
@@ -93,22 +212,24 @@ int SceneSplitJob::prepareJob(const std::shared_ptr<JobManager> &ptr, const std:
         ui.marker_type->setItemData((int)i, MarkerListModel::markerTypes[i], Qt::DecorationRole);
     }
     ui.marker_type->setCurrentIndex(KdenliveSettings::default_marker_type());
-    ui.zone_only->setEnabled(false);  // not implemented
-    ui.store_data->setEnabled(false); // not implemented
+    // Stored scores are only available above the minimum threshold
+    ui.threshold->setMinimum(qRound(100 * SceneDetector::minimumThreshold()));
     if (d->exec() != QDialog::Accepted) {
         return -1;
     }
     int markersType = ui.add_markers->isChecked() ? ui.marker_type->currentIndex() : -1;
     bool subclips = ui.cut_scenes->isChecked();
     int minInterval = ui.minDuration->value();
+    double threshold = ui.threshold->value() / 100.;
+    bool zoneOnly = ui.zone_only->isChecked();
+    bool storeData = ui.store_data->isChecked();
 
-    return ptr->startJob_noprepare<SceneSplitJob>(binIds, parentId, std::move(undoString), subclips, markersType, minInterval);
+    return ptr->startJob_noprepare<SceneSplitJob>(binIds, parentId, std::move(undoString), subclips, markersType, minInterval, threshold, zoneOnly,
+                                                  storeData);
 }
 
 bool SceneSplitJob::commitResult(Fun &undo, Fun &redo)
 {
-    Q_UNUSED(undo)
-    Q_UNUSED(redo)
     Q_ASSERT(!m_resultConsumed);
     if (!m_done) {
         qDebug() << "ERROR: Trying to consume invalid results";
@@ -118,25 +239,39 @@ bool SceneSplitJob::commitResult(Fun &undo, Fun &redo)
     if (!m_successful) {
         return false;
     }
-    QString result = QString::fromLatin1(m_filter->get("shot_change_list"));
-    if (result.isEmpty()) {
-        m_errorMessage.append(i18n("No data returned from clip analysis"));
+    auto binClip = pCore->projectItemModel()->getClipByBinID(m_clipId);
+    if (!binClip) {
         return false;
     }
-
-    auto binClip = pCore->projectItemModel()->getClipByBinID(m_clipId);
-    QStringList markerData = result.split(QLatin1Char(';'));
-    if (m_markersType >= 0) {
+    const QVector<int> cuts = SceneDetector::cuts(m_scores, m_in, float(m_threshold), m_minInterval);
+    if (m_storeData && !m_storedScores && !m_fileHash.isEmpty()) {
+        const QString oldData = binClip->getProducerProperty(scoresProperty());
+        const QString newData = SceneDetector::serializeScores(m_scores, m_in, m_fileHash);
+        auto operation = [clipId = m_clipId, newData]() {
+            auto clip = pCore->projectItemModel()->getClipByBinID(clipId);
+            if (!clip) {
+                return false;
+            }
+            clip->setProperties(QMap<QString, QString>{{scoresProperty(), newData}});
+            return true;
+        };
+        auto reverse = [clipId = m_clipId, oldData]() {
+            auto clip = pCore->projectItemModel()->getClipByBinID(clipId);
+            if (!clip) {
+                return false;
+            }
+            clip->setProperties(QMap<QString, QString>{{scoresProperty(), oldData}});
+            return true;
+        };
+        if (operation()) {
+            UPDATE_UNDO_REDO_NOLOCK(operation, reverse, undo, redo);
+        }
+    }
+    if (m_markersType >= 0 && !cuts.isEmpty()) {
         // Build json data for markers
         QJsonArray list;
         int ix = 1;
-        int lastCut = 0;
-        for (const QString &marker : markerData) {
-            int pos = marker.section(QLatin1Char('='), 0, 0).toInt();
-            if (m_minInterval > 0 && ix > 1 && pos - lastCut < m_minInterval) {
-                continue;
-            }
-            lastCut = pos;
+        for (int pos : cuts) {
             QJsonObject currentMarker;
             currentMarker.insert(QLatin1String("pos"), QJsonValue(pos));
             currentMarker.insert(QLatin1String("comment"), QJsonValue(i18n("Scene %1", ix)));
@@ -148,15 +283,14 @@ bool SceneSplitJob::commitResult(Fun &undo, Fun &redo)
         binClip->getMarkerModel()->importFromJson(QString(json.toJson()), true, undo, redo);
     }
     if (m_subClips) {
-        // Create zones
+        // Create zones, the last one ends with the analysed range
+        QVector<int> bounds = cuts;
+        bounds << m_out + 1;
         int ix = 1;
-        int lastCut = 0;
-        QMap<QString, QString> zoneData;
+        int lastCut = m_in;
         QJsonArray list;
-        QJsonDocument json(list);
-        for (const QString &marker : markerData) {
-            int pos = marker.section(QLatin1Char('='), 0, 0).toInt();
-            if (pos <= lastCut + 1 || pos - lastCut < m_minInterval) {
+        for (int pos : bounds) {
+            if (pos <= lastCut + 1) {
                 continue;
             }
             QJsonObject currentZone;
@@ -167,12 +301,11 @@ bool SceneSplitJob::commitResult(Fun &undo, Fun &redo)
             lastCut = pos;
             ix++;
         }
-        if (!json.isEmpty()) {
+        if (!list.isEmpty()) {
+            QJsonDocument json(list);
             pCore->projectItemModel()->loadSubClips(m_clipId, QString(json.toJson()), undo, redo);
         }
     }
-    qDebug() << "RESULT of the SCENESPLIT filter:" << result;
-
-    // TODO refac: reimplement add markers and subclips
+    qDebug() << "Scene detection found" << cuts.size() << "cuts in clip" << m_clipId << (m_storedScores ? "from stored scores" : "");
     return true;
 }
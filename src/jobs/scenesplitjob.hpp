@@ -23,18 +23,27 @@
 
 #pragma once
 
-#include "meltjob.h"
-#include <unordered_map>
-#include <unordered_set>
+#include "abstractclipjob.h"
+#include <atomic>
+#include <memory>
+#include <vector>
 
 /**
  * @class SceneSplitJob
- * @brief Detects the scenes of a clip using a mlt filter
+ * @brief Detects the scenes of a clip by comparing the luma of consecutive frames
  *
+ * The clip (or its zone) is split in ranges decoded in parallel at a low resolution, each range with its own producer.
+ * The change score of each frame is computed by SceneDetector. Scores can be stored in the clip metadata with the file hash:
+ * running the job again with stored data on an unchanged clip only applies the new threshold, without decoding it.
  */
 
+class ProjectClip;
+namespace Mlt {
+class Producer;
+}
+
 class JobManager;
-class SceneSplitJob : public MeltJob
+class SceneSplitJob : public AbstractClipJob
 {
     Q_OBJECT
 
@@ -42,29 +51,53 @@ public:
     /** @brief Creates a scenesplit job for the given bin clip
         @param subClips if true, we create a subclip per found scene
         @param markersType The type of markers that will be created to denote scene. Leave -1 for no markers
+        @param minInterval minimum scene duration, in frames
+        @param threshold minimum change score of a cut, between 0 and 1
+        @param zoneOnly if true, only the clip zone is analysed
+        @param storeData if true, the frame scores are saved in the clip metadata, and reused if the file did not change
      */
-    SceneSplitJob(const QString &binId, bool subClips, int markersType = -1, int minInterval = 0);
+    SceneSplitJob(const QString &binId, bool subClips, int markersType = -1, int minInterval = 0, double threshold = 0.3, bool zoneOnly = false,
+                  bool storeData = false);
 
-    // This is a special function that prepares the stabilize job for a given list of clips.
+    // This is a special function that prepares the scene split job for a given list of clips.
     // Namely, it displays the required UI to configure the job and call startJob with the right set of parameters
     // Then the job is automatically put in queue. Its id is returned
     static int prepareJob(const std::shared_ptr<JobManager> &ptr, const std::vector<QString> &binIds, int parentId, QString undoString);
 
+    bool startJob() override;
     bool commitResult(Fun &undo, Fun &redo) override;
     const QString getDescription() const override;
 
 protected:
-    // @brief create and configure consumer
-    void configureConsumer() override;
-
-    // @brief create and configure filter
-    void configureFilter() override;
+    // @brief Returns a producer decoding the clip for analysis
+    std::unique_ptr<Mlt::Producer> createProducer();
 
-    // @brief extra configuration of the profile (eg: resize the profile)
-    void configureProfile() override;
+    // @brief Computes the scores of frames start to end - 1 with the given producer
+    void analyseRange(Mlt::Producer *producer, int start, int end);
 
+    std::shared_ptr<ProjectClip> m_binClip;
     bool m_subClips;
     int m_markersType;
     // @brief minimum scene duration.
     int m_minInterval;
+    double m_threshold;
+    bool m_zoneOnly;
+    bool m_storeData;
+    // @brief analysed frames, m_out included
+    int m_in{0};
+    int m_out{-1};
+    // @brief score of each analysed frame
+    std::vector<float> m_scores;
+    // @brief true if the scores were read from the clip metadata
+    bool m_storedScores{false};
+    // @brief hash of the analysed file, stored scores are only reused if it did not change
+    QString m_fileHash;
+    // @brief size of the decoded frames
+    int m_width{0};
+    int m_height{0};
+
+    bool m_done{false}, m_successful{false};
+    std::atomic<bool> m_canceled{false};
+    std::atomic<int> m_processedFrames{0};
+    std::atomic<int> m_lastProgress{-1};
 };
@@ -28,6 +28,7 @@
 #include "klocalizedstring.h"
 #include "macros.hpp"
 #include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailproducerpool.hpp"
 #include <QPainter>
 #include <QScopedPointer>
 #include <mlt++/MltProducer.h>
@@ -102,9 +103,12 @@ bool ThumbJob::startJob()
         return true;
     }
     m_mutex.lock();
-    m_prod = m_binClip->thumbProducer();
+    m_prod = ThumbnailProducerPool::get()->acquire(m_binClip, m_frameNumber);
     if ((m_prod == nullptr) || !m_prod->is_valid()) {
         qDebug() << "********\nCOULD NOT READ THUMB PRODUCER\n********";
+        ThumbnailProducerPool::get()->release(m_binClip->clipId(), m_prod, m_frameNumber);
+        m_prod.reset();
+        m_mutex.unlock();
         return false;
     }
     int max = m_prod->get_length();
@@ -113,18 +117,19 @@ bool ThumbJob::startJob()
     if (m_frameNumber > 0) {
         m_prod->seek(m_frameNumber);
     }
-    if (m_done) {
-        m_mutex.unlock();
-        return true;
-    }
-    QScopedPointer<Mlt::Frame> frame(m_prod->get_frame());
-    frame->set("deinterlace_method", "onefield");
-    frame->set("top_field_first", -1);
-    frame->set("rescale.interp", "nearest");
-    if ((frame != nullptr) && frame->is_valid()) {
-        m_result = KThumb::getFrame(frame.data(), m_imageWidth, m_imageHeight, m_fullWidth);
-        m_done = true;
+    if (!m_done) {
+        QScopedPointer<Mlt::Frame> frame(m_prod->get_frame());
+        frame->set("deinterlace_method", "onefield");
+        frame->set("top_field_first", -1);
+        frame->set("rescale.interp", "nearest");
+        if ((frame != nullptr) && frame->is_valid()) {
+            m_result = KThumb::getFrame(frame.data(), m_imageWidth, m_imageHeight, m_fullWidth);
+            m_done = true;
+        }
     }
+    // Give the producer back so that other thumbnails of this clip can reuse it
+    ThumbnailProducerPool::get()->release(m_binClip->clipId(), m_prod, m_frameNumber);
+    m_prod.reset();
     m_mutex.unlock();
     return m_done;
 }
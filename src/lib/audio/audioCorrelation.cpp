@@ -14,6 +14,9 @@ the Free Software Foundation, either version 3 of the License, or
 #include "kdenlive_debug.h"
 #include "klocalizedstring.h"
 #include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QMutexLocker>
+#include <QtConcurrent>
 #include <cmath>
 #include <iostream>
 
@@ -27,6 +30,12 @@ AudioCorrelation::AudioCorrelation(std::unique_ptr<AudioEnvelope> mainTrackEnvel
 
 AudioCorrelation::~AudioCorrelation()
 {
+    // Running computations use this object, wait for them
+    for (const PendingBatch &batch : qAsConst(m_pendingBatches)) {
+        const QList<AudioCorrelationInfo *> correlations = batch.correlations.result();
+        qDeleteAll(correlations);
+        qDeleteAll(batch.envelopes);
+    }
     for (AudioEnvelope *envelope : m_children) {
         delete envelope;
     }
@@ -44,43 +53,89 @@ void AudioCorrelation::slotAnnounceEnvelope()
 
 void AudioCorrelation::addChild(AudioEnvelope *envelope)
 {
-    // We need to connect before starting the computation, to make sure
-    // there is no race condition where the signal 'envelopeReady' is
-    // lost.
-    Q_ASSERT(!envelope->hasComputationStarted());
-    connect(envelope, &AudioEnvelope::envelopeReady, this, &AudioCorrelation::slotProcessChild);
-    envelope->startComputeEnvelope();
+    addChildren({envelope});
 }
 
-void AudioCorrelation::slotProcessChild(AudioEnvelope *envelope)
+void AudioCorrelation::addChildren(const QList<AudioEnvelope *> &envelopes)
 {
-    // Note that at this point the computation of the envelope of the
-    // main track might not be finished. envelope() will block until
-    // the computation is done.
-    const size_t sizeMain = m_mainTrackEnvelope->envelope().size();
-    const size_t sizeSub = envelope->envelope().size();
+    for (AudioEnvelope *envelope : envelopes) {
+        Q_ASSERT(!envelope->hasComputationStarted());
+        envelope->startComputeEnvelope();
+    }
+    PendingBatch batch;
+    batch.envelopes = envelopes;
+    batch.correlations = QtConcurrent::run([this, envelopes]() {
+        // Each child waits for its own envelope, so correlate them in parallel
+        QList<QFuture<AudioCorrelationInfo *>> tasks;
+        for (AudioEnvelope *envelope : envelopes) {
+            tasks << QtConcurrent::run(this, &AudioCorrelation::correlateChild, envelope);
+        }
+        QList<AudioCorrelationInfo *> correlations;
+        for (const QFuture<AudioCorrelationInfo *> &task : qAsConst(tasks)) {
+            correlations << task.result();
+        }
+        return correlations;
+    });
+    m_pendingBatches << batch;
+
+    auto *watcher = new QFutureWatcher<QList<AudioCorrelationInfo *>>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher]() {
+        watcher->deleteLater();
+        int batchIndex = -1;
+        for (int i = 0; i < m_pendingBatches.size(); ++i) {
+            if (m_pendingBatches.at(i).correlations == watcher->future()) {
+                batchIndex = i;
+                break;
+            }
+        }
+        if (batchIndex < 0) {
+            return;
+        }
+        const PendingBatch batch = m_pendingBatches.takeAt(batchIndex);
+        const QList<AudioCorrelationInfo *> correlations = batch.correlations.result();
+        QMap<int, int> shifts;
+        for (int i = 0; i < batch.envelopes.size(); ++i) {
+            m_children.append(batch.envelopes.at(i));
+            m_correlations.append(correlations.at(i));
+            Q_ASSERT(m_correlations.size() == m_children.size());
+            int shift = getShift(m_children.size() - 1);
+            shifts.insert(batch.envelopes.at(i)->clipId(), shift);
+        }
+        emit gotAudioAlignBatch(shifts);
+    });
+    watcher->setFuture(batch.correlations);
+}
 
-    auto *info = new AudioCorrelationInfo(sizeMain, sizeSub);
-    qint64 *correlation = info->correlationVector();
+std::shared_ptr<const FFTCorrelation::Reference> AudioCorrelation::fftReference(size_t sizeSub)
+{
+    QMutexLocker lock(&m_fftReferenceMutex);
+    if (!m_fftReference || !m_fftReference->accepts(sizeSub)) {
+        const std::vector<qint64> &envMain = m_mainTrackEnvelope->envelope();
+        m_fftReference = std::make_shared<FFTCorrelation::Reference>(envMain.data(), envMain.size(), sizeSub);
+    }
+    return m_fftReference;
+}
 
+AudioCorrelationInfo *AudioCorrelation::correlateChild(AudioEnvelope *envelope)
+{
+    // Note that at this point the computation of the envelopes might not
+    // be finished. envelope() will block until the computation is done.
     const std::vector<qint64> &envMain = m_mainTrackEnvelope->envelope();
     const std::vector<qint64> &envSub = envelope->envelope();
+    const size_t sizeMain = envMain.size();
+    const size_t sizeSub = envSub.size();
+
+    auto *info = new AudioCorrelationInfo(sizeMain, sizeSub);
+    qint64 *correlation = info->correlationVector();
     qint64 max = 0;
 
     if (sizeSub > 200) {
-        FFTCorrelation::correlate(&envMain[0], sizeMain, &envSub[0], sizeSub, correlation);
+        FFTCorrelation::correlate(*fftReference(sizeSub), envSub.data(), sizeSub, correlation);
     } else {
-        correlate(&envMain[0], sizeMain, &envSub[0], sizeSub, correlation, &max);
+        correlate(envMain.data(), sizeMain, envSub.data(), sizeSub, correlation, &max);
         info->setMax(max);
     }
-
-    m_children.append(envelope);
-    m_correlations.append(info);
-
-    Q_ASSERT(m_correlations.size() == m_children.size());
-    int index = m_children.indexOf(envelope);
-    int shift = getShift(index);
-    emit gotAudioAlignData(envelope->clipId(), shift);
+    return info;
 }
 
 int AudioCorrelation::getShift(int childIndex) const
@@ -14,7 +14,11 @@
 #include "audioCorrelationInfo.h"
 #include "audioEnvelope.h"
 #include "definitions.h"
+#include "fftCorrelation.h"
+#include <QFuture>
 #include <QList>
+#include <QMap>
+#include <QMutex>
 
 /**
   This class does the correlation between two tracks
@@ -53,6 +57,17 @@ public:
       */
     void addChild(AudioEnvelope *envelope);
 
+    /**
+      Aligns several child envelopes at once. Their envelopes are computed
+      in parallel, then correlated in parallel with the reference, whose
+      spectrum is only computed once. When all of them are done,
+      gotAudioAlignBatch is emitted with all the shifts, so that the
+      clips can be moved in a single undo step.
+
+      This object will take ownership of the passed envelopes.
+      */
+    void addChildren(const QList<AudioEnvelope *> &envelopes);
+
     const AudioCorrelationInfo *info(int childIndex) const;
     int getShift(int childIndex) const;
 
@@ -68,19 +83,33 @@ private:
     QList<AudioEnvelope *> m_children;
     QList<AudioCorrelationInfo *> m_correlations;
 
-private slots:
-    /**
-     This is invoked when the child envelope is computed. This
-     triggers the actual computations of the cross-correlation for
-     aligning the envelope to the reference envelope.
+    /** @brief Children whose alignment is being computed */
+    struct PendingBatch
+    {
+        QList<AudioEnvelope *> envelopes;
+        QFuture<QList<AudioCorrelationInfo *>> correlations;
+    };
+    QList<PendingBatch> m_pendingBatches;
+
+    /** @brief Spectrum of the reference envelope, shared by the FFT correlations of all children */
+    std::shared_ptr<FFTCorrelation::Reference> m_fftReference;
+    QMutex m_fftReferenceMutex;
 
-     Takes ownership of @p envelope.
+    /**
+     Computes the cross-correlation of a child envelope with the reference
+     envelope, blocking until both envelopes are computed. Thread safe.
    */
-    void slotProcessChild(AudioEnvelope *envelope);
+    AudioCorrelationInfo *correlateChild(AudioEnvelope *envelope);
+    /** @brief Returns the reference spectrum, computing it if it cannot be used for a child of size @p sizeSub */
+    std::shared_ptr<const FFTCorrelation::Reference> fftReference(size_t sizeSub);
+
+private slots:
     void slotAnnounceEnvelope();
 
 signals:
     void gotAudioAlignData(int, int);
+    /** @brief All children passed to addChildren were aligned, the map contains the shift of each clip id */
+    void gotAudioAlignBatch(const QMap<int, int> &shifts);
     void displayMessage(const QString &, MessageType, int);
 };
 
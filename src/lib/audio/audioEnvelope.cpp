@@ -16,32 +16,70 @@
 #include "kdenlive_debug.h"
 #include <QImage>
 #include <QElapsedTimer>
+#include <QThread>
 #include <QtConcurrent>
 #include <KLocalizedString>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <memory>
+#include <numeric>
+
+// Minimum number of frames analysed by each thread, opening another producer is not worth it for shorter ranges
+static const size_t MIN_RANGE_FRAMES = 1500;
+
+// Sum of the absolute sample values. Blocks are accumulated on 32 bits
+// (32768 * 32768 cannot overflow) so that the compiler can vectorise the loop.
+static qint64 sumAbs(const qint16 *data, int count)
+{
+    const int blockSize = 32768;
+    qint64 sum = 0;
+    for (int start = 0; start < count; start += blockSize) {
+        const int end = std::min(count, start + blockSize);
+        qint32 blockSum = 0;
+        for (int k = start; k < end; ++k) {
+            blockSum += qAbs(qint32(data[k]));
+        }
+        sum += blockSum;
+    }
+    return sum;
+}
 
 AudioEnvelope::AudioEnvelope(const QString &binId, int clipId, size_t offset, size_t length, size_t startPos)
-    : m_offset(offset)
+    : m_samplingRate(0)
+    , m_clipDuration(0)
+    , m_zoneStart(0)
+    , m_offset(offset)
     , m_clipId(clipId)
     , m_startpos(startPos)
+    , m_envelopeSize(0)
 {
+    connect(&m_watcher, &QFutureWatcherBase::finished, this, [this] { envelopeReady(this); });
     std::shared_ptr<ProjectClip> clip = pCore->bin()->getBinClip(binId);
-    m_producer = clip->cloneProducer();
-    if (length > 2000) {
+    if (!clip || !clip->audioInfo()) {
+        qCDebug(KDENLIVE_LOG) << "// Cannot create envelope for producer: " << binId;
+        return;
+    }
+    m_samplingRate = clip->audioInfo()->samplingRate();
+    m_clipDuration = clip->frameDuration();
+    m_envelopeSize = m_clipDuration;
+    if (length > 2000 && offset < m_clipDuration) {
         // Analyse on timeline clip zone only
         m_offset = 0;
-        m_producer->set_in_and_out((int) offset, (int) (offset + length));
+        m_zoneStart = offset;
+        m_envelopeSize = std::min(length + 1, m_clipDuration - offset);
     }
-    m_envelopeSize = (size_t)m_producer->get_playtime();
-
-    m_producer->set("set.test_image", 1);
-    connect(&m_watcher, &QFutureWatcherBase::finished, this, [this] { envelopeReady(this); });
-    if (!m_producer || !m_producer->is_valid()) {
-        qCDebug(KDENLIVE_LOG) << "// Cannot create envelope for producer: " << binId;
-    } else {
-        m_info = std::make_unique<AudioInfo>(m_producer);
+    m_cachePath = clip->getAudioEnvelopePath(clip->audioInfo()->ffmpeg_audio_index());
+    // Long clips are split in ranges analysed in parallel, each range needs its own producer.
+    // A cached envelope keeps one, in case its file cannot be read anymore when it is needed.
+    const int ranges = AudioEnvelopeCache::get()->contains(m_cachePath) ? 1 : rangeCount();
+    for (int i = 0; i < ranges; ++i) {
+        std::shared_ptr<Mlt::Producer> producer = clip->cloneProducer();
+        if (!producer || !producer->is_valid()) {
+            break;
+        }
+        producer->set("set.test_image", 1);
+        m_rangeProducers.push_back(producer);
     }
 }
 
@@ -95,43 +133,94 @@ const std::vector<qint64> &AudioEnvelope::envelope()
     return audioSummary().audioAmplitudes;
 }
 
-AudioEnvelope::AudioSummary AudioEnvelope::loadAndNormalizeEnvelope() const
+int AudioEnvelope::rangeCount() const
 {
-    qCDebug(KDENLIVE_LOG) << "Loading envelope ...";
-    AudioSummary summary(m_envelopeSize);
-    if (!m_info || m_info->size() < 1) {
-        return summary;
-    }
-    int samplingRate = m_info->info(0)->samplingRate();
-    mlt_audio_format format_s16 = mlt_audio_s16;
-    int channels = 1;
+    return qBound(1, int(m_clipDuration / MIN_RANGE_FRAMES), QThread::idealThreadCount());
+}
 
+AudioEnvelopeCache::Envelope AudioEnvelope::computeClipEnvelope() const
+{
+    if (m_rangeProducers.empty()) {
+        return AudioEnvelopeCache::Envelope();
+    }
+    std::vector<std::shared_ptr<Mlt::Producer>> producers = m_rangeProducers;
+    // The envelope was cached when this object was created, open the other ranges from the first producer
+    for (int i = (int)producers.size(); i < rangeCount(); ++i) {
+        std::shared_ptr<Mlt::Producer> producer = ProjectClip::cloneProducer(m_rangeProducers.front());
+        if (!producer || !producer->is_valid()) {
+            break;
+        }
+        producer->set("set.test_image", 1);
+        producers.push_back(producer);
+    }
+    AudioEnvelopeCache::Envelope envelope(m_clipDuration);
     QElapsedTimer t;
     t.start();
-    m_producer->seek(0);
-    size_t max = summary.audioAmplitudes.size();
-    for (size_t i = 0; i < max; ++i) {
-        std::unique_ptr<Mlt::Frame> frame(m_producer->get_frame((int)i));
-        qint64 position = mlt_frame_get_position(frame->get_frame());
-        int samples = mlt_sample_calculator(m_producer->get_fps(), samplingRate, position);
-        auto *data = static_cast<qint16 *>(frame->get_audio(format_s16, samplingRate, channels, samples));
-
-        summary.audioAmplitudes[i] = 0;
-        for (int k = 0; k < samples; ++k) {
-            summary.audioAmplitudes[i] += abs(data[k]);
+    const size_t max = envelope.size();
+    const size_t rangeSize = (max + producers.size() - 1) / producers.size();
+    std::atomic<size_t> processedFrames(0);
+    std::atomic<int> lastProgress(-1);
+    auto processRange = [&](int range) {
+        const std::shared_ptr<Mlt::Producer> &producer = producers.at((size_t)range);
+        const size_t start = (size_t)range * rangeSize;
+        const size_t end = std::min(max, start + rangeSize);
+        mlt_audio_format format_s16 = mlt_audio_s16;
+        int channels = 1;
+        int frequency = m_samplingRate;
+        producer->seek((int)start);
+        for (size_t i = start; i < end; ++i) {
+            std::unique_ptr<Mlt::Frame> frame(producer->get_frame());
+            qint64 position = mlt_frame_get_position(frame->get_frame());
+            int samples = mlt_sample_calculator(producer->get_fps(), m_samplingRate, position);
+            auto *data = static_cast<qint16 *>(frame->get_audio(format_s16, frequency, channels, samples));
+            envelope[i] = data == nullptr ? 0 : sumAbs(data, samples * channels);
+
+            // Only report progress when the percentage changes, from whichever range reaches it first
+            const int progress = (int)(100 * ++processedFrames / max);
+            int previous = lastProgress.load();
+            if (progress > previous && lastProgress.compare_exchange_strong(previous, progress)) {
+                pCore->displayMessage(i18n("Processing data analysis"), ProcessingJobMessage, progress);
+            }
         }
-        pCore->displayMessage(i18n("Processing data analysis"), ProcessingJobMessage, (int) (100 * i / max));
+    };
+    QVector<int> ranges;
+    for (int i = 0; i < (int)producers.size(); ++i) {
+        ranges << i;
     }
-    qCDebug(KDENLIVE_LOG) << "Calculating the envelope (" << m_envelopeSize << " frames) took " << t.elapsed() << " ms.";
+    QtConcurrent::blockingMap(ranges, processRange);
+    qCDebug(KDENLIVE_LOG) << "Calculating the envelope (" << max << " frames, " << producers.size() << " ranges) took " << t.elapsed() << " ms.";
+    return envelope;
+}
+
+AudioEnvelope::AudioSummary AudioEnvelope::loadAndNormalizeEnvelope() const
+{
+    qCDebug(KDENLIVE_LOG) << "Loading envelope ...";
+    if (m_samplingRate <= 0) {
+        return AudioSummary(m_envelopeSize);
+    }
+    std::shared_ptr<const AudioEnvelopeCache::Envelope> clipEnvelope =
+        AudioEnvelopeCache::get()->envelope(m_cachePath, [this]() { return computeClipEnvelope(); });
+
+    // Only keep the analysed zone
+    AudioSummary summary;
+    if (m_zoneStart < clipEnvelope->size()) {
+        const size_t end = std::min(clipEnvelope->size(), m_zoneStart + m_envelopeSize);
+        summary.audioAmplitudes.assign(clipEnvelope->begin() + (long)m_zoneStart, clipEnvelope->begin() + (long)end);
+    }
+    summary.audioAmplitudes.resize(m_envelopeSize, 0);
+    if (summary.audioAmplitudes.empty()) {
+        return summary;
+    }
+
     qCDebug(KDENLIVE_LOG) << "Normalizing envelope ...";
     const qint64 meanBeforeNormalization =
         std::accumulate(summary.audioAmplitudes.begin(), summary.audioAmplitudes.end(), 0LL) / (qint64)summary.audioAmplitudes.size();
 
     // Normalize the envelope.
     summary.amplitudeMax = 0;
-    for (size_t i = 0; i < max; ++i) {
-        summary.audioAmplitudes[i] -= meanBeforeNormalization;
-        summary.amplitudeMax = std::max(summary.amplitudeMax, qAbs(summary.audioAmplitudes[i]));
+    for (qint64 &amplitude : summary.audioAmplitudes) {
+        amplitude -= meanBeforeNormalization;
+        summary.amplitudeMax = std::max(summary.amplitudeMax, qAbs(amplitude));
     }
     pCore->displayMessage(i18n("Audio analysis finished"), OperationCompletedMessage, 300);
     return summary;
@@ -151,7 +240,7 @@ QImage AudioEnvelope::drawEnvelope()
 {
     const AudioSummary &summary = audioSummary();
 
-    QImage img((int)m_envelopeSize, 400, QImage::Format_ARGB32);
+    QImage img((int)summary.audioAmplitudes.size(), 400, QImage::Format_ARGB32);
     img.fill(qRgb(255, 255, 255));
 
     if (summary.amplitudeMax == 0) {
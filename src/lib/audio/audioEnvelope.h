@@ -11,7 +11,7 @@
 #ifndef AUDIOENVELOPE_H
 #define AUDIOENVELOPE_H
 
-#include "audioInfo.h"
+#include "audioEnvelopeCache.h"
 #include <QFutureWatcher>
 #include <QObject>
 #include <memory>
@@ -25,6 +25,10 @@ class QImage;
   with frame resolution. One entry is calculated by the sum
   of the absolute values of all samples in the current frame.
 
+  The envelope of the whole bin clip is computed once and kept
+  in the AudioEnvelopeCache, an AudioEnvelope only normalizes the
+  zone it uses.
+
   See also: http://web.archive.org/web/20180626235917/http://bemasc.net/wordpress/2011/07/26/an-auto-aligner-for-pitivi/
   */
 class AudioEnvelope : public QObject
@@ -88,9 +92,20 @@ private:
      Actually computes the envelope data, synchronously.
     */
     AudioSummary loadAndNormalizeEnvelope() const;
-
-    std::shared_ptr<Mlt::Producer> m_producer;
-    std::unique_ptr<AudioInfo> m_info;
+    /**
+     Decodes the whole clip to compute its raw envelope, synchronously.
+    */
+    AudioEnvelopeCache::Envelope computeClipEnvelope() const;
+    /** @brief Number of ranges decoded in parallel to compute the clip envelope */
+    int rangeCount() const;
+
+    /** @brief Producers reading the consecutive ranges of the clip in parallel. Only the first one if the envelope is cached */
+    std::vector<std::shared_ptr<Mlt::Producer>> m_rangeProducers;
+    QString m_cachePath;
+    int m_samplingRate;
+    size_t m_clipDuration;
+    /** @brief First frame of the clip used by this envelope */
+    size_t m_zoneStart;
     QFutureWatcher<AudioSummary> m_watcher;
     QFuture<AudioSummary> m_audioSummary;
 
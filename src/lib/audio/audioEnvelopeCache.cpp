@@ -0,0 +1,120 @@
+/***************************************************************************
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "audioEnvelopeCache.h"
+#include "kdenlive_debug.h"
+#include <QDataStream>
+#include <QFile>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+namespace {
+const quint32 EnvelopeMagic = 0x4b454e56; // "KENV"
+const quint32 EnvelopeVersion = 1;
+} // namespace
+
+std::unique_ptr<AudioEnvelopeCache> AudioEnvelopeCache::instance;
+std::once_flag AudioEnvelopeCache::m_onceFlag;
+
+std::unique_ptr<AudioEnvelopeCache> &AudioEnvelopeCache::get()
+{
+    std::call_once(m_onceFlag, [] { instance.reset(new AudioEnvelopeCache()); });
+    return instance;
+}
+
+std::shared_ptr<AudioEnvelopeCache::Entry> AudioEnvelopeCache::entry(const QString &path)
+{
+    QMutexLocker lk(&m_mutex);
+    std::shared_ptr<Entry> &current = m_entries[path];
+    if (!current) {
+        current = std::make_shared<Entry>();
+    }
+    return current;
+}
+
+bool AudioEnvelopeCache::contains(const QString &path)
+{
+    if (path.isEmpty()) {
+        return false;
+    }
+    std::shared_ptr<Entry> current = entry(path);
+    if (!current->mutex.tryLock()) {
+        // Being loaded or computed by another envelope
+        return true;
+    }
+    bool inMemory = !current->data.expired();
+    current->mutex.unlock();
+    return inMemory || QFile::exists(path);
+}
+
+std::shared_ptr<const AudioEnvelopeCache::Envelope> AudioEnvelopeCache::envelope(const QString &path, const std::function<Envelope()> &compute)
+{
+    if (path.isEmpty()) {
+        return std::make_shared<Envelope>(compute());
+    }
+    std::shared_ptr<Entry> current = entry(path);
+    QMutexLocker lk(&current->mutex);
+    std::shared_ptr<const Envelope> result = current->data.lock();
+    if (result) {
+        return result;
+    }
+    result = load(path);
+    // The file may have been removed since contains() was called, recompute it
+    if (!result || result->empty()) {
+        auto computed = std::make_shared<Envelope>(compute());
+        if (!computed->empty()) {
+            save(path, *computed);
+        }
+        result = computed;
+    }
+    current->data = result;
+    return result;
+}
+
+// static
+std::shared_ptr<const AudioEnvelopeCache::Envelope> AudioEnvelopeCache::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    QDataStream stream(&file);
+    quint32 magic, version;
+    quint64 count;
+    stream >> magic >> version >> count;
+    if (stream.status() != QDataStream::Ok || magic != EnvelopeMagic || version != EnvelopeVersion ||
+        count != quint64(file.size() - file.pos()) / sizeof(qint64)) {
+        qCDebug(KDENLIVE_LOG) << "Ignoring invalid audio envelope" << path;
+        return nullptr;
+    }
+    auto envelope = std::make_shared<Envelope>(count);
+    for (quint64 i = 0; i < count; ++i) {
+        stream >> (*envelope)[i];
+    }
+    if (stream.status() != QDataStream::Ok) {
+        return nullptr;
+    }
+    return envelope;
+}
+
+// static
+void AudioEnvelopeCache::save(const QString &path, const Envelope &envelope)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(KDENLIVE_LOG) << "Cannot write audio envelope" << path;
+        return;
+    }
+    QDataStream stream(&file);
+    stream << EnvelopeMagic << EnvelopeVersion << quint64(envelope.size());
+    for (qint64 value : envelope) {
+        stream << value;
+    }
+    file.commit();
+}
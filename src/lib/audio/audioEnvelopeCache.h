@@ -0,0 +1,72 @@
+/***************************************************************************
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef AUDIOENVELOPECACHE_H
+#define AUDIOENVELOPECACHE_H
+
+#include "definitions.h"
+#include <QMutex>
+#include <QString>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+  Cache of the raw audio envelopes of bin clips, used by the audio alignment.
+
+  An envelope covers a whole clip stream (one entry per frame, the sum of the
+  absolute sample values) and is saved in the project audio cache, next to the
+  audio thumbnails. It is computed once: aligning other clips, or the same
+  clips after trimming them, only needs the envelope zone they use.
+
+  Envelopes stay in memory as long as an AudioEnvelope uses them.
+  */
+class AudioEnvelopeCache
+{
+public:
+    using Envelope = std::vector<qint64>;
+
+    static std::unique_ptr<AudioEnvelopeCache> &get();
+
+    /**
+      Returns true if the envelope stored in \c path can be obtained
+      without decoding the clip, or is being computed.
+      */
+    bool contains(const QString &path);
+
+    /**
+      Returns the envelope stored in \c path, calling \c compute and saving
+      its result if it is not available yet, or cannot be read. Thread safe, concurrent requests
+      for the same envelope only compute it once. If \c path is empty, the
+      envelope is computed and not cached.
+      */
+    std::shared_ptr<const Envelope> envelope(const QString &path, const std::function<Envelope()> &compute);
+
+private:
+    AudioEnvelopeCache() = default;
+    static std::unique_ptr<AudioEnvelopeCache> instance;
+    static std::once_flag m_onceFlag;
+
+    struct Entry
+    {
+        // Held while the envelope is loaded or computed
+        QMutex mutex;
+        std::weak_ptr<const Envelope> data;
+    };
+    std::shared_ptr<Entry> entry(const QString &path);
+    static std::shared_ptr<const Envelope> load(const QString &path);
+    static void save(const QString &path, const Envelope &envelope);
+
+    QMutex m_mutex;
+    std::unordered_map<QString, std::shared_ptr<Entry>> m_entries;
+};
+
+#endif
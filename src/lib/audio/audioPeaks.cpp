@@ -0,0 +1,339 @@
+/***************************************************************************
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "audioPeaks.h"
+#include "kdenlive_debug.h"
+#include <QSaveFile>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+const char PeaksMagic[4] = {'K', 'D', 'P', 'K'};
+const quint32 PeaksVersion = 2;
+
+struct FileHeader
+{
+    char magic[4];
+    quint32 version;
+    quint32 channels;
+    quint32 frames;
+    double samplesPerFrame;
+    quint32 levelCount;
+    // Loudest sample and RMS values of the stream
+    quint32 maxPeak;
+    quint32 maxRms;
+    quint32 reserved;
+};
+
+struct LevelHeader
+{
+    double bucketSize;
+    quint32 count;
+    quint32 reserved;
+    quint64 offset;
+};
+} // namespace
+
+AudioPeaks::~AudioPeaks()
+{
+    close();
+}
+
+void AudioPeaks::close()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+    m_levels.clear();
+    m_channels = 0;
+    m_frames = 0;
+}
+
+bool AudioPeaks::open(const QString &path)
+{
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly) || m_file.size() < qint64(sizeof(FileHeader))) {
+        return false;
+    }
+    const qint64 size = m_file.size();
+    m_map = m_file.map(0, size);
+    // The mapping stays valid after the file is closed
+    m_file.close();
+    if (!m_map) {
+        return false;
+    }
+    FileHeader header;
+    memcpy(&header, m_map, sizeof(FileHeader));
+    if (memcmp(header.magic, PeaksMagic, 4) != 0 || header.version != PeaksVersion || header.channels == 0 ||
+        size < qint64(sizeof(FileHeader) + header.levelCount * sizeof(LevelHeader))) {
+        qCDebug(KDENLIVE_LOG) << "Invalid audio peak file" << path;
+        m_levels.clear();
+        return false;
+    }
+    const auto *levels = reinterpret_cast<const LevelHeader *>(m_map + sizeof(FileHeader));
+    for (quint32 i = 0; i < header.levelCount; i++) {
+        const LevelHeader &l = levels[i];
+        if (l.bucketSize <= 0 || l.offset + quint64(l.count) * header.channels * sizeof(RawPeak) > quint64(size)) {
+            qCDebug(KDENLIVE_LOG) << "Truncated audio peak file" << path;
+            m_levels.clear();
+            return false;
+        }
+        m_levels << Level{l.bucketSize, int(l.count), reinterpret_cast<const RawPeak *>(m_map + l.offset)};
+    }
+    m_channels = int(header.channels);
+    m_maxPeak = qMax(1, int(header.maxPeak));
+    m_maxRms = qMax(1., double(header.maxRms));
+    m_frames = int(header.frames);
+    m_samplesPerFrame = header.samplesPerFrame;
+    return !m_levels.isEmpty();
+}
+
+bool AudioPeaks::isValid() const
+{
+    return !m_levels.isEmpty();
+}
+
+int AudioPeaks::channels() const
+{
+    return m_channels;
+}
+
+int AudioPeaks::frames() const
+{
+    return m_frames;
+}
+
+double AudioPeaks::samplesPerFrame() const
+{
+    return m_samplesPerFrame;
+}
+
+int AudioPeaks::levelCount() const
+{
+    return m_levels.size();
+}
+
+int AudioPeaks::levelFor(double samples) const
+{
+    int level = 0;
+    while (level + 1 < m_levels.size() && m_levels.at(level + 1).bucketSize <= samples) {
+        level++;
+    }
+    return level;
+}
+
+AudioPeaks::Peak AudioPeaks::peak(int level, int channel, double start, double end) const
+{
+    Peak result{0, 0, 0, 0};
+    if (level < 0 || level >= m_levels.size() || channel < 0 || channel >= m_channels) {
+        return result;
+    }
+    const Level &l = m_levels.at(level);
+    if (end < start) {
+        std::swap(start, end);
+    }
+    int first = qMax(0, int(start / l.bucketSize));
+    int last = qMin(l.count - 1, qMax(first, int(std::ceil(end / l.bucketSize)) - 1));
+    if (first > last) {
+        return result;
+    }
+    int min = 32767;
+    int max = -32767;
+    double squares = 0;
+    for (int i = first; i <= last; i++) {
+        const RawPeak &p = l.data[i * m_channels + channel];
+        min = qMin(min, int(p.min));
+        max = qMax(max, int(p.max));
+        squares += double(p.rms) * p.rms;
+    }
+    // Normalize so that the loudest bucket uses the full range
+    result.min = qint8(qBound(-127, 127 * min / m_maxPeak, 127));
+    result.max = qint8(qBound(-127, 127 * max / m_maxPeak, 127));
+    result.rms = quint8(qMin(255., 255 * std::sqrt(squares / (last - first + 1)) / m_maxRms));
+    return result;
+}
+
+AudioPeaksBuilder::AudioPeaksBuilder(int channels, int frequency, double fps, int frames, double bucketSize)
+    : m_channels(qMax(1, channels))
+    , m_frequency(frequency)
+    , m_frames(frames)
+    , m_samplesPerFrame(fps > 0 ? frequency / fps : frequency / 25.)
+    , m_bucketSize(bucketSize)
+    , m_currentMin(m_channels, 0)
+    , m_currentMax(m_channels, 0)
+    , m_currentSquares(m_channels, 0)
+{
+    // Each level is 4 times coarser than the previous one, up to about one value per second
+    const double samples = qMax(1., m_frames * m_samplesPerFrame);
+    double size = m_bucketSize;
+    do {
+        Level level;
+        level.bucketSize = size;
+        // The clip length gives the final size of the level, unless the audio stream is longer
+        level.peaks.reserve(int(std::ceil(samples / size)) * m_channels);
+        level.current.resize(m_channels);
+        level.squares.resize(m_channels);
+        m_levels.push_back(std::move(level));
+        size *= 4;
+    } while (m_levels.back().bucketSize < m_frequency);
+}
+
+AudioPeaksBuilder::~AudioPeaksBuilder() = default;
+
+void AudioPeaksBuilder::addSamples(const qint16 *data, int samples)
+{
+    const int bucketSize = qMax(1, int(m_bucketSize));
+    for (int i = 0; i < samples; i++) {
+        for (int k = 0; k < m_channels; k++) {
+            qint16 value = data[i * m_channels + k];
+            if (m_bucketSamples == 0) {
+                m_currentMin[k] = value;
+                m_currentMax[k] = value;
+            } else {
+                m_currentMin[k] = qMin(m_currentMin.at(k), value);
+                m_currentMax[k] = qMax(m_currentMax.at(k), value);
+            }
+            m_currentSquares[k] += double(value) * value;
+        }
+        if (++m_bucketSamples >= bucketSize) {
+            storeBucket();
+        }
+    }
+}
+
+void AudioPeaksBuilder::storeBucket()
+{
+    QVector<AudioPeaks::RawPeak> peaks(m_channels);
+    for (int k = 0; k < m_channels; k++) {
+        auto rms = quint16(lrint(std::sqrt(m_currentSquares.at(k) / qMax(1, m_bucketSamples))));
+        peaks[k] = AudioPeaks::RawPeak{m_currentMin.at(k), m_currentMax.at(k), rms};
+        m_currentSquares[k] = 0;
+    }
+    m_bucketSamples = 0;
+    addBucket(0, peaks.constData());
+}
+
+void AudioPeaksBuilder::addLevels(const QVector<double> &levels)
+{
+    QVector<AudioPeaks::RawPeak> peaks(m_channels);
+    for (int k = 0; k < m_channels; k++) {
+        auto value = qint16(32767 * qBound(0., k < levels.size() ? levels.at(k) : 0., 1.));
+        peaks[k] = AudioPeaks::RawPeak{qint16(-value), value, quint16(value)};
+    }
+    addBucket(0, peaks.constData());
+}
+
+void AudioPeaksBuilder::addBucket(size_t index, const AudioPeaks::RawPeak *peaks)
+{
+    Level &level = m_levels[index];
+    for (int k = 0; k < m_channels; k++) {
+        level.peaks << peaks[k];
+        if (index == 0) {
+            m_maxPeak = qMax(m_maxPeak, qMax(-int(peaks[k].min), int(peaks[k].max)));
+            m_maxRms = qMax(m_maxRms, int(peaks[k].rms));
+        }
+    }
+    level.count++;
+    if (index + 1 >= m_levels.size()) {
+        return;
+    }
+    // Reduce into the next level
+    Level &next = m_levels[index + 1];
+    for (int k = 0; k < m_channels; k++) {
+        AudioPeaks::RawPeak &current = next.current[k];
+        if (next.steps == 0) {
+            current = peaks[k];
+            next.squares[k] = 0;
+        } else {
+            current.min = qMin(current.min, peaks[k].min);
+            current.max = qMax(current.max, peaks[k].max);
+        }
+        next.squares[k] += double(peaks[k].rms) * peaks[k].rms;
+    }
+    if (++next.steps == 4) {
+        flushReduction(index + 1);
+    }
+}
+
+void AudioPeaksBuilder::flushReduction(size_t index)
+{
+    Level &level = m_levels[index];
+    if (level.steps == 0) {
+        return;
+    }
+    for (int k = 0; k < m_channels; k++) {
+        level.current[k].rms = quint16(lrint(std::sqrt(level.squares.at(k) / level.steps)));
+    }
+    level.steps = 0;
+    addBucket(index, level.current.constData());
+}
+
+bool AudioPeaksBuilder::isEmpty() const
+{
+    return m_levels.front().count == 0 && m_bucketSamples == 0;
+}
+
+bool AudioPeaksBuilder::save(const QString &path)
+{
+    if (m_bucketSamples > 0) {
+        storeBucket();
+    }
+    // Audio stream may be a bit shorter than the clip
+    const int buckets = qMax(1, int(std::ceil(m_frames * m_samplesPerFrame / m_bucketSize)));
+    const QVector<AudioPeaks::RawPeak> silence(m_channels, AudioPeaks::RawPeak{0, 0, 0});
+    while (m_levels.front().count < buckets) {
+        addBucket(0, silence.constData());
+    }
+    // Complete the last buckets of the coarser levels, from the finest one so that they propagate
+    for (size_t i = 1; i < m_levels.size(); i++) {
+        flushReduction(i);
+    }
+    // Don't keep levels coarser than one bucket
+    size_t levelCount = 1;
+    while (levelCount < m_levels.size() && m_levels.at(levelCount - 1).count > 1) {
+        levelCount++;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(KDENLIVE_LOG) << "Cannot write audio peak file" << path;
+        return false;
+    }
+    FileHeader header;
+    memcpy(header.magic, PeaksMagic, 4);
+    header.version = PeaksVersion;
+    header.channels = quint32(m_channels);
+    header.frames = quint32(m_frames);
+    header.samplesPerFrame = m_samplesPerFrame;
+    header.levelCount = quint32(levelCount);
+    header.maxPeak = quint32(m_maxPeak);
+    header.maxRms = quint32(m_maxRms);
+    header.reserved = 0;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(FileHeader));
+    quint64 offset = sizeof(FileHeader) + levelCount * sizeof(LevelHeader);
+    for (size_t i = 0; i < levelCount; i++) {
+        const Level &level = m_levels.at(i);
+        LevelHeader l{level.bucketSize, quint32(level.count), 0, offset};
+        file.write(reinterpret_cast<const char *>(&l), sizeof(LevelHeader));
+        offset += quint64(level.count) * quint64(m_channels) * sizeof(AudioPeaks::RawPeak);
+    }
+    for (size_t i = 0; i < levelCount; i++) {
+        const QVector<AudioPeaks::RawPeak> &peaks = m_levels.at(i).peaks;
+        const qint64 size = qint64(peaks.size()) * qint64(sizeof(AudioPeaks::RawPeak));
+        if (file.write(reinterpret_cast<const char *>(peaks.constData()), size) != size) {
+            file.cancelWriting();
+            return false;
+        }
+    }
+    return file.commit();
+}
@@ -0,0 +1,156 @@
+/***************************************************************************
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef AUDIOPEAKS_H
+#define AUDIOPEAKS_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <vector>
+
+/**
+  Audio peak files store the waveform of an audio stream as a pyramid
+  of decimation levels. Each level holds, for every bucket of samples
+  and every channel, the minimum, maximum and RMS values. The finest
+  level covers a few milliseconds, every following level is four times
+  coarser, up to about one value per second.
+
+  Values are stored as 16 bit samples, and normalized when they are read
+  with the loudest values of the stream, stored in the file header. This
+  allows writing the levels while the samples stream in.
+
+  The file is memory mapped for reading, so a view only touches the
+  buckets of the level that matches its zoom.
+  */
+class AudioPeaks
+{
+public:
+    struct Peak
+    {
+        /** Normalized sample extrema, in the -127..127 range */
+        qint8 min;
+        qint8 max;
+        /** Normalized RMS level, in the 0..255 range */
+        quint8 rms;
+        quint8 reserved;
+    };
+    /** A bucket of a channel as stored in the file, in 16 bit sample units */
+    struct RawPeak
+    {
+        qint16 min;
+        qint16 max;
+        quint16 rms;
+    };
+
+    AudioPeaks() = default;
+    ~AudioPeaks();
+    AudioPeaks(const AudioPeaks &) = delete;
+    AudioPeaks &operator=(const AudioPeaks &) = delete;
+
+    /** @brief Map the peak file at @param path, returns false if it is missing or invalid. A previously opened file is released. */
+    bool open(const QString &path);
+    bool isValid() const;
+    int channels() const;
+    /** @brief The length of the audio stream, in frames. */
+    int frames() const;
+    double samplesPerFrame() const;
+    int levelCount() const;
+
+    /** @brief Returns the coarsest level whose buckets are not larger than @param samples. */
+    int levelFor(double samples) const;
+    /** @brief Returns the combined peak of @param channel between samples @param start and @param end, read from @param level. */
+    Peak peak(int level, int channel, double start, double end) const;
+
+private:
+    struct Level
+    {
+        double bucketSize;
+        int count;
+        const RawPeak *data;
+    };
+    QFile m_file;
+    uchar *m_map{nullptr};
+    int m_channels{0};
+    int m_frames{0};
+    double m_samplesPerFrame{0};
+    int m_maxPeak{1};
+    double m_maxRms{1};
+    QVector<Level> m_levels;
+    /** @brief Unmap the current file and reset the levels. */
+    void close();
+};
+
+/**
+  Collects the peaks of an audio stream and writes them to a peak file.
+  Samples are either streamed in and reduced to the finest level, or
+  already reduced to one level per bucket (for example by the MLT
+  audiolevel filter).
+
+  Every level is reduced from the previous one as the buckets come in.
+  The levels are kept in memory, their size is the size of the peak
+  file: about 20MB for an hour of 48kHz stereo audio. save() only
+  writes them one after the other.
+  */
+class AudioPeaksBuilder
+{
+public:
+    /** @brief Samples per bucket of the finest level when reducing raw samples. */
+    static const int SamplesPerBucket = 128;
+
+    /** @param frames the clip length, the peaks are padded with silence up to it
+        @param bucketSize the number of samples covered by each bucket of the finest level */
+    AudioPeaksBuilder(int channels, int frequency, double fps, int frames, double bucketSize = SamplesPerBucket);
+    ~AudioPeaksBuilder();
+
+    /** @brief Add @param samples interleaved 16 bit samples. */
+    void addSamples(const qint16 *data, int samples);
+    /** @brief Add one bucket of already computed levels (one per channel, in the 0..1 range). */
+    void addLevels(const QVector<double> &levels);
+    /** @brief Returns true if no data was added yet. */
+    bool isEmpty() const;
+    /** @brief Complete the pyramid and write it to @param path. */
+    bool save(const QString &path);
+
+private:
+    struct Level
+    {
+        double bucketSize;
+        /** @brief Number of buckets added to this level. */
+        int count{0};
+        /** @brief The buckets of this level, all channels interleaved. */
+        QVector<AudioPeaks::RawPeak> peaks;
+        /** @brief The bucket being reduced from the previous level. */
+        QVector<AudioPeaks::RawPeak> current;
+        QVector<double> squares;
+        int steps{0};
+    };
+    int m_channels;
+    int m_frequency;
+    int m_frames;
+    double m_samplesPerFrame;
+    double m_bucketSize;
+    /** @brief Number of samples accumulated in the current bucket. */
+    int m_bucketSamples{0};
+    QVector<qint16> m_currentMin;
+    QVector<qint16> m_currentMax;
+    QVector<double> m_currentSquares;
+    /** @brief The pyramid levels, from the finest one. */
+    std::vector<Level> m_levels;
+    /** @brief Loudest values of the stream, used to normalize the peaks. */
+    int m_maxPeak{1};
+    int m_maxRms{1};
+    void storeBucket();
+    /** @brief Add one bucket of all channels to @param level, and reduce it into the next level. */
+    void addBucket(size_t level, const AudioPeaks::RawPeak *peaks);
+    /** @brief Add the incomplete bucket reduced from the previous level to @param level. */
+    void flushReduction(size_t level);
+};
+
+#endif // AUDIOPEAKS_H
@@ -18,60 +18,137 @@ extern "C" {
 #include <algorithm>
 #include <vector>
 
+// Dividing by the max value is maybe not the best solution, but the
+// maximum value after correlation should not be larger than the longest
+// vector since each value should be at most 1
+static qint64 normalizationFactor(const qint64 *data, size_t size)
+{
+    qint64 max = 1;
+    for (size_t i = 0; i < size; ++i) {
+        max = std::max(max, qAbs(data[i]));
+    }
+    return max;
+}
+
+size_t FFTCorrelation::paddedSize(size_t largestSize)
+{
+    // To avoid issues with repetition (we are dealing with cosine waves
+    // in the fourier domain) we need to pad the vectors to at least twice their size,
+    // otherwise convolution would convolve with the repeated pattern as well.
+    // The vectors must have the same size (same frequency resolution!) and should
+    // be a power of 2 (for FFT).
+    size_t size = 64;
+    while (size / 2 < largestSize) {
+        size = size << 1;
+    }
+    return size;
+}
+
+FFTCorrelation::Reference::Reference(const qint64 *left, size_t leftSize, size_t maxRightSize)
+    : m_leftSize(leftSize)
+    , m_fftSize(paddedSize(std::max(leftSize, maxRightSize)))
+{
+    // The qint64 values need to be normalized to floats
+    const double maxLeft = normalizationFactor(left, leftSize);
+    std::vector<float> leftData(m_fftSize, 0);
+    for (size_t i = 0; i < leftSize; ++i) {
+        leftData[i] = float(double(left[i]) / maxLeft);
+    }
+
+    const size_t spectrumSize = m_fftSize / 2 + 1;
+    std::vector<kiss_fft_cpx> leftFFT(spectrumSize);
+    kiss_fftr_cfg fftConfig = kiss_fftr_alloc((int)m_fftSize, 0, nullptr, nullptr);
+    kiss_fftr(fftConfig, &leftData[0], &leftFFT[0]);
+    kiss_fftr_free(fftConfig);
+
+    m_real.resize(spectrumSize);
+    m_imag.resize(spectrumSize);
+    for (size_t i = 0; i < spectrumSize; ++i) {
+        m_real[i] = leftFFT[i].r;
+        m_imag[i] = leftFFT[i].i;
+    }
+}
+
+bool FFTCorrelation::Reference::accepts(size_t rightSize) const
+{
+    return m_fftSize / 2 >= rightSize;
+}
+
+size_t FFTCorrelation::Reference::size() const
+{
+    return m_leftSize;
+}
+
 void FFTCorrelation::correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, qint64 *out_correlated)
 {
-    auto *correlatedFloat = new float[leftSize + rightSize + 1];
-    correlate(left, leftSize, right, rightSize, correlatedFloat);
+    correlate(Reference(left, leftSize, rightSize), right, rightSize, out_correlated);
+}
+
+void FFTCorrelation::correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, float *out_correlated)
+{
+    correlate(Reference(left, leftSize, rightSize), right, rightSize, out_correlated);
+}
+
+void FFTCorrelation::correlate(const Reference &reference, const qint64 *right, const size_t rightSize, qint64 *out_correlated)
+{
+    const size_t outSize = reference.size() + rightSize + 1;
+    std::vector<float> correlatedFloat(outSize);
+    correlate(reference, right, rightSize, &correlatedFloat[0]);
 
     // The correlation vector will have entries up to N (number of entries
     // of the vector), so converting to integers will not lose that much
     // of precision.
-    for (size_t i = 0; i < leftSize + rightSize + 1; ++i) {
+    for (size_t i = 0; i < outSize; ++i) {
         out_correlated[i] = correlatedFloat[i];
     }
-    delete[] correlatedFloat;
 }
 
-void FFTCorrelation::correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, float *out_correlated)
+void FFTCorrelation::correlate(const Reference &reference, const qint64 *right, const size_t rightSize, float *out_correlated)
 {
+    Q_ASSERT(reference.accepts(rightSize));
     QElapsedTimer t;
     t.start();
 
-    auto *leftF = new float[leftSize];
-    auto *rightF = new float[rightSize];
-
-    // First the qint64 values need to be normalized to floats
-    // Dividing by the max value is maybe not the best solution, but the
-    // maximum value after correlation should not be larger than the longest
-    // vector since each value should be at most 1
-    qint64 maxLeft = 1;
-    qint64 maxRight = 1;
-    for (size_t i = 0; i < leftSize; ++i) {
-        if (qAbs(left[i]) > maxLeft) {
-            maxLeft = qAbs(left[i]);
-        }
-    }
-    for (size_t i = 0; i < rightSize; ++i) {
-        if (qAbs(right[i]) > maxRight) {
-            maxRight = qAbs(right[i]);
-        }
-    }
+    const size_t size = reference.m_fftSize;
+    const size_t spectrumSize = size / 2 + 1;
 
     // One side needs to be reversed, since multiplication in frequency domain (fourier space)
     // calculates the convolution: \sum l[x]r[N-x] and not the correlation: \sum l[x]r[x]
-    for (size_t i = 0; i < leftSize; ++i) {
-        leftF[i] = double(left[i]) / (double)maxLeft;
-    }
+    const double maxRight = normalizationFactor(right, rightSize);
+    std::vector<float> rightData(size, 0);
     for (size_t i = 0; i < rightSize; ++i) {
-        rightF[rightSize - 1 - i] = double(right[i]) / (double)maxRight;
+        rightData[rightSize - 1 - i] = float(double(right[i]) / maxRight);
     }
 
-    // Now we can convolve to get the correlation
-    convolve(leftF, leftSize, rightF, rightSize, out_correlated);
+    // kiss_fft configurations hold a work buffer, so each correlation needs its own
+    kiss_fftr_cfg fftConfig = kiss_fftr_alloc((int)size, 0, nullptr, nullptr);
+    kiss_fftr_cfg ifftConfig = kiss_fftr_alloc((int)size, 1, nullptr, nullptr);
+    std::vector<kiss_fft_cpx> rightFFT(spectrumSize);
+    kiss_fftr(fftConfig, &rightData[0], &rightFFT[0]);
+
+    // Convolution in spacial domain is a multiplication in fourier domain. O(n).
+    const float *leftReal = reference.m_real.data();
+    const float *leftImag = reference.m_imag.data();
+    for (size_t i = 0; i < spectrumSize; ++i) {
+        const float r = rightFFT[i].r;
+        const float im = rightFFT[i].i;
+        rightFFT[i].r = leftReal[i] * r - leftImag[i] * im;
+        rightFFT[i].i = leftReal[i] * im + leftImag[i] * r;
+    }
+
+    // Inverse fourier transformation to get the convolved data.
+    // Insert one element at the beginning to obtain the same result
+    // that we also get with the nested for loop correlation.
+    std::vector<float> convolved(size);
+    kiss_fftri(ifftConfig, &rightFFT[0], &convolved[0]);
+    *out_correlated = 0;
+    const size_t outSize = reference.size() + rightSize + 1;
+    std::copy(convolved.begin(), convolved.begin() + (int)outSize - 1, out_correlated + 1);
+
+    kiss_fftr_free(fftConfig);
+    kiss_fftr_free(ifftConfig);
 
     qCDebug(KDENLIVE_LOG) << "Correlation (FFT based) computed in " << t.elapsed() << " ms.";
-    delete[] leftF;
-    delete[] rightF;
 }
 
 void FFTCorrelation::convolve(const float *left, const size_t leftSize, const float *right, const size_t rightSize, float *out_convolved)
@@ -79,17 +156,7 @@ void FFTCorrelation::convolve(const float *left, const size_t leftSize, const fl
     QElapsedTimer time;
     time.start();
 
-    // To avoid issues with repetition (we are dealing with cosine waves
-    // in the fourier domain) we need to pad the vectors to at least twice their size,
-    // otherwise convolution would convolve with the repeated pattern as well
-    size_t largestSize = std::max(leftSize, rightSize);
-
-    // The vectors must have the same size (same frequency resolution!) and should
-    // be a power of 2 (for FFT).
-    size_t size = 64;
-    while (size / 2 < largestSize) {
-        size = size << 1;
-    }
+    const size_t size = paddedSize(std::max(leftSize, rightSize));
 
     const size_t fft_size = size / 2 + 1;
     kiss_fftr_cfg fftConfig = kiss_fftr_alloc((int)size, 0, nullptr, nullptr);
@@ -12,6 +12,8 @@ the Free Software Foundation, either version 3 of the License, or
 #define FFTCORRELATION_H
 
 #include <QtGlobal>
+#include <vector>
+
 /**
   This class provides methods to calculate convolution
   and correlation of two vectors by means of FFT, which
@@ -21,6 +23,37 @@ the Free Software Foundation, either version 3 of the License, or
 class FFTCorrelation
 {
 public:
+    /**
+      Normalized spectrum of the left side of a correlation.
+      When several vectors are correlated with the same reference (like
+      when aligning several clips to the same audio track), the reference
+      only needs to be transformed once. A reference is immutable and can
+      be used from several threads at the same time.
+      */
+    class Reference
+    {
+    public:
+        /**
+          Computes the spectrum of \c left, padded for vectors of at most
+          \c maxRightSize entries.
+          */
+        Reference(const qint64 *left, size_t leftSize, size_t maxRightSize);
+
+        /** Returns true if a vector of size \c rightSize can be correlated with this reference. */
+        bool accepts(size_t rightSize) const;
+        size_t size() const;
+
+    private:
+        friend class FFTCorrelation;
+        size_t m_leftSize;
+        // Padded size of the transformed vectors
+        size_t m_fftSize;
+        // Real and imaginary parts of the spectrum, kept apart so that the
+        // multiplication with the other spectrum can be vectorised
+        std::vector<float> m_real;
+        std::vector<float> m_imag;
+    };
+
     /**
       Computes the convolution between \c left and \c right.
       \c out_correlated must be a pre-allocated vector of size
@@ -36,6 +69,19 @@ public:
     static void correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, float *out_correlated);
 
     static void correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, qint64 *out_correlated);
+
+    /**
+      Computes the correlation between the vector of \c reference and \c right.
+      \c out_correlated must be a pre-allocated vector of size
+      \c reference.size() + \c rightSize + 1.
+      REQUIRES: reference.accepts(rightSize)
+      */
+    static void correlate(const Reference &reference, const qint64 *right, const size_t rightSize, float *out_correlated);
+    static void correlate(const Reference &reference, const qint64 *right, const size_t rightSize, qint64 *out_correlated);
+
+private:
+    /** Returns the padded FFT size needed to convolve vectors of at most \c largestSize entries. */
+    static size_t paddedSize(size_t largestSize);
 };
 
 #endif // FFTCORRELATION_H
@@ -20,6 +20,7 @@
 
 #include "core.h"
 #include "logger.hpp"
+#include "utils/startuptimer.hpp"
 #include <config-kdenlive.h>
 
 #include <mlt++/Mlt.h>
@@ -69,6 +70,7 @@ int main(int argc, char *argv[])
 #ifdef USE_DRMINGW
     ExcHndlInit();
 #endif
+    StartupTimer::start();
     // Force QDomDocument to use a deterministic XML attribute order
     qSetGlobalQHashSeed(0);
 
@@ -251,6 +253,7 @@ int main(int argc, char *argv[])
         }
     }
     qApp->processEvents(QEventLoop::AllEvents);
+    StartupTimer::mark(QStringLiteral("Application"));
     Core::build(!parser.value(QStringLiteral("config")).isEmpty(), parser.value(QStringLiteral("mlt-path")));
     pCore->initGUI(url, clipsToLoad);
     splash.finish(pCore->window());
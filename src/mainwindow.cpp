@@ -65,6 +65,7 @@
 #include "utils/resourcewidget.h"
 #include "utils/thememanager.h"
 #include "utils/otioconvertions.h"
+#include "utils/thumbnailcache.hpp"
 
 #include "profiles/profilerepository.hpp"
 #include "widgets/progressbutton.h"
@@ -2390,6 +2391,8 @@ void MainWindow::updateConfiguration()
     m_buttonVideoThumbs->setChecked(KdenliveSettings::videothumbnails());
     m_buttonShowMarkers->setChecked(KdenliveSettings::showmarkers());
     slotSwitchAutomaticTransition();
+    ThumbnailCache::get()->setMemoryBudget(qint64(qMax(1, KdenliveSettings::thumbnailcachesize())) * 1024 * 1024);
+    pCore->jobManager()->updateThreadCount();
 
     // Update list of transcoding profiles
     buildDynamicActions();
@@ -3337,15 +3340,11 @@ void MainWindow::buildDynamicActions()
             break;
         }
     }
-    filter = std::make_unique<Mlt::Filter>(profile, "motion_est");
-    if (filter) {
-        if (filter->is_valid()) {
-            QAction *action = new QAction(i18n("Automatic scene split"), m_extraFactory->actionCollection());
-            ts->addAction(action->text(), action);
-            connect(action, &QAction::triggered,
-                    [&]() { pCore->jobManager()->startJob<SceneSplitJob>(pCore->bin()->selectedClipsIds(true), {}, i18n("Scene detection")); });
-        }
-    }
+    // Scene detection is native, it does not depend on an MLT filter
+    QAction *sceneAction = new QAction(i18n("Automatic scene split"), m_extraFactory->actionCollection());
+    ts->addAction(sceneAction->text(), sceneAction);
+    connect(sceneAction, &QAction::triggered,
+            [&]() { pCore->jobManager()->startJob<SceneSplitJob>(pCore->bin()->selectedClipsIds(true), {}, i18n("Scene detection")); });
     if (true /* TODO: check if timewarp producer is available */) {
         QAction *action = new QAction(i18n("Duplicate clip with speed change"), m_extraFactory->actionCollection());
         ts->addAction(action->text(), action);
@@ -21,6 +21,7 @@
 #define ABSTRACTMONITOR_H
 
 #include "definitions.h"
+#include "scopes/sharedframe.h"
 
 #include <cstdint>
 
@@ -101,6 +102,8 @@ protected:
 signals:
     /** @brief Send a frame for analysis or title background display. */
     void frameUpdated(const QImage &);
+    /** @brief Send the displayed YUV frame for analysis, @param colorspace is the colorspace of the frame. */
+    void sharedFrameUpdated(const SharedFrame &, int colorspace);
     /** @brief This signal contains the audio of the current frame. */
     void audioSamplesSignal(const audioShortVector &, int, int, int);
     /** @brief Scopes are ready to receive a new frame. */
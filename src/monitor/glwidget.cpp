@@ -63,6 +63,7 @@ using namespace Mlt;
 GLWidget::GLWidget(int id, QObject *parent)
     : QQuickView((QWindow *)parent)
     , sendFrameForAnalysis(false)
+    , sendImageForAnalysis(false)
     , m_glslManager(nullptr)
     , m_consumer(nullptr)
     , m_producer(nullptr)
@@ -1274,7 +1275,16 @@ void GLWidget::onFrameDisplayed(const SharedFrame &frame)
     m_contextSharedAccess.lock();
     m_sharedFrame = frame;
     m_sendFrame = sendFrameForAnalysis;
+    // The scopes can read the YUV planes of the frame, no need to render and read back an RGB image
+    bool sendShared = m_sendFrame && !sendImageForAnalysis && m_glslManager == nullptr && frame.is_valid() &&
+                      frame.get_image_format() == mlt_image_yuv420p;
+    if (sendShared) {
+        m_sendFrame = false;
+    }
     m_contextSharedAccess.unlock();
+    if (sendShared && m_analyseSem.tryAcquire(1)) {
+        emit analyseSharedFrame(frame, m_colorSpace);
+    }
     update();
 }
 
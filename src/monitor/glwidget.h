@@ -105,8 +105,10 @@ public:
     Mlt::Producer *producer();
     QSize profileSize() const;
     QRect displayRect() const;
-    /** @brief set to true if we want to emit a QImage of the frame for analysis */
+    /** @brief set to true if we want to emit the frame for analysis */
     bool sendFrameForAnalysis;
+    /** @brief set to true if the frame for analysis must be a QImage rendered by the shader even when the YUV frame is available (title background) */
+    bool sendImageForAnalysis;
     void updateGamma();
     /** @brief delete and rebuild consumer, for example when external display is switched */
     void resetConsumer(bool fullReset);
@@ -183,6 +185,8 @@ signals:
     void mouseSeek(int eventDelta, uint modifiers);
     void startDrag();
     void analyseFrame(const QImage &);
+    /** @brief The displayed YUV frame, for analysis without GPU readback. @param colorspace is the colorspace used to display it */
+    void analyseSharedFrame(const SharedFrame &frame, int colorspace);
     void showContextMenu(const QPoint &);
     void lockMonitor(bool);
     void passKeyEvent(QKeyEvent *);
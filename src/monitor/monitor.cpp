@@ -433,6 +433,7 @@ Monitor::Monitor(Kdenlive::MonitorId id, MonitorManager *manager, QWidget *paren
 
     connect(this, &Monitor::scopesClear, m_glMonitor, &GLWidget::releaseAnalyse, Qt::DirectConnection);
     connect(m_glMonitor, &GLWidget::analyseFrame, this, &Monitor::frameUpdated);
+    connect(m_glMonitor, &GLWidget::analyseSharedFrame, this, &Monitor::sharedFrameUpdated);
 
     if (id == Kdenlive::ProjectMonitor) {
         // TODO: reimplement
@@ -517,6 +518,8 @@ void Monitor::setOffsetY(int y)
 void Monitor::slotGetCurrentImage(bool request)
 {
     m_glMonitor->sendFrameForAnalysis = request;
+    // The title widget needs an RGB image
+    m_glMonitor->sendImageForAnalysis = request;
     Kdenlive::MonitorId id = m_monitorManager->activeMonitor()->id();
     m_monitorManager->activateMonitor(m_id);
     refreshMonitorIfActive(true);
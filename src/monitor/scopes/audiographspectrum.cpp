@@ -21,9 +21,7 @@
 
 #include "audiographspectrum.h"
 #include "../monitormanager.h"
-#include "core.h"
 #include "kdenlivesettings.h"
-#include "profiles/profilemodel.hpp"
 
 #include <QAction>
 #include <QFontDatabase>
@@ -32,13 +30,11 @@
 #include <QPainter>
 #include <QVBoxLayout>
 
-#include <KMessageWidget>
 #include <klocalizedstring.h>
 
+#include <algorithm>
 #include <cmath>
 
-#include <mlt++/Mlt.h>
-
 // Code borrowed from Shotcut's audiospectum by Brian Matherly <code@brianmatherly.com> (GPL)
 
 static const int WINDOW_SIZE = 8000; // 6 Hz FFT bins at 48kHz
@@ -276,6 +272,12 @@ void AudioGraphWidget::paintEvent(QPaintEvent *pe)
 AudioGraphSpectrum::AudioGraphSpectrum(MonitorManager *manager, QWidget *parent)
     : ScopeWidget(parent)
     , m_manager(manager)
+    , m_samples(WINDOW_SIZE, 0.f)
+    , m_frequency(0)
+    , m_window(WINDOW_SIZE)
+    , m_fftIn(WINDOW_SIZE)
+    , m_fftOut(WINDOW_SIZE / 2 + 1)
+    , m_bins(WINDOW_SIZE / 2 + 1)
 {
     auto *lay = new QVBoxLayout(this);
     m_graphWidget = new AudioGraphWidget(this);
@@ -286,20 +288,11 @@ AudioGraphSpectrum::AudioGraphSpectrum(MonitorManager *manager, QWidget *parent)
     lay->setStretchFactor(m_graphWidget, 5);
     lay->setStretchFactor(m_equalizer, 3);*/
 
-    m_filter = new Mlt::Filter(pCore->getCurrentProfile()->profile(), "fft");
-    if (!m_filter->is_valid()) {
-        KdenliveSettings::setEnableaudiospectrum(false);
-        auto *mw = new KMessageWidget(this);
-        mw->setCloseButtonVisible(false);
-        mw->setWordWrap(true);
-        mw->setMessageType(KMessageWidget::Information);
-        mw->setText(i18n("MLT must be compiled with libfftw3 to enable Audio Spectrum"));
-        layout()->addWidget(mw);
-        mw->show();
-        setEnabled(false);
-        return;
+    m_fftCfg = kiss_fftr_alloc(WINDOW_SIZE, 0, nullptr, nullptr);
+    // Hann window
+    for (int i = 0; i < WINDOW_SIZE; i++) {
+        m_window[size_t(i)] = float(0.5 * (1 - cos(2 * M_PI * i / (WINDOW_SIZE - 1))));
     }
-    m_filter->set("window_size", WINDOW_SIZE);
     QAction *a = new QAction(i18n("Enable Audio Spectrum"), this);
     a->setCheckable(true);
     a->setChecked(KdenliveSettings::enableaudiospectrum());
@@ -314,7 +307,7 @@ AudioGraphSpectrum::AudioGraphSpectrum(MonitorManager *manager, QWidget *parent)
 AudioGraphSpectrum::~AudioGraphSpectrum()
 {
     delete m_graphWidget;
-    delete m_filter;
+    kiss_fftr_free(m_fftCfg);
 }
 
 void AudioGraphSpectrum::dockVisible(bool visible)
@@ -345,34 +338,51 @@ void AudioGraphSpectrum::refreshPixmap()
     }
 }
 
+void AudioGraphSpectrum::queueFrame(const SharedFrame &frame)
+{
+    m_audioQueue.push(frame);
+}
+
 void AudioGraphSpectrum::refreshScope(const QSize & /*size*/, bool /*full*/)
 {
-    SharedFrame sFrame;
-    while (m_queue.count() > 0) {
-        sFrame = m_queue.pop();
-        if (sFrame.is_valid() && sFrame.get_audio_samples() > 0) {
-            mlt_audio_format format = mlt_audio_s16;
-            int channels = sFrame.get_audio_channels();
-            int frequency = sFrame.get_audio_frequency();
-            int samples = sFrame.get_audio_samples();
-            Mlt::Frame mFrame = sFrame.clone(true, false, false);
-            m_filter->process(mFrame);
-            mFrame.get_audio(format, frequency, channels, samples);
-            if (samples == 0 || format == 0) {
-                // There was an error processing audio from frame
-                continue;
+    int received = m_audioQueue.popAll([this](const AudioSampleQueue::Block &block) {
+        m_frequency = block.frequency;
+        // Slide the analysis window and append the new samples, mixed down to mono
+        const int count = qMin(block.samples, WINDOW_SIZE);
+        std::move(m_samples.begin() + count, m_samples.end(), m_samples.begin());
+        float *out = m_samples.data() + WINDOW_SIZE - count;
+        const float *in = block.data.data() + size_t(block.samples - count) * size_t(block.channels);
+        const float scale = 1.f / block.channels;
+        for (int i = 0; i < count; ++i) {
+            float sum = 0;
+            for (int c = 0; c < block.channels; ++c) {
+                sum += in[i * block.channels + c];
             }
-            processSpectrum();
+            out[i] = sum * scale;
         }
+    });
+    if (received == 0 || m_frequency <= 0) {
+        return;
+    }
+    // A single transform for all the frames received since last refresh
+    for (int i = 0; i < WINDOW_SIZE; ++i) {
+        m_fftIn[size_t(i)] = m_samples[size_t(i)] * m_window[size_t(i)];
+    }
+    kiss_fftr(m_fftCfg, m_fftIn.data(), m_fftOut.data());
+    // Amplitude of each bin, so that a full scale sine gives 1. The Hann window halves the amplitude
+    const float norm = 4.f / WINDOW_SIZE;
+    for (size_t bin = 0; bin < m_bins.size(); ++bin) {
+        m_bins[bin] = std::sqrt(m_fftOut[bin].r * m_fftOut[bin].r + m_fftOut[bin].i * m_fftOut[bin].i) * norm;
     }
+    processSpectrum((double)m_frequency / WINDOW_SIZE);
 }
 
-void AudioGraphSpectrum::processSpectrum()
+void AudioGraphSpectrum::processSpectrum(double binWidth)
 {
     QVector<double> bands(AUDIBLE_BAND_COUNT);
-    auto *bins = (float *)m_filter->get_data("bins");
-    int bin_count = m_filter->get_int("bin_count");
-    double bin_width = m_filter->get_double("bin_width");
+    const float *bins = m_bins.data();
+    int bin_count = int(m_bins.size());
+    double bin_width = binWidth;
 
     int band = 0;
     bool firstBandFound = false;
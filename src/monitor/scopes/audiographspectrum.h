@@ -28,6 +28,8 @@
 #ifndef AUDIOGRAPHSPECTRUM_H
 #define AUDIOGRAPHSPECTRUM_H
 
+#include "audiosamplequeue.h"
+#include "lib/external/kiss_fft/tools/kiss_fftr.h"
 #include "scopewidget.h"
 #include "sharedframe.h"
 
@@ -35,9 +37,7 @@
 #include <QVector>
 #include <QWidget>
 
-namespace Mlt {
-class Filter;
-}
+#include <vector>
 
 class MonitorManager;
 
@@ -84,11 +84,22 @@ public:
 
 private:
     MonitorManager *m_manager;
-    Mlt::Filter *m_filter;
     AudioGraphWidget *m_graphWidget;
     // EqualizerWidget *m_equalizer;
-    void processSpectrum();
+    AudioSampleQueue m_audioQueue;
+    // Last samples received, mixed down to mono, oldest first
+    std::vector<float> m_samples;
+    int m_frequency;
+    // FFT configuration and buffers, only used in the refresh thread
+    kiss_fftr_cfg m_fftCfg;
+    std::vector<float> m_window;
+    std::vector<float> m_fftIn;
+    std::vector<kiss_fft_cpx> m_fftOut;
+    std::vector<float> m_bins;
+    void processSpectrum(double binWidth);
     void refreshScope(const QSize &size, bool full) override;
+    /** @brief Only keep the audio samples of the frame */
+    void queueFrame(const SharedFrame &frame) override;
 
 public slots:
     void refreshPixmap();
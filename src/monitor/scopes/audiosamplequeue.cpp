@@ -0,0 +1,176 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "audiosamplequeue.h"
+#include "sharedframe.h"
+
+#include <QtGlobal>
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+AudioSampleQueue::AudioSampleQueue(int size)
+    : m_blocks(size_t(qMax(2, size)))
+{
+}
+
+bool AudioSampleQueue::push(const SharedFrame &frame)
+{
+    if (!frame.is_valid()) {
+        return false;
+    }
+    const int channels = frame.get_audio_channels();
+    const int samples = frame.get_audio_samples();
+    if (channels <= 0 || samples <= 0) {
+        return false;
+    }
+    const int head = m_head.load(std::memory_order_relaxed);
+    const int next = (head + 1) % int(m_blocks.size());
+    if (next == m_tail.load(std::memory_order_acquire)) {
+        // The consumer did not release this block yet
+        return false;
+    }
+    const mlt_audio_format format = frame.get_audio_format();
+    const void *audio = frame.get_audio();
+    if (audio == nullptr) {
+        return false;
+    }
+    Block &block = m_blocks[size_t(head)];
+    const size_t count = size_t(channels) * size_t(samples);
+    block.data.resize(count);
+    float *out = block.data.data();
+    switch (format) {
+    case mlt_audio_s16: {
+        const auto *in = static_cast<const int16_t *>(audio);
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = float(in[i]) / 32768.f;
+        }
+        break;
+    }
+    case mlt_audio_s32le: {
+        const auto *in = static_cast<const int32_t *>(audio);
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = float(in[i]) / 2147483648.f;
+        }
+        break;
+    }
+    case mlt_audio_f32le: {
+        const auto *in = static_cast<const float *>(audio);
+        std::copy(in, in + count, out);
+        break;
+    }
+    case mlt_audio_s32: {
+        // Planar formats
+        const auto *in = static_cast<const int32_t *>(audio);
+        for (int c = 0; c < channels; ++c) {
+            for (int s = 0; s < samples; ++s) {
+                out[s * channels + c] = float(in[c * samples + s]) / 2147483648.f;
+            }
+        }
+        break;
+    }
+    case mlt_audio_float: {
+        const auto *in = static_cast<const float *>(audio);
+        for (int c = 0; c < channels; ++c) {
+            for (int s = 0; s < samples; ++s) {
+                out[s * channels + c] = in[c * samples + s];
+            }
+        }
+        break;
+    }
+    default:
+        return false;
+    }
+    block.channels = channels;
+    block.samples = samples;
+    block.frequency = frame.get_audio_frequency();
+    m_head.store(next, std::memory_order_release);
+    return true;
+}
+
+int AudioSampleQueue::popAll(const std::function<void(const Block &)> &process)
+{
+    int tail = m_tail.load(std::memory_order_relaxed);
+    const int head = m_head.load(std::memory_order_acquire);
+    int processed = 0;
+    while (tail != head) {
+        process(m_blocks[size_t(tail)]);
+        tail = (tail + 1) % int(m_blocks.size());
+        // Release the block as soon as possible so that the producer can reuse it
+        m_tail.store(tail, std::memory_order_release);
+        processed++;
+    }
+    return processed;
+}
+
+void AudioSampleQueue::sumSquares(const Block &block, std::vector<double> &sums)
+{
+    const int channels = block.channels;
+    sums.assign(size_t(qMax(0, channels)), 0.);
+    if (channels <= 0 || block.samples <= 0) {
+        return;
+    }
+    const float *data = block.data.data();
+    const size_t count = size_t(channels) * size_t(block.samples);
+    size_t i = 0;
+#ifdef __SSE2__
+    // Interleaved samples repeat their channel layout every lcm(channels, 4) floats, so that each lane of each
+    // accumulator always receives the same channel
+    const int period = channels % 4 == 0 ? channels : (channels % 2 == 0 ? 2 * channels : 4 * channels);
+    const int vectors = period / 4;
+    if (vectors <= 16) {
+        __m128 acc[16];
+        double totals[64] = {};
+        auto flush = [&]() {
+            for (int v = 0; v < vectors; ++v) {
+                alignas(16) float lanes[4];
+                _mm_store_ps(lanes, acc[v]);
+                for (int l = 0; l < 4; ++l) {
+                    totals[v * 4 + l] += lanes[l];
+                }
+                acc[v] = _mm_setzero_ps();
+            }
+        };
+        for (int v = 0; v < vectors; ++v) {
+            acc[v] = _mm_setzero_ps();
+        }
+        int pending = 0;
+        for (; i + size_t(period) <= count; i += size_t(period)) {
+            for (int v = 0; v < vectors; ++v) {
+                const __m128 x = _mm_loadu_ps(data + i + size_t(v) * 4);
+                acc[v] = _mm_add_ps(acc[v], _mm_mul_ps(x, x));
+            }
+            // Keep the float sums short to preserve precision
+            if (++pending == 256) {
+                flush();
+                pending = 0;
+            }
+        }
+        flush();
+        for (int p = 0; p < period; ++p) {
+            sums[size_t(p % channels)] += totals[p];
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        sums[i % size_t(channels)] += double(data[i]) * data[i];
+    }
+}
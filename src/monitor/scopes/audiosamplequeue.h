@@ -0,0 +1,81 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef AUDIOSAMPLEQUEUE_H
+#define AUDIOSAMPLEQUEUE_H
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+class SharedFrame;
+
+/*!
+  \class AudioSampleQueue
+  \brief Lock-free queue passing the audio samples of displayed frames to the audio scopes.
+
+  Only the samples are copied, converted to interleaved floats in the [-1, 1] range, so that
+  the scopes don't need to keep or clone MLT frames. The queue has a fixed number of blocks
+  whose buffers are reused, so that no allocation happens once the buffers are large enough.
+
+  There must be a single producer calling push() (the GUI thread receiving the frames) and a
+  single consumer calling popAll() (the scope refresh, which never runs concurrently with itself).
+  If the consumer falls behind, new frames are dropped until it catches up.
+*/
+class AudioSampleQueue
+{
+public:
+    struct Block
+    {
+        int channels{0};
+        int frequency{0};
+        int samples{0};
+        std::vector<float> data;
+    };
+
+    explicit AudioSampleQueue(int size = 8);
+
+    /*!
+      Copies the audio of a frame into the queue. Must only be called by the producer.
+      Returns false if the frame has no usable audio or if the queue is full.
+    */
+    bool push(const SharedFrame &frame);
+
+    /*!
+      Calls \a process for each queued block, oldest first, and removes them from the queue.
+      Must only be called by the consumer. Returns the number of processed blocks.
+    */
+    int popAll(const std::function<void(const Block &)> &process);
+
+    /*!
+      Sets \a sums to the sum of the squared samples of each channel of \a block.
+      Uses SSE2 when available, accumulating in floats and flushing to doubles regularly.
+    */
+    static void sumSquares(const Block &block, std::vector<double> &sums);
+
+private:
+    std::vector<Block> m_blocks;
+    // Next block to write, only modified by the producer
+    std::atomic<int> m_head{0};
+    // Next block to read, only modified by the consumer
+    std::atomic<int> m_tail{0};
+};
+
+#endif
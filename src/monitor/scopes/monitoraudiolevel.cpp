@@ -20,12 +20,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "monitoraudiolevel.h"
-#include "core.h"
-#include "profiles/profilemodel.hpp"
-
-#include "mlt++/Mlt.h"
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 #include <QFont>
 #include <QPaintEvent>
@@ -50,12 +48,7 @@ MonitorAudioLevel::MonitorAudioLevel(int height, QWidget *parent)
     , m_channelFillHeight(m_channelHeight)
 {
     setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::Preferred);
-    m_filter.reset(new Mlt::Filter(pCore->getCurrentProfile()->profile(), "audiolevel"));
-    if (!m_filter->is_valid()) {
-        isValid = false;
-        return;
-    }
-    m_filter->set("iec_scale", 0);
+    // Levels are computed from the frame samples, there is no MLT filter that could be missing
     isValid = true;
 }
 
@@ -63,31 +56,35 @@ MonitorAudioLevel::~MonitorAudioLevel()
 {
 }
 
+void MonitorAudioLevel::queueFrame(const SharedFrame &frame)
+{
+    m_audioQueue.push(frame);
+}
+
 void MonitorAudioLevel::refreshScope(const QSize & /*size*/, bool /*full*/)
 {
-    SharedFrame sFrame;
-    while (m_queue.count() > 0) {
-        sFrame = m_queue.pop();
-        if (sFrame.is_valid() && sFrame.get_audio_samples() > 0) {
-            mlt_audio_format format = mlt_audio_s16;
-            int channels = sFrame.get_audio_channels();
-            int frequency = sFrame.get_audio_frequency();
-            int samples = sFrame.get_audio_samples();
-            Mlt::Frame mFrame = sFrame.clone(true, false, false);
-            m_filter->process(mFrame);
-            mFrame.get_audio(format, frequency, channels, samples);
-            if (samples == 0) {
-                // There was an error processing audio from frame
-                continue;
-            }
-            QVector<int> levels;
-            for (int i = 0; i < audioChannels; i++) {
-                QString s = QStringLiteral("meta.media.audio_level.%1").arg(i);
-                levels << (int)levelToDB(mFrame.get_double(s.toLatin1().constData()));
-            }
-            QMetaObject::invokeMethod(this, "setAudioValues", Qt::QueuedConnection, Q_ARG(const QVector<int> &, levels));
+    // Process all the frames received since last refresh at once and display the loudest level of each channel
+    const int channels = audioChannels;
+    std::vector<double> levels;
+    std::vector<double> sums;
+    m_audioQueue.popAll([&](const AudioSampleQueue::Block &block) {
+        const int count = qMin(channels, block.channels);
+        AudioSampleQueue::sumSquares(block, sums);
+        levels.resize(size_t(qMax(0, channels)), 0.);
+        for (int c = 0; c < count; ++c) {
+            // RMS level of the channel
+            levels[size_t(c)] = qMax(levels[size_t(c)], std::sqrt(sums[size_t(c)] / block.samples));
         }
+    });
+    if (levels.empty()) {
+        return;
+    }
+    QVector<int> dbLevels;
+    dbLevels.reserve(int(levels.size()));
+    for (double level : levels) {
+        dbLevels << (int)levelToDB(level);
     }
+    QMetaObject::invokeMethod(this, "setAudioValues", Qt::QueuedConnection, Q_ARG(const QVector<int> &, dbLevels));
 }
 
 void MonitorAudioLevel::resizeEvent(QResizeEvent *event)
@@ -22,14 +22,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MONITORAUDIOLEVEL_H
 #define MONITORAUDIOLEVEL_H
 
+#include "audiosamplequeue.h"
 #include "scopewidget.h"
 #include <QWidget>
 #include <memory>
 
-namespace Mlt {
-class Filter;
-} // namespace Mlt
-
 class MonitorAudioLevel : public ScopeWidget
 {
     Q_OBJECT
@@ -46,7 +43,7 @@ protected:
     void resizeEvent(QResizeEvent *event) override;
 
 private:
-    std::unique_ptr<Mlt::Filter> m_filter;
+    AudioSampleQueue m_audioQueue;
     int m_height;
     QPixmap m_pixmap;
     QVector<int> m_peaks;
@@ -56,6 +53,8 @@ private:
     int m_channelFillHeight;
     void drawBackground(int channels = 2);
     void refreshScope(const QSize &size, bool full) override;
+    /** @brief Only keep the audio samples of the frame */
+    void queueFrame(const SharedFrame &frame) override;
 
 public slots:
     void setAudioValues(const QVector<int> &values);
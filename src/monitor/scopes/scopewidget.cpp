@@ -35,10 +35,15 @@ ScopeWidget::~ScopeWidget() = default;
 
 void ScopeWidget::onNewFrame(const SharedFrame &frame)
 {
-    m_queue.push(frame);
+    queueFrame(frame);
     requestRefresh();
 }
 
+void ScopeWidget::queueFrame(const SharedFrame &frame)
+{
+    m_queue.push(frame);
+}
+
 void ScopeWidget::requestRefresh()
 {
     if (m_future.isFinished()) {
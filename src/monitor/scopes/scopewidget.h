@@ -102,6 +102,14 @@ protected:
     */
     virtual void refreshScope(const QSize &size, bool full) = 0;
 
+    /*!
+      Stores a frame received by onNewFrame() until refreshScope() processes it.
+
+      The default implementation places it in m_queue. Scopes that don't need the
+      whole frame may reimplement it to only keep what they use.
+    */
+    virtual void queueFrame(const SharedFrame &frame);
+
     /*!
       Stores frames received by onNewFrame().
 
@@ -22,6 +22,7 @@ the Free Software Foundation, either version 3 of the License, or
 #include "project/dialogs/backupwidget.h"
 #include "project/dialogs/noteswidget.h"
 #include "project/dialogs/projectsettings.h"
+#include "utils/mediaprobecache.hpp"
 #include "utils/thumbnailcache.hpp"
 #include "xml/xml.hpp"
 
@@ -257,6 +258,8 @@ bool ProjectManager::closeCurrentDocument(bool saveChanges, bool quit)
         }
     }
     pCore->jobManager()->slotCancelJobs();
+    MediaProbeCache::get()->cancelRevalidation();
+    MediaProbeCache::get()->save();
     disconnect(pCore->window()->getMainTimeline()->controller(), &TimelineController::durationChanged, this, &ProjectManager::adjustProjectDuration);
     pCore->window()->getMainTimeline()->controller()->clipActions.clear();
     pCore->window()->getMainTimeline()->controller()->prepareClose();
@@ -906,6 +909,9 @@ bool ProjectManager::updateTimeline(int pos, int scrollPos)
         pCore->window()->getMainTimeline()->controller()->setActiveTrack(m_mainTimelineModel->getTrackIndexFromPosition(activeTrackPosition));
     }
     m_mainTimelineModel->setUndoStack(m_project->commandStack());
+    // Clips created from the media probe cache can now safely be checked and reloaded
+    MediaProbeCache::get()->save();
+    MediaProbeCache::get()->startRevalidation();
     return true;
 }
 
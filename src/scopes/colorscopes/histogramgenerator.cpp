@@ -10,6 +10,8 @@
 
 #include "histogramgenerator.h"
 #include "colorconstants.h"
+#include "scopeframe.h"
+#include "scopetiles.h"
 
 #include "klocalizedstring.h"
 #include <QImage>
@@ -19,11 +21,11 @@
 
 HistogramGenerator::HistogramGenerator() = default;
 
-QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QImage &image, const int &components,
+QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const ScopeFrame &frame, const int &components,
                                               ITURec rec, bool unscaled, bool logScale,
                                               uint accelFactor) const
 {
-    if (paradeSize.height() <= 0 || paradeSize.width() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (paradeSize.height() <= 0 || paradeSize.width() <= 0 || frame.isNull()) {
         return QImage();
     }
 
@@ -33,41 +35,53 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QIm
     bool drawB = (components & HistogramGenerator::ComponentB) != 0;
     bool drawSum = (components & HistogramGenerator::ComponentSum) != 0;
 
-    int r[256], g[256], b[256], y[256], s[766];
-    // Initialize the values to zero
-    std::fill(r, r + 256, 0);
-    std::fill(g, g + 256, 0);
-    std::fill(b, b + 256, 0);
-    std::fill(y, y + 256, 0);
-    std::fill(s, s + 766, 0);
-
     const uint ww = (uint)paradeSize.width();
     const uint wh = (uint)paradeSize.height();
 
-    // Read the stats from the input image
-    for (int Y = 0; Y < image.height(); ++Y) {
-        for (int X = 0; X < image.width(); X += (int)accelFactor) {
-
-            QRgb col = image.pixel(X, Y);
-            r[qRed(col)]++;
-            g[qGreen(col)]++;
-            b[qBlue(col)]++;
-
+    // Read the stats from the input frame. Each tile counts in its own r, g, b, y and sum bins
+    const int step = (int)accelFactor;
+    const int samples = (frame.width() + step - 1) / step;
+    const int binCount = 5 * 256;
+    const int tiles = ScopeTiles::tileCount(frame.height());
+    QVector<int> bins(binCount * tiles, 0);
+    int *binData = bins.data();
+
+    ScopeTiles::forEachTile(frame.height(), tiles, [&](int tile, int first, int end) {
+        int *tileR = binData + size_t(tile) * binCount;
+        int *tileG = tileR + 256;
+        int *tileB = tileG + 256;
+        int *tileY = tileB + 256;
+        QVector<QRgb> pixels(samples);
+        QRgb *line = pixels.data();
+        QVector<uchar> luma(drawY ? samples : 0);
+        for (int row = first; row < end; ++row) {
+            frame.rgbRow(row, samples, step, line);
+            for (int k = 0; k < samples; ++k) {
+                const QRgb col = line[k];
+                tileR[qRed(col)]++;
+                tileG[qGreen(col)]++;
+                tileB[qBlue(col)]++;
+            }
             if (drawY) {
-                // Use if branch to avoid expensive multiplication if Y disabled
-                if (rec == ITURec::Rec_601) {
-                    y[(int)floor(REC_601_R * (float) qRed(col) + REC_601_G * (float) qGreen(col) + REC_601_B * (float) qBlue(col))]++;
-                } else {
-                    y[(int)floor(REC_709_R * (float) qRed(col) + REC_709_G * (float) qGreen(col) + REC_709_B * (float) qBlue(col))]++;
+                // Only compute the luma if Y is enabled
+                frame.lumaRow(row, samples, step, rec, luma.data());
+                for (int k = 0; k < samples; ++k) {
+                    tileY[luma.at(k)]++;
                 }
             }
-
-            if (drawSum) {
-                // Use an if branch here because the sum takes more operations than rgb
-                s[qRed(col)]++;
-                s[qGreen(col)]++;
-                s[qBlue(col)]++;
-            }
+        }
+    });
+    ScopeTiles::mergeTiles(bins, binCount, tiles);
+
+    const int *r = bins.constData();
+    const int *g = r + 256;
+    const int *b = g + 256;
+    const int *y = b + 256;
+    // The sum of the components is the sum of the r, g and b bins
+    int *s = bins.data() + 4 * 256;
+    if (drawSum) {
+        for (int i = 0; i < 256; ++i) {
+            s[i] = r[i] + g[i] + b[i];
         }
     }
 
@@ -83,8 +97,8 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QIm
     // Height of a single histogram box without text
     const int partH = int((int)wh - nParts * d) / nParts;
 
-    // Total number of bytes of the image
-    const uint byteCount = (uint) image.sizeInBytes();
+    // Total number of bytes of the frame as an RGB32 image
+    const uint byteCount = 4 * uint(frame.width()) * uint(frame.height());
 
     // Factor for scaling the measured value to the histogram.
     // This factor is used for linear scaling and does not depend
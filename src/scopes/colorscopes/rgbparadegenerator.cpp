@@ -9,6 +9,8 @@
  ***************************************************************************/
 
 #include "rgbparadegenerator.h"
+#include "scopeframe.h"
+#include "scopetiles.h"
 #include "klocalizedstring.h"
 #include <QColor>
 #include <QPainter>
@@ -23,21 +25,14 @@ const QColor RGBParadeGenerator::colSoft(150, 150, 150, 255);
 const uchar RGBParadeGenerator::distRight(40);
 const uchar RGBParadeGenerator::distBottom(40);
 
-struct StructRGB
-{
-    uint r;
-    uint g;
-    uint b;
-};
-
 RGBParadeGenerator::RGBParadeGenerator() = default;
 
-QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QImage &image, const RGBParadeGenerator::PaintMode paintMode, bool drawAxis,
+QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const ScopeFrame &frame, const RGBParadeGenerator::PaintMode paintMode, bool drawAxis,
                                               bool drawGradientRef, uint accelFactor)
 {
     Q_ASSERT(accelFactor >= 1);
 
-    if (paradeSize.width() <= 0 || paradeSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (paradeSize.width() <= 0 || paradeSize.height() <= 0 || frame.isNull()) {
         return QImage();
     }
     QImage parade(paradeSize, QImage::Format_ARGB32);
@@ -47,90 +42,110 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QIm
 
     const uint ww = (uint)paradeSize.width();
     const uint wh = (uint)paradeSize.height();
-    const uint iw = (uint)image.bytesPerLine();
-    const uint ih = (uint)image.height();
-    const uint byteCount = iw * ih; // Note that 1 px = 4 B
-
     const uchar offset = 10;
+    if (ww <= 2 * offset + distRight + 3 || wh <= distBottom) {
+        return QImage();
+    }
+    const int iw = frame.width();
+    const int ih = frame.height();
+
     const uint partW = (ww - 2 * offset - distRight) / 3;
     const uint partH = wh - distBottom;
 
-    // Statistics
-    uchar minR = 255, minG = 255, minB = 255, maxR = 0, maxG = 0, maxB = 0, r, g, b;
-
     // Number of input pixels that will fall on one scope pixel.
     // Must be a float because the acceleration factor can be high, leading to <1 expected px per px.
-    const float pixelDepth = (float)((byteCount >> 2) / accelFactor) / float(partW * 255);
+    const float pixelDepth = (float)(uint(iw * ih) / accelFactor) / float(partW * 255);
     const float gain = 255 / (8 * pixelDepth);
     //        qCDebug(KDENLIVE_LOG) << "Pixel depth: expected " << pixelDepth << "; Gain: using " << gain << " (acceleration: " << accelFactor << "x)";
 
     QImage unscaled((int)ww - distRight, 256, QImage::Format_ARGB32);
     unscaled.fill(qRgba(0, 0, 0, 0));
 
-    const float wPrediv = (float)(partW - 1) / float((int)iw - 1);
-
-    std::vector<std::vector<StructRGB>> paradeVals(partW, std::vector<StructRGB>(256, {0, 0, 0}));
-
-    const uchar *bits = image.bits();
-    const uint stepsize = uint(uint(image.depth() / 8) * accelFactor);
-
-    for (uint i = 0, x = 0; i < byteCount; i += stepsize) {
-        auto *col = (const QRgb *)(bits);
-        r = (uchar)qRed(*col);
-        g = (uchar)qGreen(*col);
-        b = (uchar)qBlue(*col);
-
-        double dx = x * (double)wPrediv;
+    const float wPrediv = (float)(partW - 1) / float(qMax(1, iw - 1));
 
-        paradeVals[(size_t)dx][r].r++;
-        paradeVals[(size_t)dx][g].g++;
-        paradeVals[(size_t)dx][b].b++;
+    // One pixel out of accelFactor is analysed on each row, we store the parade column of each of them
+    const int step = (int)accelFactor;
+    const int samples = (iw + step - 1) / step;
+    QVector<int> columns(samples);
+    for (int k = 0; k < samples; ++k) {
+        columns[k] = int(float(k * step) * wPrediv);
+    }
 
-        if (r < minR) {
-            minR = r;
-        }
-        if (g < minG) {
-            minG = g;
-        }
-        if (b < minB) {
-            minB = b;
-        }
-        if (r > maxR) {
-            maxR = r;
-        }
-        if (g > maxG) {
-            maxG = g;
-        }
-        if (b > maxB) {
-            maxB = b;
+    // Each tile accumulates in a red, a green and a blue plane of 256 rows of partW values
+    const int planeSize = (int)partW * 256;
+    const int cells = 3 * planeSize;
+    const int tiles = ScopeTiles::tileCount(ih);
+    QVector<uint> paradeVals(cells * tiles, 0);
+    QVector<uchar> tileMin(3 * tiles, 255);
+    QVector<uchar> tileMax(3 * tiles, 0);
+    uint *valueData = paradeVals.data();
+    uchar *minData = tileMin.data();
+    uchar *maxData = tileMax.data();
+    const int *columnData = columns.constData();
+
+    ScopeTiles::forEachTile(ih, tiles, [&](int tile, int first, int end) {
+        uint *red = valueData + size_t(tile) * size_t(cells);
+        uint *green = red + planeSize;
+        uint *blue = green + planeSize;
+        uint minR = 255, minG = 255, minB = 255, maxR = 0, maxG = 0, maxB = 0;
+        // RGB pixels of the row, converted from YUV if needed
+        QVector<QRgb> pixels(samples);
+        QRgb *line = pixels.data();
+        for (int row = first; row < end; ++row) {
+            frame.rgbRow(row, samples, step, line);
+            for (int k = 0; k < samples; ++k) {
+                const QRgb px = line[k];
+                const uint r = (px >> 16) & 0xff;
+                const uint g = (px >> 8) & 0xff;
+                const uint b = px & 0xff;
+                const int col = columnData[k];
+                red[r * partW + col]++;
+                green[g * partW + col]++;
+                blue[b * partW + col]++;
+                minR = qMin(minR, r);
+                minG = qMin(minG, g);
+                minB = qMin(minB, b);
+                maxR = qMax(maxR, r);
+                maxG = qMax(maxG, g);
+                maxB = qMax(maxB, b);
+            }
         }
+        minData[3 * tile] = uchar(minR);
+        minData[3 * tile + 1] = uchar(minG);
+        minData[3 * tile + 2] = uchar(minB);
+        maxData[3 * tile] = uchar(maxR);
+        maxData[3 * tile + 1] = uchar(maxG);
+        maxData[3 * tile + 2] = uchar(maxB);
+    });
+    ScopeTiles::mergeTiles(paradeVals, cells, tiles);
 
-        bits += stepsize;
-        x += stepsize;
-        x %= iw; // Modulo image width, to represent the current x position in the image
+    // Statistics
+    uchar minR = 255, minG = 255, minB = 255, maxR = 0, maxG = 0, maxB = 0;
+    for (int tile = 0; tile < tiles; ++tile) {
+        minR = qMin(minR, tileMin.at(3 * tile));
+        minG = qMin(minG, tileMin.at(3 * tile + 1));
+        minB = qMin(minB, tileMin.at(3 * tile + 2));
+        maxR = qMax(maxR, tileMax.at(3 * tile));
+        maxG = qMax(maxG, tileMax.at(3 * tile + 1));
+        maxB = qMax(maxB, tileMax.at(3 * tile + 2));
     }
 
     const int offset1 = (int)partW + (int)offset;
     const int offset2 = 2 * (int)partW + 2 * (int)offset;
-    switch (paintMode) {
-    case PaintMode_RGB:
-        for (int i = 0; i < (int)partW; ++i) {
-            for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i, j, qRgba(255, 10, 10, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].r)));
-                unscaled.setPixel(i + offset1, j, qRgba(10, 255, 10, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].g)));
-                unscaled.setPixel(i + offset2, j, qRgba(10, 10, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].b)));
-            }
-        }
-        break;
-    default:
+    const QRgb colorR = paintMode == PaintMode_RGB ? qRgb(255, 10, 10) : qRgb(255, 255, 255);
+    const QRgb colorG = paintMode == PaintMode_RGB ? qRgb(10, 255, 10) : qRgb(255, 255, 255);
+    const QRgb colorB = paintMode == PaintMode_RGB ? qRgb(10, 10, 255) : qRgb(255, 255, 255);
+    const uint *red = paradeVals.constData();
+    const uint *green = red + planeSize;
+    const uint *blue = green + planeSize;
+    for (int j = 0; j < 256; ++j) {
+        auto *line = reinterpret_cast<QRgb *>(unscaled.scanLine(j));
+        const size_t rowStart = size_t(j) * partW;
         for (int i = 0; i < (int)partW; ++i) {
-            for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i, j, qRgba(255, 255, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].r)));
-                unscaled.setPixel(i + offset1, j, qRgba(255, 255, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].g)));
-                unscaled.setPixel(i + offset2, j, qRgba(255, 255, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].b)));
-            }
+            line[i] = (colorR & 0xffffff) | (uint(CHOP255(gain * (float)red[rowStart + i])) << 24);
+            line[i + offset1] = (colorG & 0xffffff) | (uint(CHOP255(gain * (float)green[rowStart + i])) << 24);
+            line[i + offset2] = (colorB & 0xffffff) | (uint(CHOP255(gain * (float)blue[rowStart + i])) << 24);
         }
-        break;
     }
 
     // Scale the image to the target height. Scaling is not accomplished before because
@@ -16,6 +16,7 @@
 class QColor;
 class QImage;
 class QSize;
+class ScopeFrame;
 class RGBParadeGenerator : public QObject
 {
     Q_OBJECT
@@ -23,7 +24,7 @@ public:
     enum PaintMode { PaintMode_RGB, PaintMode_White };
 
     RGBParadeGenerator();
-    QImage calculateRGBParade(const QSize &paradeSize, const QImage &image, const RGBParadeGenerator::PaintMode paintMode, bool drawAxis, bool drawGradientRef,
+    QImage calculateRGBParade(const QSize &paradeSize, const ScopeFrame &frame, const RGBParadeGenerator::PaintMode paintMode, bool drawAxis, bool drawGradientRef,
                               uint accelFactor = 1);
 
     static const QColor colHighlight;
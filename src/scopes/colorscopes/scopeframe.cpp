@@ -0,0 +1,169 @@
+/***************************************************************************
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "scopeframe.h"
+#include "scopetiles.h"
+
+#include <cmath>
+
+namespace {
+/**
+ * Lookup tables converting limited range YUV samples to RGB, with the
+ * coefficients of the monitor shader. Values are in 16 bit fixed point.
+ */
+struct YuvTables
+{
+    explicit YuvTables(ITURec matrix)
+    {
+        const bool rec601 = matrix == ITURec::Rec_601;
+        const double rv = rec601 ? 1.5958 : 1.793;
+        const double gu = rec601 ? 0.39173 : 0.213;
+        const double gv = rec601 ? 0.8129 : 0.533;
+        const double bu = rec601 ? 2.017 : 2.112;
+        for (int i = 0; i < 256; ++i) {
+            // The rounding offset is added once, with the luma term
+            y[i] = int(std::lround((1.1643 * (i - 16) + 0.5) * 65536));
+            const double c = (i - 128) * 65536.;
+            red[i] = int(std::lround(rv * c));
+            greenU[i] = int(std::lround(-gu * c));
+            greenV[i] = int(std::lround(-gv * c));
+            blue[i] = int(std::lround(bu * c));
+            luma[i] = uchar(qBound(0, int(std::lround((i - 16) * 255. / 219.)), 255));
+        }
+    }
+    int y[256];
+    int red[256];
+    int greenU[256];
+    int greenV[256];
+    int blue[256];
+    // Y expanded to full range
+    uchar luma[256];
+};
+
+const YuvTables &tables(ITURec matrix)
+{
+    static const YuvTables rec601(ITURec::Rec_601);
+    static const YuvTables rec709(ITURec::Rec_709);
+    return matrix == ITURec::Rec_601 ? rec601 : rec709;
+}
+
+inline int clip(int value)
+{
+    return value < 0 ? 0 : (value > 0xffffff ? 255 : value >> 16);
+}
+
+inline QRgb convert(const YuvTables &t, uchar y, uchar cb, uchar cr)
+{
+    const int luma = t.y[y];
+    return qRgb(clip(luma + t.red[cr]), clip(luma + t.greenU[cb] + t.greenV[cr]), clip(luma + t.blue[cb]));
+}
+} // namespace
+
+ScopeFrame::ScopeFrame(const QImage &image)
+    : m_image(image.depth() == 32 ? image : image.convertToFormat(QImage::Format_RGB32))
+    , m_width(m_image.width())
+    , m_height(m_image.height())
+{
+}
+
+ScopeFrame::ScopeFrame(const SharedFrame &frame, int colorspace)
+    : m_frame(frame)
+    , m_matrix(colorspace == 601 ? ITURec::Rec_601 : ITURec::Rec_709)
+{
+    if (!frame.is_valid() || frame.get_image_format() != mlt_image_yuv420p) {
+        return;
+    }
+    const int width = frame.get_image_width();
+    const int height = frame.get_image_height();
+    const uchar *image = frame.get_image();
+    if (image == nullptr || width < 2 || height < 2) {
+        return;
+    }
+    // Same layout as the textures uploaded by the monitor
+    m_planes[0] = image;
+    m_planes[1] = image + width * height;
+    m_planes[2] = m_planes[1] + (width / 2) * (height / 2);
+    m_width = width;
+    m_height = height;
+    m_yuv = true;
+}
+
+const QRgb *ScopeFrame::rgbLine(int row) const
+{
+    return reinterpret_cast<const QRgb *>(m_image.constScanLine(row));
+}
+
+const uchar *ScopeFrame::yLine(int row) const
+{
+    return m_planes[0] + row * m_width;
+}
+
+const uchar *ScopeFrame::cbLine(int chromaRow) const
+{
+    return m_planes[1] + qMin(chromaRow, chromaHeight() - 1) * chromaWidth();
+}
+
+const uchar *ScopeFrame::crLine(int chromaRow) const
+{
+    return m_planes[2] + qMin(chromaRow, chromaHeight() - 1) * chromaWidth();
+}
+
+void ScopeFrame::rgbRow(int row, int count, int step, QRgb *dst) const
+{
+    if (!m_yuv) {
+        const QRgb *line = rgbLine(row);
+        for (int i = 0; i < count; ++i) {
+            dst[i] = line[i * step];
+        }
+        return;
+    }
+    const YuvTables &t = tables(m_matrix);
+    const uchar *y = yLine(row);
+    const uchar *cb = cbLine(row / 2);
+    const uchar *cr = crLine(row / 2);
+    // Odd widths have no chroma sample for the last column
+    const int lastChroma = chromaWidth() - 1;
+    for (int i = 0; i < count; ++i) {
+        const int x = i * step;
+        const int c = qMin(x / 2, lastChroma);
+        dst[i] = convert(t, y[x], cb[c], cr[c]);
+    }
+}
+
+void ScopeFrame::lumaRow(int row, int count, int step, ITURec rec, uchar *dst) const
+{
+    const ScopeTiles::LumaWeights weights(rec);
+    if (!m_yuv) {
+        ScopeTiles::lumaRow(rgbLine(row), count, step, weights, dst);
+        return;
+    }
+    const YuvTables &t = tables(m_matrix);
+    const uchar *y = yLine(row);
+    if (rec == m_matrix) {
+        // The Y plane already is the requested luma
+        for (int i = 0; i < count; ++i) {
+            dst[i] = t.luma[y[i * step]];
+        }
+        return;
+    }
+    const uchar *cb = cbLine(row / 2);
+    const uchar *cr = crLine(row / 2);
+    const int lastChroma = chromaWidth() - 1;
+    for (int i = 0; i < count; ++i) {
+        const int x = i * step;
+        const int c = qMin(x / 2, lastChroma);
+        const QRgb px = convert(t, y[x], cb[c], cr[c]);
+        ScopeTiles::lumaRow(&px, 1, 1, weights, dst + i);
+    }
+}
+
+QRgb ScopeFrame::toRgb(uchar y, uchar cb, uchar cr) const
+{
+    return convert(tables(m_matrix), y, cb, cr);
+}
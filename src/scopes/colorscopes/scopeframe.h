@@ -0,0 +1,74 @@
+/***************************************************************************
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef KDENLIVE_SCOPEFRAME_H
+#define KDENLIVE_SCOPEFRAME_H
+
+#include "colorconstants.h"
+#include "monitor/scopes/sharedframe.h"
+
+#include <QImage>
+#include <QRgb>
+
+/**
+ * Frame analysed by the colour scopes.
+ *
+ * When the monitor displays a YUV 4:2:0 frame, the scopes read its planes in
+ * place: the frame data is reference counted by SharedFrame, so nothing is
+ * copied or converted before the analysis. Otherwise (GPU rendering), the
+ * frame is the RGB image rendered by the monitor.
+ *
+ * Rows of a YUV frame can also be read as RGB or luma. They are converted
+ * like the monitor shader does: limited range samples, Rec. 601 or Rec. 709
+ * matrix depending on the profile colorspace.
+ */
+class ScopeFrame
+{
+public:
+    ScopeFrame() = default;
+    explicit ScopeFrame(const QImage &image);
+    /** @brief Wraps the planes of @param frame, which must be a yuv420p frame. @param colorspace is the profile colorspace (601 or 709). */
+    ScopeFrame(const SharedFrame &frame, int colorspace);
+
+    bool isNull() const { return m_width <= 0 || m_height <= 0; }
+    /** @brief True if the planes can be read, false for an RGB frame. */
+    bool isYuv() const { return m_yuv; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    /** @brief Matrix used to convert the YUV samples to RGB. */
+    ITURec matrix() const { return m_matrix; }
+
+    /** @brief Pixels of @param row of an RGB frame. */
+    const QRgb *rgbLine(int row) const;
+    /** @brief Planes of a YUV frame. The chroma planes have half the width and height of the luma plane. */
+    const uchar *yLine(int row) const;
+    const uchar *cbLine(int chromaRow) const;
+    const uchar *crLine(int chromaRow) const;
+    int chromaWidth() const { return m_width / 2; }
+    int chromaHeight() const { return m_height / 2; }
+
+    /** @brief Write @param count RGB pixels of @param row to @param dst, taking one pixel every @param step. */
+    void rgbRow(int row, int count, int step, QRgb *dst) const;
+    /** @brief Write the @param rec luma of @param count pixels of @param row to @param dst, taking one pixel every @param step.
+        For a YUV frame whose matrix is @param rec, this is its Y plane expanded to full range. */
+    void lumaRow(int row, int count, int step, ITURec rec, uchar *dst) const;
+    /** @brief Convert a sample of a YUV frame to RGB. */
+    QRgb toRgb(uchar y, uchar cb, uchar cr) const;
+
+private:
+    QImage m_image;
+    SharedFrame m_frame;
+    const uchar *m_planes[3] = {nullptr, nullptr, nullptr};
+    int m_width{0};
+    int m_height{0};
+    bool m_yuv{false};
+    ITURec m_matrix{ITURec::Rec_601};
+};
+
+#endif // KDENLIVE_SCOPEFRAME_H
@@ -0,0 +1,132 @@
+/***************************************************************************
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef KDENLIVE_SCOPETILES_H
+#define KDENLIVE_SCOPETILES_H
+
+#include "colorconstants.h"
+
+#include <QRgb>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent>
+#include <numeric>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Helpers shared by the scope generators: the input frame is split in
+ * horizontal tiles that are analysed in parallel, each tile accumulating
+ * into its own flat buffer. Buffers are summed once all tiles are done,
+ * so no locking happens while scanning pixels.
+ */
+namespace ScopeTiles {
+
+/** @brief Number of tiles used to analyse @param rows rows. */
+inline int tileCount(int rows)
+{
+    // Don't split small images, the thread overhead would dominate
+    return qBound(1, rows / 32, qMax(1, QThread::idealThreadCount()));
+}
+
+/** @brief Call @param process(tile, firstRow, endRow) for each tile, in parallel. Returns when all tiles are done. */
+template <typename F> void forEachTile(int rows, int tiles, F process)
+{
+    if (tiles <= 1) {
+        process(0, 0, rows);
+        return;
+    }
+    QVector<int> indexes(tiles);
+    std::iota(indexes.begin(), indexes.end(), 0);
+    QtConcurrent::blockingMap(indexes, [&](int &tile) { process(tile, rows * tile / tiles, rows * (tile + 1) / tiles); });
+}
+
+/** @brief Add the @param tiles buffers of @param size values stored one after the other in @param buffers into the first one. */
+template <typename T> void mergeTiles(QVector<T> &buffers, int size, int tiles)
+{
+    T *target = buffers.data();
+    for (int tile = 1; tile < tiles; ++tile) {
+        const T *source = buffers.constData() + size_t(tile) * size_t(size);
+        for (int i = 0; i < size; ++i) {
+            target[i] += source[i];
+        }
+    }
+}
+
+/** @brief Luma weights in 16 bit fixed point, summing to at most 65536 so that the result stays on [0,255]. */
+struct LumaWeights
+{
+    explicit LumaWeights(ITURec rec)
+        : r(rec == ITURec::Rec_601 ? 19595 : 13926)
+        , g(rec == ITURec::Rec_601 ? 38470 : 46884)
+        , b(rec == ITURec::Rec_601 ? 7471 : 4725)
+    {
+    }
+    const uint r;
+    const uint g;
+    const uint b;
+};
+
+#ifdef __SSE2__
+/** @brief Weighted sum of the 8 channel values of @param c by @param w, both as unsigned 16 bit values, added to the 32 bit sums @param lo and @param hi. */
+inline void lumaMultiplyAdd(__m128i c, __m128i w, __m128i &lo, __m128i &hi)
+{
+    // 16x16 bit products, split in their low and high halves
+    const __m128i low = _mm_mullo_epi16(c, w);
+    const __m128i high = _mm_mulhi_epu16(c, w);
+    lo = _mm_add_epi32(lo, _mm_unpacklo_epi16(low, high));
+    hi = _mm_add_epi32(hi, _mm_unpackhi_epi16(low, high));
+}
+#endif
+
+/** @brief Compute the luma of @param count pixels of @param src, taking one pixel every @param step.
+    Uses SSE2 when available, converting 8 pixels per iteration. */
+inline void lumaRow(const QRgb *src, int count, int step, const LumaWeights &weights, uchar *dst)
+{
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i mask = _mm_set1_epi32(0xff);
+    // Weights are up to 65535, they are used as unsigned 16 bit values
+    const __m128i wr = _mm_set1_epi16(short(weights.r));
+    const __m128i wg = _mm_set1_epi16(short(weights.g));
+    const __m128i wb = _mm_set1_epi16(short(weights.b));
+    for (; i + 8 <= count; i += 8) {
+        __m128i px0, px1;
+        if (step == 1) {
+            px0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            px1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 4));
+        } else {
+            const QRgb *p = src + i * step;
+            px0 = _mm_set_epi32(int(p[3 * step]), int(p[2 * step]), int(p[step]), int(p[0]));
+            p += 4 * step;
+            px1 = _mm_set_epi32(int(p[3 * step]), int(p[2 * step]), int(p[step]), int(p[0]));
+        }
+        // Channels are on [0,255], packing them to 16 bit never saturates
+        const __m128i r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(px0, 16), mask), _mm_and_si128(_mm_srli_epi32(px1, 16), mask));
+        const __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(px0, 8), mask), _mm_and_si128(_mm_srli_epi32(px1, 8), mask));
+        const __m128i b = _mm_packs_epi32(_mm_and_si128(px0, mask), _mm_and_si128(px1, mask));
+        __m128i lo = _mm_setzero_si128();
+        __m128i hi = _mm_setzero_si128();
+        lumaMultiplyAdd(r, wr, lo, hi);
+        lumaMultiplyAdd(g, wg, lo, hi);
+        lumaMultiplyAdd(b, wb, lo, hi);
+        const __m128i luma = _mm_packs_epi32(_mm_srli_epi32(lo, 16), _mm_srli_epi32(hi, 16));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(luma, luma));
+    }
+#endif
+    for (; i < count; ++i) {
+        const QRgb px = src[i * step];
+        dst[i] = uchar((weights.r * ((px >> 16) & 0xff) + weights.g * ((px >> 8) & 0xff) + weights.b * (px & 0xff)) >> 16);
+    }
+}
+
+} // namespace ScopeTiles
+
+#endif // KDENLIVE_SCOPETILES_H
@@ -64,6 +64,7 @@ mRgb2YPbPr =                        r =
  */
 
 #include "vectorscopegenerator.h"
+#include "scopeframe.h"
 #include <QImage>
 #include <cmath>
 
@@ -108,11 +109,11 @@ QPoint VectorscopeGenerator::mapToCircle(const QSize &targetSize, const QPointF
     return {int((targetSize.width() - 1) * (point.x() + 1) / 2), int((targetSize.height() - 1) * (1 - (point.y() + 1) / 2))};
 }
 
-QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize, const QImage &image, const float &gain,
+QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize, const ScopeFrame &frame, const float &gain,
                                                   const VectorscopeGenerator::PaintMode &paintMode, const VectorscopeGenerator::ColorSpace &colorSpace, bool,
                                                   uint accelFactor) const
 {
-    if (vectorscopeSize.width() <= 0 || vectorscopeSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (vectorscopeSize.width() <= 0 || vectorscopeSize.height() <= 0 || frame.isNull()) {
         // Invalid size
         return QImage();
     }
@@ -122,26 +123,146 @@ QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize,
     QImage scope = QImage(cw, cw, QImage::Format_ARGB32);
     scope.fill(qRgba(0, 0, 0, 0));
 
-    const uchar *bits = image.bits();
+    // Average number of analysed pixels per scope pixel, at the scale of the former computation from the bytes of an RGB32 image
+    double avgPxPerPx = 0;
 
-    double dy, dr, dg, db, dmax;
-    double /*y,*/ u, v;
-    QPoint pt;
-    QRgb px;
+    // Plot a pixel of chroma u, v; original is its color, only needed for PaintMode_Original
+    auto plot = [&](double u, double v, QRgb original) {
+        double dy, dr, dg, db, dmax;
+        QRgb px;
+        const QPoint pt = mapToCircle(vectorscopeSize, QPointF(SCALING * gain * u, SCALING * gain * v));
 
-    const int stepsize = int(uint(image.depth() / 8) * accelFactor);
+        if (pt.x() >= scope.width() || pt.x() < 0 || pt.y() >= scope.height() || pt.y() < 0) {
+            // Point lies outside (because of scaling), don't plot it
+            return;
+        }
+
+        // Draw the pixel using the chosen draw mode.
+        switch (paintMode) {
+        case PaintMode_YUV:
+            // see yuvColorWheel
+            dy = 128; // Default Y value. Lower = darker.
+
+            // Calculate the RGB values from YUV/YPbPr
+            switch (colorSpace) {
+            case VectorscopeGenerator::ColorSpace_YUV:
+                dr = dy + 290.8 * v;
+                dg = dy - 100.6 * u - 148 * v;
+                db = dy + 517.2 * u;
+                break;
+            case VectorscopeGenerator::ColorSpace_YPbPr:
+            default:
+                dr = dy + 357.5 * v;
+                dg = dy - 87.75 * u - 182 * v;
+                db = dy + 451.9 * u;
+                break;
+            }
+
+            if (dr < 0) {
+                dr = 0;
+            }
+            if (dg < 0) {
+                dg = 0;
+            }
+            if (db < 0) {
+                db = 0;
+            }
+            if (dr > 255) {
+                dr = 255;
+            }
+            if (dg > 255) {
+                dg = 255;
+            }
+            if (db > 255) {
+                db = 255;
+            }
+
+            scope.setPixel(pt, qRgba(dr, dg, db, 255));
+            break;
+
+        case PaintMode_Chroma:
+            dy = 200; // Default Y value. Lower = darker.
+
+            // Calculate the RGB values from YUV/YPbPr
+            switch (colorSpace) {
+            case VectorscopeGenerator::ColorSpace_YUV:
+                dr = dy + 290.8 * v;
+                dg = dy - 100.6 * u - 148 * v;
+                db = dy + 517.2 * u;
+                break;
+            case VectorscopeGenerator::ColorSpace_YPbPr:
+            default:
+                dr = dy + 357.5 * v;
+                dg = dy - 87.75 * u - 182 * v;
+                db = dy + 451.9 * u;
+                break;
+            }
+
+            // Scale the RGB values back to max 255
+            dmax = dr;
+            if (dg > dmax) {
+                dmax = dg;
+            }
+            if (db > dmax) {
+                dmax = db;
+            }
+            dmax = 255 / dmax;
 
-    // Just an average for the number of image pixels per scope pixel.
-    // NOTE: byteCount() has to be replaced by (img.bytesPerLine()*img.height()) for Qt 4.5 to compile, see:
-    // https://doc.qt.io/qt-5/qimage.html#bytesPerLine
-    double avgPxPerPx = (double)image.depth() / 8 * (image.bytesPerLine() * image.height()) / scope.size().width() / scope.size().height() / accelFactor;
+            dr *= dmax;
+            dg *= dmax;
+            db *= dmax;
 
-    for (int i = 0; i < (image.bytesPerLine() * image.height()); i += stepsize) {
-        auto *col = (const QRgb *)(bits);
+            scope.setPixel(pt, qRgba(dr, dg, db, 255));
+            break;
+        case PaintMode_Original:
+            scope.setPixel(pt, original);
+            break;
+        case PaintMode_Green:
+            px = scope.pixel(pt);
+            scope.setPixel(pt, qRgba(qRed(px) + (255 - qRed(px)) / (3 * avgPxPerPx), qGreen(px) + 20 * (255 - qGreen(px)) / (avgPxPerPx),
+                                     qBlue(px) + (255 - qBlue(px)) / (avgPxPerPx), qAlpha(px) + (255 - qAlpha(px)) / (avgPxPerPx)));
+            break;
+        case PaintMode_Green2:
+            px = scope.pixel(pt);
+            scope.setPixel(pt,
+                           qRgba(qRed(px) + ceil((255 - (float)qRed(px)) / (4 * avgPxPerPx)), 255,
+                                 qBlue(px) + ceil((255 - (float)qBlue(px)) / (avgPxPerPx)), qAlpha(px) + ceil((255 - (float)qAlpha(px)) / (avgPxPerPx))));
+            break;
+        case PaintMode_Black:
+            px = scope.pixel(pt);
+            scope.setPixel(pt, qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20));
+            break;
+        }
+    };
+
+    if (frame.isYuv()) {
+        // The chroma planes are read directly, each sample covering 2x2 pixels.
+        // Cb and Cr are Pb and Pr on the limited range, U and V are scaled from them.
+        const bool yuv = colorSpace == VectorscopeGenerator::ColorSpace_YUV;
+        const double uScale = (yuv ? 0.872 : 1.) / 224;
+        const double vScale = (yuv ? 1.23 : 1.) / 224;
+        const int chromaWidth = frame.chromaWidth();
+        const int count = chromaWidth * frame.chromaHeight();
+        const uchar *cb = frame.cbLine(0);
+        const uchar *cr = frame.crLine(0);
+        avgPxPerPx = 16. * count / scope.width() / scope.height() / accelFactor;
+        for (int i = 0; i < count; i += (int)accelFactor) {
+            const QRgb original = paintMode == PaintMode_Original ? frame.toRgb(frame.yLine(2 * (i / chromaWidth))[2 * (i % chromaWidth)], cb[i], cr[i]) : 0;
+            plot(uScale * (cb[i] - 128), vScale * (cr[i] - 128), original);
+        }
+        return scope;
+    }
+
+    const int iw = frame.width();
+    const int count = iw * frame.height();
+    avgPxPerPx = 16. * count / scope.width() / scope.height() / accelFactor;
+    double u, v;
+    for (int i = 0; i < count; i += (int)accelFactor) {
+        const QRgb col = frame.rgbLine(i / iw)[i % iw];
 
-        int r = qRed(*col);
-        int g = qGreen(*col);
-        int b = qBlue(*col);
+        int r = qRed(col);
+        int g = qGreen(col);
+        int b = qBlue(col);
 
         switch (colorSpace) {
         case VectorscopeGenerator::ColorSpace_YUV:
@@ -156,113 +277,7 @@ QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize,
             v = (double)0.001961 * r - 0.001642 * g - 0.0003189 * b;
             break;
         }
-
-        pt = mapToCircle(vectorscopeSize, QPointF(SCALING * gain * u, SCALING * gain * v));
-
-        if (pt.x() >= scope.width() || pt.x() < 0 || pt.y() >= scope.height() || pt.y() < 0) {
-            // Point lies outside (because of scaling), don't plot it
-
-        } else {
-
-            // Draw the pixel using the chosen draw mode.
-            switch (paintMode) {
-            case PaintMode_YUV:
-                // see yuvColorWheel
-                dy = 128; // Default Y value. Lower = darker.
-
-                // Calculate the RGB values from YUV/YPbPr
-                switch (colorSpace) {
-                case VectorscopeGenerator::ColorSpace_YUV:
-                    dr = dy + 290.8 * v;
-                    dg = dy - 100.6 * u - 148 * v;
-                    db = dy + 517.2 * u;
-                    break;
-                case VectorscopeGenerator::ColorSpace_YPbPr:
-                default:
-                    dr = dy + 357.5 * v;
-                    dg = dy - 87.75 * u - 182 * v;
-                    db = dy + 451.9 * u;
-                    break;
-                }
-
-                if (dr < 0) {
-                    dr = 0;
-                }
-                if (dg < 0) {
-                    dg = 0;
-                }
-                if (db < 0) {
-                    db = 0;
-                }
-                if (dr > 255) {
-                    dr = 255;
-                }
-                if (dg > 255) {
-                    dg = 255;
-                }
-                if (db > 255) {
-                    db = 255;
-                }
-
-                scope.setPixel(pt, qRgba(dr, dg, db, 255));
-                break;
-
-            case PaintMode_Chroma:
-                dy = 200; // Default Y value. Lower = darker.
-
-                // Calculate the RGB values from YUV/YPbPr
-                switch (colorSpace) {
-                case VectorscopeGenerator::ColorSpace_YUV:
-                    dr = dy + 290.8 * v;
-                    dg = dy - 100.6 * u - 148 * v;
-                    db = dy + 517.2 * u;
-                    break;
-                case VectorscopeGenerator::ColorSpace_YPbPr:
-                default:
-                    dr = dy + 357.5 * v;
-                    dg = dy - 87.75 * u - 182 * v;
-                    db = dy + 451.9 * u;
-                    break;
-                }
-
-                // Scale the RGB values back to max 255
-                dmax = dr;
-                if (dg > dmax) {
-                    dmax = dg;
-                }
-                if (db > dmax) {
-                    dmax = db;
-                }
-                dmax = 255 / dmax;
-
-                dr *= dmax;
-                dg *= dmax;
-                db *= dmax;
-
-                scope.setPixel(pt, qRgba(dr, dg, db, 255));
-                break;
-            case PaintMode_Original:
-                scope.setPixel(pt, *col);
-                break;
-            case PaintMode_Green:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(qRed(px) + (255 - qRed(px)) / (3 * avgPxPerPx), qGreen(px) + 20 * (255 - qGreen(px)) / (avgPxPerPx),
-                                         qBlue(px) + (255 - qBlue(px)) / (avgPxPerPx), qAlpha(px) + (255 - qAlpha(px)) / (avgPxPerPx)));
-                break;
-            case PaintMode_Green2:
-                px = scope.pixel(pt);
-                scope.setPixel(pt,
-                               qRgba(qRed(px) + ceil((255 - (float)qRed(px)) / (4 * avgPxPerPx)), 255,
-                                     qBlue(px) + ceil((255 - (float)qBlue(px)) / (avgPxPerPx)), qAlpha(px) + ceil((255 - (float)qAlpha(px)) / (avgPxPerPx))));
-                break;
-            case PaintMode_Black:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20));
-                break;
-            }
-        }
-
-        bits += stepsize;
+        plot(u, v, col);
     }
     return scope;
 }
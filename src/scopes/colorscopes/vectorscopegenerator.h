@@ -18,6 +18,7 @@ class QImage;
 class QPoint;
 class QPointF;
 class QSize;
+class ScopeFrame;
 
 class VectorscopeGenerator : public QObject
 {
@@ -27,7 +28,7 @@ public:
     enum ColorSpace { ColorSpace_YUV, ColorSpace_YPbPr };
     enum PaintMode { PaintMode_Green, PaintMode_Green2, PaintMode_Original, PaintMode_Chroma, PaintMode_YUV, PaintMode_Black };
 
-    QImage calculateVectorscope(const QSize &vectorscopeSize, const QImage &image, const float &gain, const VectorscopeGenerator::PaintMode &paintMode,
+    QImage calculateVectorscope(const QSize &vectorscopeSize, const ScopeFrame &frame, const float &gain, const VectorscopeGenerator::PaintMode &paintMode,
                                 const VectorscopeGenerator::ColorSpace &colorSpace, bool, uint accelFactor = 1) const;
 
     QPoint mapToCircle(const QSize &targetSize, const QPointF &point) const;
@@ -10,14 +10,16 @@
 
 #include "waveformgenerator.h"
 #include "colorconstants.h"
+#include "scopeframe.h"
+#include "scopetiles.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include <QImage>
 #include <QPainter>
 #include <QSize>
 #include <QElapsedTimer>
-#include <vector>
 
 #define CHOP255(a) ((255) < (a) ? (255) : (a))
 
@@ -25,7 +27,7 @@ WaveformGenerator::WaveformGenerator() = default;
 
 WaveformGenerator::~WaveformGenerator() = default;
 
-QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QImage &image, WaveformGenerator::PaintMode paintMode, bool drawAxis,
+QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const ScopeFrame &frame, WaveformGenerator::PaintMode paintMode, bool drawAxis,
                                             ITURec rec, uint accelFactor)
 {
     Q_ASSERT(accelFactor >= 1);
@@ -35,7 +37,7 @@ QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QIm
 
     QImage wave(waveformSize, QImage::Format_ARGB32);
 
-    if (waveformSize.width() <= 0 || waveformSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (waveformSize.width() <= 0 || waveformSize.height() <= 0 || frame.isNull()) {
         return QImage();
     }
 
@@ -44,84 +46,84 @@ QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QIm
 
     const uint ww = (uint)waveformSize.width();
     const uint wh = (uint)waveformSize.height();
-    const uint iw = (uint)image.bytesPerLine();
-    const uint ih = (uint)image.height();
-    const uint byteCount = iw * ih;
-
-    std::vector<std::vector<uint>> waveValues((size_t)waveformSize.width(), std::vector<uint>((size_t)waveformSize.height(), 0));
+    const int iw = frame.width();
+    const int ih = frame.height();
 
     // Number of input pixels that will fall on one scope pixel.
     // Must be a float because the acceleration factor can be high, leading to <1 expected px per px.
-    const float pixelDepth = (float)((byteCount >> 2) / accelFactor) / float(ww * wh);
+    const float pixelDepth = (float)(uint(iw * ih) / accelFactor) / float(ww * wh);
     const float gain = 255. / (8. * pixelDepth);
     // qCDebug(KDENLIVE_LOG) << "Pixel depth: expected " << pixelDepth << "; Gain: using " << gain << " (acceleration: " << accelFactor << "x)";
 
     // Subtract 1 from sizes because we start counting from 0.
     // Not doing it would result in attempts to paint outside of the image.
     const float hPrediv = (float)(wh - 1) / 255.;
-    const float wPrediv = (float)(ww - 1) / float(iw - 1);
-
-    const uchar *bits = image.bits();
-    const int bpp = image.depth() / 8;
-
-    for (uint i = 0, x = 0; i < byteCount; i += (uint)bpp) {
+    const float wPrediv = (float)(ww - 1) / float(qMax(1, iw - 1));
 
-        Q_ASSERT(bits < image.bits() + byteCount);
-
-        double dY, dx, dy;
-        auto *col = (const QRgb *)bits;
-
-        if (rec == ITURec::Rec_601) {
-            // CIE 601 Luminance
-            dY = REC_601_R * float(qRed(*col)) + REC_601_G * float(qGreen(*col)) + REC_601_B * float(qBlue(*col));
-        } else {
-            // CIE 709 Luminance
-            dY = REC_709_R * float(qRed(*col)) + REC_709_G * float(qGreen(*col)) + REC_709_B * float(qBlue(*col));
-        }
-        // dY is on [0,255] now.
-
-        dy = dY * hPrediv;
-        dx = (float)x * wPrediv;
-        waveValues[(size_t)dx][(size_t)dy]++;
-
-        bits += bpp;
-        x += (uint)bpp;
-        if (x > iw) {
-            x -= iw;
-            if (accelFactor > 1) {
-                bits += bpp * (int)iw * ((int)accelFactor - 1);
-                i += (uint)bpp * iw * (accelFactor - 1);
-            }
-        }
+    // Scope column of each image column, and scope row of each luma value
+    QVector<int> columns(iw);
+    for (int x = 0; x < iw; ++x) {
+        columns[x] = int(float(x) * wPrediv);
+    }
+    int lumaRows[256];
+    for (int l = 0; l < 256; ++l) {
+        lumaRows[l] = int(float(l) * hPrediv) * (int)ww;
     }
 
-    switch (paintMode) {
-    case PaintMode_Green:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                // Logarithmic scale. Needs fine tuning by hand, but looks great.
-                wave.setPixel(i, waveformSize.height() - j - 1,
-                              qRgba(CHOP255(52 * log(0.1 * gain * (float)waveValues[(size_t)i][(size_t)j])),
-                                    CHOP255(52 * std::log(gain * (float)waveValues[(size_t)i][(size_t)j])),
-                                    CHOP255(52 * log(.25 * gain * (float)waveValues[(size_t)i][(size_t)j])),
-                                    CHOP255(64 * std::log(gain * (float)waveValues[(size_t)i][(size_t)j]))));
+    // The waveform is accumulated row by row (bottom row first), one buffer per tile
+    const int cells = int(ww * wh);
+    const int rows = (ih + (int)accelFactor - 1) / (int)accelFactor;
+    const int tiles = ScopeTiles::tileCount(rows);
+    QVector<uint> waveValues(cells * tiles, 0);
+    uint *valueData = waveValues.data();
+    const int *columnData = columns.constData();
+
+    ScopeTiles::forEachTile(rows, tiles, [&](int tile, int first, int end) {
+        uint *values = valueData + size_t(tile) * size_t(cells);
+        QVector<uchar> luma(iw);
+        uchar *lumaData = luma.data();
+        for (int row = first; row < end; ++row) {
+            // Read from the Y plane when the frame uses the rec matrix
+            frame.lumaRow(row * (int)accelFactor, iw, 1, rec, lumaData);
+            for (int x = 0; x < iw; ++x) {
+                values[lumaRows[lumaData[x]] + columnData[x]]++;
             }
         }
-        break;
-    case PaintMode_Yellow:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                wave.setPixel(i, waveformSize.height() - j - 1, qRgba(255, 242, 0, CHOP255(gain * (float)waveValues[(size_t)i][(size_t)j])));
+    });
+    ScopeTiles::mergeTiles(waveValues, cells, tiles);
+
+    auto colorFor = [paintMode, gain](uint value) -> QRgb {
+        switch (paintMode) {
+        case PaintMode_Green: {
+            if (value == 0) {
+                return qRgba(0, 0, 0, 0);
             }
+            // Logarithmic scale. Needs fine tuning by hand, but looks great.
+            const float v = gain * (float)value;
+            return qRgba(qBound(0, int(52 * std::log(0.1 * v)), 255), qBound(0, int(52 * std::log(v)), 255), qBound(0, int(52 * std::log(.25 * v)), 255),
+                         qBound(0, int(64 * std::log(v)), 255));
         }
-        break;
-    default:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                wave.setPixel(i, waveformSize.height() - j - 1, qRgba(255, 255, 255, CHOP255(2. * gain * (float)waveValues[(size_t)i][(size_t)j])));
-            }
+        case PaintMode_Yellow:
+            return qRgba(255, 242, 0, CHOP255(int(gain * (float)value)));
+        default:
+            return qRgba(255, 255, 255, CHOP255(int(2. * gain * (float)value)));
+        }
+    };
+
+    // Most cells hold small counts, so colors are looked up in a table
+    const uint *values = waveValues.constData();
+    const uint maxValue = cells > 0 ? *std::max_element(values, values + cells) : 0;
+    QVector<QRgb> palette(int(qMin(maxValue, 65535u)) + 1);
+    for (int v = 0; v < palette.size(); ++v) {
+        palette[v] = colorFor(uint(v));
+    }
+    const uint paletteMax = uint(palette.size() - 1);
+    for (int j = 0; j < (int)wh; ++j) {
+        auto *line = reinterpret_cast<QRgb *>(wave.scanLine((int)wh - j - 1));
+        const uint *counts = values + size_t(j) * ww;
+        for (int i = 0; i < (int)ww; ++i) {
+            line[i] = counts[i] <= paletteMax ? palette.at(int(counts[i])) : colorFor(counts[i]);
         }
-        break;
     }
 
     if (drawAxis) {
@@ -99,6 +99,11 @@ private:
      */
     template <class T> void createScopeDock(T *scopeWidget, const QString &title, const QString &name);
 
+    /**
+      Sends @param frame to the visible colour scopes.
+      */
+    void distributeFrame(const ScopeFrame &frame);
+
 public slots:
     void slotCheckActiveScopes();
 
@@ -128,6 +133,7 @@ private slots:
     void checkActiveColourScopes();
 
     void slotDistributeFrame(const QImage &image);
+    void slotDistributeSharedFrame(const SharedFrame &frame, int colorspace);
     void slotDistributeAudio(const audioShortVector &sampleData, int freq, int num_channels, int num_samples);
     /**
       Allows a scope to explicitly request a new frame, even if the scope's autoRefresh is disabled.
@@ -28,10 +28,10 @@
 #include <mlt++/MltTransition.h>
 #include <utility>
 
-CompositionModel::CompositionModel(std::weak_ptr<TimelineModel> parent, std::unique_ptr<Mlt::Transition> transition, int id, const QDomElement &transitionXml,
-                                   const QString &transitionId)
+CompositionModel::CompositionModel(std::weak_ptr<TimelineModel> parent, std::unique_ptr<Mlt::Transition> transition, int id,
+                                   std::shared_ptr<const AssetDescriptor> descriptor, const QHash<QString, QString> &values, const QString &transitionId)
     : MoveableItem<Mlt::Transition>(std::move(parent), id)
-    , AssetParameterModel(std::move(transition), transitionXml, transitionId, {ObjectType::TimelineComposition, m_id})
+    , AssetParameterModel(std::move(transition), std::move(descriptor), transitionId, {ObjectType::TimelineComposition, m_id}, values)
     , m_a_track(-1)
     , m_duration(0)
 {
@@ -43,28 +43,25 @@ int CompositionModel::construct(const std::weak_ptr<TimelineModel> &parent, cons
 {
     std::unique_ptr<Mlt::Transition> transition = TransitionsRepository::get()->getTransition(transitionId);
     transition->set_in_and_out(0, 0);
-    auto xml = TransitionsRepository::get()->getXml(transitionId);
+    auto descriptor = TransitionsRepository::get()->getDescriptor(transitionId);
+    QHash<QString, QString> values;
     if (sourceProperties) {
         // Paste parameters from existing source composition
         QStringList sourceProps;
         for (int i = 0; i < sourceProperties->count(); i++) {
             sourceProps << sourceProperties->get_name(i);
         }
-        QDomNodeList params = xml.elementsByTagName(QStringLiteral("parameter"));
-        for (int i = 0; i < params.count(); ++i) {
-            QDomElement currentParameter = params.item(i).toElement();
-            QString paramName = currentParameter.attribute(QStringLiteral("name"));
-            if (!sourceProps.contains(paramName)) {
+        for (const AssetDescriptor::Parameter &param : descriptor->parameters()) {
+            if (!sourceProps.contains(param.name)) {
                 continue;
             }
-            QString paramValue = sourceProperties->get(paramName.toUtf8().constData());
-            currentParameter.setAttribute(QStringLiteral("value"), paramValue);
+            values.insert(param.name, sourceProperties->get(param.name.toUtf8().constData()));
         }
         if (sourceProps.contains(QStringLiteral("force_track"))) {
             transition->set("force_track", sourceProperties->get_int("force_track"));
         }
     }
-    std::shared_ptr<CompositionModel> composition(new CompositionModel(parent, std::move(transition), id, xml, transitionId));
+    std::shared_ptr<CompositionModel> composition(new CompositionModel(parent, std::move(transition), id, descriptor, values, transitionId));
     id = composition->m_id;
 
     if (auto ptr = parent.lock()) {
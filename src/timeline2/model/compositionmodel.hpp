@@ -44,8 +44,8 @@ class CompositionModel : public MoveableItem<Mlt::Transition>, public AssetParam
 
 protected:
     /* This constructor is not meant to be called, call the static construct instead */
-    CompositionModel(std::weak_ptr<TimelineModel> parent, std::unique_ptr<Mlt::Transition> transition, int id, const QDomElement &transitionXml,
-                     const QString &transitionId);
+    CompositionModel(std::weak_ptr<TimelineModel> parent, std::unique_ptr<Mlt::Transition> transition, int id,
+                     std::shared_ptr<const AssetDescriptor> descriptor, const QHash<QString, QString> &values, const QString &transitionId);
 
 public:
     /* @brief Creates a composition, which then registers itself to the parent timeline
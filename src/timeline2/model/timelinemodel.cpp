@@ -698,6 +698,10 @@ bool TimelineModel::requestClipMoveAttempt(int clipId, int trackId, int position
     if (m_allClips[clipId]->getPosition() == position && getClipTrackId(clipId) == trackId) {
         return true;
     }
+    MoveFeasibility feasibility = checkClipMove(clipId, trackId, position);
+    if (feasibility != MoveFeasibility::Unchecked) {
+        return feasibility == MoveFeasibility::Possible;
+    }
     std::function<bool(void)> undo = []() { return true; };
     std::function<bool(void)> redo = []() { return true; };
     bool res = true;
@@ -719,6 +723,52 @@ bool TimelineModel::requestClipMoveAttempt(int clipId, int trackId, int position
     return res;
 }
 
+TimelineModel::MoveFeasibility TimelineModel::checkClipMove(int clipId, int trackId, int position)
+{
+    READ_LOCK();
+    Q_ASSERT(isClip(clipId));
+    if (!isTrack(trackId)) {
+        return MoveFeasibility::Impossible;
+    }
+    int sourceTrackId = getClipTrackId(clipId);
+    if (m_groups->isInGroup(clipId)) {
+        if (sourceTrackId == -1 || trackId != sourceTrackId) {
+            return MoveFeasibility::Unchecked;
+        }
+        std::unordered_set<int> leaves = m_groups->getLeaves(m_groups->getRootId(clipId));
+        int delta_pos = position - m_allClips[clipId]->getPosition();
+        for (int item : leaves) {
+            if (!isClip(item)) {
+                return MoveFeasibility::Unchecked;
+            }
+            int itemTrackId = getClipTrackId(item);
+            if (itemTrackId == -1) {
+                return MoveFeasibility::Unchecked;
+            }
+            auto track = getTrackById_const(itemTrackId);
+            int target = m_allClips[item]->getPosition() + delta_pos;
+            if (track->isLocked() || target < 0 || !track->isAvailableExcept(target, m_allClips[item]->getPlaytime(), leaves)) {
+                return MoveFeasibility::Unchecked;
+            }
+        }
+        return MoveFeasibility::Possible;
+    }
+    auto track = getTrackById_const(trackId);
+    // Same checks as requestClipMove, on the track type and the target space
+    if (m_allClips[clipId]->clipState() == PlaylistState::Disabled) {
+        if ((track->trackType() == PlaylistState::AudioOnly && !m_allClips[clipId]->canBeAudio()) ||
+            (track->trackType() == PlaylistState::VideoOnly && !m_allClips[clipId]->canBeVideo())) {
+            return MoveFeasibility::Impossible;
+        }
+    } else if (track->trackType() != m_allClips[clipId]->clipState()) {
+        return MoveFeasibility::Impossible;
+    }
+    if (position < 0 || track->isLocked() || (sourceTrackId != -1 && getTrackById_const(sourceTrackId)->isLocked())) {
+        return MoveFeasibility::Impossible;
+    }
+    return track->isAvailableExcept(position, m_allClips[clipId]->getPlaytime(), {clipId}) ? MoveFeasibility::Possible : MoveFeasibility::Impossible;
+}
+
 QVariantList TimelineModel::suggestItemMove(int itemId, int trackId, int position, int cursorPosition, int snapDistance)
 {
     if (isClip(itemId)) {
@@ -771,9 +821,12 @@ QVariantList TimelineModel::suggestClipMove(int clipId, int trackId, int positio
             position = snapped;
         }
     }
+    // Moves that are sure to fail are ruled out on the position index, without modifying and rolling back the playlists
+    auto attemptMove = [&](int tid, int pos) {
+        return checkClipMove(clipId, tid, pos) != MoveFeasibility::Impossible && requestClipMove(clipId, tid, pos, moveMirrorTracks, true, false, false);
+    };
     // we check if move is possible
-    bool possible = (m_editMode == TimelineMode::NormalEdit) ? requestClipMove(clipId, trackId, position, moveMirrorTracks, true, false, false)
-                                                           : requestFakeClipMove(clipId, trackId, position, true, false, false);
+    bool possible = (m_editMode == TimelineMode::NormalEdit) ? attemptMove(trackId, position) : requestFakeClipMove(clipId, trackId, position, true, false, false);
     if (possible) {
         TRACE_RES(position);
         if (m_editMode != TimelineMode::NormalEdit) {
@@ -791,7 +844,7 @@ QVariantList TimelineModel::suggestClipMove(int clipId, int trackId, int positio
         // Try same track move
         if (trackId != sourceTrackId && sourceTrackId != -1) {
             trackId = sourceTrackId;
-            possible = requestClipMove(clipId, trackId, position, moveMirrorTracks, true, false, false);
+            possible = attemptMove(trackId, position);
             if (!possible) {
                 qDebug() << "CANNOT MOVE CLIP : " << clipId << " ON TK: " << trackId << ", AT POS: " << position;
             } else {
@@ -812,7 +865,7 @@ QVariantList TimelineModel::suggestClipMove(int clipId, int trackId, int positio
             TRACE_RES(currentPos);
             return {currentPos, sourceTrackId};
         }
-        possible = requestClipMove(clipId, trackId, position, moveMirrorTracks, true, false, false);
+        possible = attemptMove(trackId, position);
         TRACE_RES(possible ? position : currentPos);
         if (possible) {
             return {position, trackId};
@@ -821,7 +874,7 @@ QVariantList TimelineModel::suggestClipMove(int clipId, int trackId, int positio
     }
     if (trackId != sourceTrackId) {
         // Try same track move
-        possible = requestClipMove(clipId, sourceTrackId, position, moveMirrorTracks, true, false, false);
+        possible = attemptMove(sourceTrackId, position);
         if (possible) {
             return {position, sourceTrackId};
         }
@@ -886,7 +939,7 @@ QVariantList TimelineModel::suggestClipMove(int clipId, int trackId, int positio
     }
     if (blank_length != 0) {
         int updatedPos = currentPos + (after ? blank_length : -blank_length);
-        possible = requestClipMove(clipId, trackId, updatedPos, moveMirrorTracks, true, false, false);
+        possible = attemptMove(trackId, updatedPos);
         if (possible) {
             TRACE_RES(updatedPos);
             return {updatedPos, trackId};
@@ -1553,6 +1606,62 @@ bool TimelineModel::requestGroupMove(int itemId, int groupId, int delta_track, i
                                      bool allowViewRefresh, QVector<int> allowedTracks)
 {
     QWriteLocker locker(&m_lock);
+    // Batch the edits of all the tracks that can be touched: the tracks of the items, and all tracks if they move to other tracks
+    std::unordered_set<int> batchTracks;
+    if (delta_track != 0) {
+        for (const auto &track : m_allTracks) {
+            batchTracks.insert(track->getId());
+        }
+    } else if (m_allGroups.count(groupId) > 0) {
+        for (int item : m_groups->getLeaves(groupId)) {
+            batchTracks.insert(getItemTrackId(item));
+        }
+    }
+    Fun local_undo = []() { return true; };
+    Fun local_redo = []() { return true; };
+    beginTrackBatch(batchTracks);
+    bool res = moveGroupItems(itemId, groupId, delta_track, delta_pos, updateView, finalMove, local_undo, local_redo, moveMirrorTracks, allowViewRefresh,
+                              allowedTracks);
+    endTrackBatch(batchTracks);
+    if (res) {
+        Fun batched_undo = batchedTrackEdits(batchTracks, local_undo);
+        Fun batched_redo = batchedTrackEdits(batchTracks, local_redo);
+        UPDATE_UNDO_REDO(batched_redo, batched_undo, undo, redo);
+    }
+    return res;
+}
+
+void TimelineModel::beginTrackBatch(const std::unordered_set<int> &trackIds)
+{
+    for (int trackId : trackIds) {
+        if (isTrack(trackId)) {
+            getTrackById(trackId)->beginPlaylistBatch();
+        }
+    }
+}
+
+void TimelineModel::endTrackBatch(const std::unordered_set<int> &trackIds)
+{
+    for (int trackId : trackIds) {
+        if (isTrack(trackId)) {
+            getTrackById(trackId)->endPlaylistBatch();
+        }
+    }
+}
+
+Fun TimelineModel::batchedTrackEdits(const std::unordered_set<int> &trackIds, const Fun &operation)
+{
+    return [this, trackIds, operation]() {
+        beginTrackBatch(trackIds);
+        bool res = operation();
+        endTrackBatch(trackIds);
+        return res;
+    };
+}
+
+bool TimelineModel::moveGroupItems(int itemId, int groupId, int delta_track, int delta_pos, bool updateView, bool finalMove, Fun &undo, Fun &redo,
+                                   bool moveMirrorTracks, bool allowViewRefresh, const QVector<int> &allowedTracks)
+{
     Q_ASSERT(m_allGroups.count(groupId) > 0);
     Q_ASSERT(isItem(itemId));
     if (getGroupElements(groupId).count(itemId) == 0) {
@@ -1670,15 +1779,33 @@ bool TimelineModel::requestGroupMove(int itemId, int groupId, int delta_track, i
         allowViewRefresh = false;
         updatePositionOnly = true;
         update_model = [sorted_clips, sorted_compositions, finalMove, this]() {
-            QModelIndex modelIndex;
-            QVector<int> roles{StartRole};
+            // Notify one range of rows per track instead of each item
+            std::unordered_map<int, std::pair<int, int>> rowRanges;
+            auto addRow = [&rowRanges](int trackId, int row) {
+                auto it = rowRanges.find(trackId);
+                if (it == rowRanges.end()) {
+                    rowRanges[trackId] = {row, row};
+                } else {
+                    it->second.first = qMin(it->second.first, row);
+                    it->second.second = qMax(it->second.second, row);
+                }
+            };
             for (const std::pair<int, int> &item : sorted_clips) {
-                modelIndex = makeClipIndexFromID(item.first);
-                notifyChange(modelIndex, modelIndex, roles);
+                int trackId = getClipTrackId(item.first);
+                if (trackId != -1) {
+                    addRow(trackId, getTrackById_const(trackId)->getRowfromClip(item.first));
+                }
             }
             for (const std::pair<int, std::pair<int, int>> &item : sorted_compositions) {
-                modelIndex = makeCompositionIndexFromID(item.first);
-                notifyChange(modelIndex, modelIndex, roles);
+                int trackId = getCompositionTrackId(item.first);
+                if (trackId != -1) {
+                    addRow(trackId, getTrackById_const(trackId)->getRowfromComposition(item.first));
+                }
+            }
+            QVector<int> roles{StartRole};
+            for (const auto &range : rowRanges) {
+                QModelIndex trackIndex = makeTrackIndexFromID(range.first);
+                notifyChange(index(range.second.first, 0, trackIndex), index(range.second.second, 0, trackIndex), roles);
             }
             if (finalMove) {
                 updateDuration();
@@ -1914,13 +2041,23 @@ bool TimelineModel::requestGroupDeletion(int clipId, Fun &undo, Fun &redo)
             }
         }
     }
+    std::unordered_set<int> batchTracks;
     for (int clip : all_items) {
-        bool res = requestClipDeletion(clip, undo, redo);
-        if (!res) {
+        batchTracks.insert(getClipTrackId(clip));
+    }
+    bool deleted = true;
+    beginTrackBatch(batchTracks);
+    for (int clip : all_items) {
+        deleted = requestClipDeletion(clip, undo, redo);
+        if (!deleted) {
             // Undo is processed in requestClipDeletion
-            return false;
+            break;
         }
     }
+    endTrackBatch(batchTracks);
+    if (!deleted) {
+        return false;
+    }
     for (int compo : all_compositions) {
         bool res = requestCompositionDeletion(compo, undo, redo);
         if (!res) {
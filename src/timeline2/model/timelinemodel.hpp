@@ -746,6 +746,17 @@ protected:
     bool requestClipDeletion(int clipId, Fun &undo, Fun &redo);
     bool requestCompositionDeletion(int compositionId, Fun &undo, Fun &redo);
 
+    /* @brief Batches the playlist edits of the given tracks, so that a multi-item operation refreshes the track tractors only once.
+       See TrackModel::beginPlaylistBatch. Tracks that do not exist anymore are ignored
+     */
+    void beginTrackBatch(const std::unordered_set<int> &trackIds);
+    void endTrackBatch(const std::unordered_set<int> &trackIds);
+    /* @brief Returns a lambda running @param operation as one batch of the given tracks, used to batch the undo / redo of an operation */
+    Fun batchedTrackEdits(const std::unordered_set<int> &trackIds, const Fun &operation);
+    /* @brief Does the work of requestGroupMove, which runs it as a track batch */
+    bool moveGroupItems(int itemId, int groupId, int delta_track, int delta_pos, bool updateView, bool finalMove, Fun &undo, Fun &redo, bool moveMirrorTracks,
+                        bool allowViewRefresh, const QVector<int> &allowedTracks);
+
     /** @brief Check tracks duration and update black track accordingly */
     void updateDuration();
     /** @brief Get a track tag (A1, V1, V2,...) through its id */
@@ -754,6 +765,13 @@ protected:
     /** @brief Attempt to make a clip move without ever updating the view */
     bool requestClipMoveAttempt(int clipId, int trackId, int position);
 
+    enum class MoveFeasibility { Possible, Impossible, Unchecked };
+    /** @brief Checks if a clip (with its group) can be moved, on the clip position index of the tracks, without modifying the timeline.
+        Single clips are fully checked. Groups are only reported as Possible when all their clips fit at the exact requested offset on
+        their own tracks, otherwise the move must be attempted since requestGroupMove can adjust the offset or change tracks.
+    */
+    MoveFeasibility checkClipMove(int clipId, int trackId, int position);
+
 public:
     /* @brief Debugging function that checks consistency with Mlt objects */
     bool checkConsistency();
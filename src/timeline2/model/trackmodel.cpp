@@ -148,6 +148,7 @@ Fun TrackModel::requestClipInsertion_lambda(int clipId, int position, bool updat
             clip->setSubPlaylistIndex(subPlaylist);
             int new_in = clip->getPosition();
             int new_out = new_in + clip->getPlaytime();
+            m_clipPos[subPlaylist][new_in] = clipId;
             ptr->m_snaps->addPoint(new_in);
             ptr->m_snaps->addPoint(new_out);
             if (updateView) {
@@ -323,6 +324,8 @@ Fun TrackModel::requestClipDeletion_lambda(int clipId, bool updateView, bool fin
         auto prod = m_playlists[target_track].replace_with_blank(target_clip);
         if (prod != nullptr) {
             m_playlists[target_track].consolidate_blanks();
+            Q_ASSERT(m_clipPos[target_track].count(m_allClips[clipId]->getPosition()) > 0);
+            m_clipPos[target_track].erase(m_allClips[clipId]->getPosition());
             m_allClips[clipId]->setCurrentTrackId(-1);
             m_allClips[clipId]->setSubPlaylistIndex(-1);
             m_allClips.erase(clipId);
@@ -565,7 +568,7 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
             // The second is parameter is delta - 1 because this function expects an out time, which is basically size - 1
             m_playlists[target_track].insert_blank(blank_index, delta - 1);
             if (!right) {
-                m_allClips[clipId]->setPosition(clip_position + delta);
+                updateClipPosition(clipId, clip_position + delta);
                 // Because we inserted blank before, the index of our clip has increased
                 target_clip_mutable++;
             }
@@ -648,7 +651,7 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
                     err = m_playlists[target_track].resize_clip(target_clip_mutable, in, out);
                 }
                 if (!right && err == 0) {
-                    m_allClips[clipId]->setPosition(m_playlists[target_track].clip_start(target_clip_mutable));
+                    updateClipPosition(clipId, m_playlists[target_track].clip_start(target_clip_mutable));
                 }
                 if (err == 0) {
                     update_snaps(m_allClips[clipId]->getPosition(), m_allClips[clipId]->getPosition() + out - in + 1);
@@ -671,17 +674,28 @@ int TrackModel::getId() const
 int TrackModel::getClipByPosition(int position)
 {
     READ_LOCK();
-    QSharedPointer<Mlt::Producer> prod(nullptr);
-    if (m_playlists[0].count() > 0) {
-        prod = QSharedPointer<Mlt::Producer>(m_playlists[0].get_clip_at(position));
-    }
-    if ((!prod || prod->is_blank()) && m_playlists[1].count() > 0) {
-        prod = QSharedPointer<Mlt::Producer>(m_playlists[1].get_clip_at(position));
-    }
-    if (!prod || prod->is_blank()) {
-        return -1;
+    for (const auto &positions : m_clipPos) {
+        // Clips don't overlap in a playlist, so only the last clip starting before position can contain it
+        auto it = positions.upper_bound(position);
+        if (it == positions.begin()) {
+            continue;
+        }
+        --it;
+        if (it->first + m_allClips.at(it->second)->getPlaytime() > position) {
+            return it->second;
+        }
     }
-    return prod->get_int("_kdenlive_cid");
+    return -1;
+}
+
+void TrackModel::updateClipPosition(int clipId, int position)
+{
+    auto clip = m_allClips.at(clipId);
+    int subPlaylist = clip->getSubPlaylistIndex();
+    Q_ASSERT(subPlaylist >= 0 && subPlaylist < 2);
+    m_clipPos[subPlaylist].erase(clip->getPosition());
+    clip->setPosition(position);
+    m_clipPos[subPlaylist][position] = clipId;
 }
 
 QSharedPointer<Mlt::Producer> TrackModel::getClipProducer(int clipId)
@@ -700,13 +714,14 @@ QSharedPointer<Mlt::Producer> TrackModel::getClipProducer(int clipId)
 int TrackModel::getCompositionByPosition(int position)
 {
     READ_LOCK();
-    for (const auto &comp : m_compoPos) {
-        if (comp.first == position) {
-            return comp.second;
-        } else if (comp.first < position) {
-            if (comp.first + m_allCompositions[comp.second]->getPlaytime() >= position) {
-                return comp.second;
-            }
+    // Compositions don't overlap, only the two compositions starting before position can match
+    auto it = m_compoPos.upper_bound(position);
+    for (int i = 0; i < 2 && it != m_compoPos.begin(); i++) {
+        --it;
+    }
+    for (; it != m_compoPos.end() && it->first <= position; ++it) {
+        if (it->first == position || it->first + m_allCompositions[it->second]->getPlaytime() >= position) {
+            return it->second;
         }
     }
     return -1;
@@ -727,14 +742,17 @@ std::unordered_set<int> TrackModel::getClipsInRange(int position, int end)
 {
     READ_LOCK();
     std::unordered_set<int> ids;
-    for (const auto &clp : m_allClips) {
-        int pos = clp.second->getPosition();
-        int length = clp.second->getPlaytime();
-        if (end > -1 && pos >= end) {
-            continue;
+    for (const auto &positions : m_clipPos) {
+        // Clips don't overlap in a playlist, so only the last clip starting before position can intersect the range
+        auto it = positions.upper_bound(position);
+        if (it != positions.begin()) {
+            auto previous = std::prev(it);
+            if (previous->first + m_allClips.at(previous->second)->getPlaytime() - 1 >= position) {
+                it = previous;
+            }
         }
-        if (pos >= position || pos + length - 1 >= position) {
-            ids.insert(clp.first);
+        for (; it != positions.end() && (end < 0 || it->first < end); ++it) {
+            ids.insert(it->second);
         }
     }
     return ids;
@@ -752,17 +770,16 @@ std::unordered_set<int> TrackModel::getCompositionsInRange(int position, int end
     READ_LOCK();
     // TODO: this function doesn't take into accounts the fact that there are two tracks
     std::unordered_set<int> ids;
-    for (const auto &compo : m_allCompositions) {
-        int pos = compo.second->getPosition();
-        int length = compo.second->getPlaytime();
-        if (end > -1 && pos >= end) {
-            continue;
-        }
-        if (pos >= position || pos + length - 1 >= position) {
-            
-            ids.insert(compo.first);
+    auto it = m_compoPos.upper_bound(position);
+    if (it != m_compoPos.begin()) {
+        auto previous = std::prev(it);
+        if (previous->first + m_allCompositions.at(previous->second)->getPlaytime() - 1 >= position) {
+            it = previous;
         }
     }
+    for (; it != m_compoPos.end() && (end < 0 || it->first < end); ++it) {
+        ids.insert(it->second);
+    }
     return ids;
 }
 
@@ -916,6 +933,24 @@ bool TrackModel::checkConsistency()
         return false;
     }
 
+    // We now check the clips position index
+    if (m_clipPos[0].size() + m_clipPos[1].size() != m_allClips.size()) {
+        qDebug() << "Error: the number of clips position doesn't match number of clips";
+        return false;
+    }
+    for (const auto &c : m_allClips) {
+        int subPlaylist = c.second->getSubPlaylistIndex();
+        if (subPlaylist < 0 || subPlaylist > 1) {
+            qDebug() << "Error: clip " << c.first << " has an invalid playlist index" << subPlaylist;
+            return false;
+        }
+        auto it = m_clipPos[subPlaylist].find(c.second->getPosition());
+        if (it == m_clipPos[subPlaylist].end() || it->second != c.first) {
+            qDebug() << "Error: the position of clip " << c.first << " is not properly stored";
+            return false;
+        }
+    }
+
     // We now check compositions positions
     if (m_allCompositions.size() != m_compoPos.size()) {
         qDebug() << "Error: the number of compositions position doesn't match number of compositions";
@@ -1262,6 +1297,15 @@ void TrackModel::setEffectStackEnabled(bool enable)
 
 int TrackModel::trackDuration() const
 {
+    if (m_batchDepth > 0) {
+        // The tractor length is only refreshed at the end of the batch, use the length of its playlists
+        int duration = 0;
+        for (int i = 0; i < m_track->count(); ++i) {
+            std::unique_ptr<Mlt::Producer> playlist(m_track->track(i));
+            duration = qMax(duration, playlist->get_playtime());
+        }
+        return duration;
+    }
     return m_track->get_length();
 }
 
@@ -1321,6 +1365,33 @@ bool TrackModel::copyEffect(const std::shared_ptr<EffectStackModel> &stackModel,
     return m_effectStack->copyEffect(stackModel->getEffectStackRow(rowId), isAudioTrack() ? PlaylistState::AudioOnly : PlaylistState::VideoOnly);
 }
 
+void TrackModel::beginPlaylistBatch()
+{
+    if (m_batchDepth++ > 0) {
+        return;
+    }
+    // The parent tractor recomputes its length each time a playlist fires "producer-changed", through a listener owned by its multitrack.
+    // Only listeners of the given owner are blocked, so block this one and refresh the tractor once at the end of the batch
+    mlt_multitrack multitrack = mlt_tractor_multitrack(m_track->get_tractor());
+    for (auto &playlist : m_playlists) {
+        mlt_events_block(playlist.get_properties(), multitrack);
+    }
+}
+
+void TrackModel::endPlaylistBatch()
+{
+    Q_ASSERT(m_batchDepth > 0);
+    if (--m_batchDepth > 0) {
+        return;
+    }
+    mlt_multitrack multitrack = mlt_tractor_multitrack(m_track->get_tractor());
+    for (auto &playlist : m_playlists) {
+        mlt_events_unblock(playlist.get_properties(), multitrack);
+    }
+    // The multitrack refresh notifies the track tractor, which notifies the timeline tractor
+    mlt_multitrack_refresh(multitrack);
+}
+
 void TrackModel::lock()
 {
     setProperty(QStringLiteral("kdenlive:locked_track"), QStringLiteral("1"));
@@ -1339,6 +1410,28 @@ void TrackModel::unlock()
 }
 
 
+bool TrackModel::isAvailableExcept(int position, int duration, const std::unordered_set<int> &ignoredClips) const
+{
+    READ_LOCK();
+    const int end = position + duration;
+    for (const auto &positions : m_clipPos) {
+        // Clips don't overlap in a playlist, so only the last clip starting before position can intersect the range
+        auto it = positions.upper_bound(position);
+        if (it != positions.begin()) {
+            auto previous = std::prev(it);
+            if (previous->first + m_allClips.at(previous->second)->getPlaytime() > position) {
+                it = previous;
+            }
+        }
+        for (; it != positions.end() && it->first < end; ++it) {
+            if (ignoredClips.count(it->second) == 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 bool TrackModel::isAvailable(int position, int duration)
 {
     //TODO: warning, does not work on second playlist
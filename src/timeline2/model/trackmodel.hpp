@@ -106,6 +106,12 @@ public:
      */
     bool isMute() const;
 
+    /* @brief Starts batching the edits of the track playlists: the tractor does not refresh its length after each edit anymore until
+       endPlaylistBatch(), which triggers a single refresh. Each edit still locks its playlist on its own. Batches can be nested.
+     */
+    void beginPlaylistBatch();
+    void endPlaylistBatch();
+
     // TODO make protected
     QVariant getProperty(const QString &name) const;
     void setProperty(const QString &name, const QString &value);
@@ -259,6 +265,8 @@ protected:
 
     /* @brief Returns the list of the ids of the clips that intersect the given range */
     std::unordered_set<int> getClipsInRange(int position, int end = -1);
+    /* @brief Move a clip to a new position in the position index, must be called whenever a clip of this track changes its position */
+    void updateClipPosition(int clipId, int position);
     /* @brief Returns the list of the ids of the compositions that intersect the given range */
     std::unordered_set<int> getCompositionsInRange(int position, int end);
 
@@ -268,6 +276,9 @@ protected:
     bool copyEffect(const std::shared_ptr<EffectStackModel> &stackModel, int rowId);
     /* @brief Returns true if we have a blank at position for duration */
     bool isAvailable(int position, int duration);
+    /* @brief Returns true if no clip, apart from the ignored ones, intersects [position, position + duration) in any playlist.
+       This only uses the clip position index, MLT is not queried */
+    bool isAvailableExcept(int position, int duration, const std::unordered_set<int> &ignoredClips) const;
 
 public slots:
     /*Delete the current track and all its associated clips */
@@ -291,8 +302,13 @@ private:
     std::map<int, int> m_compoPos; // We store the positions of the compositions. In Melt, the compositions are not inserted at the track level, but we keep
                                    // those positions here to check for moves and resize
 
+    std::map<int, int> m_clipPos[2]; // Position index of the clips (position -> clip id) for each playlist. Clips never overlap inside a playlist,
+                                     // which allows range and point queries without scanning all clips
+
     mutable QReadWriteLock m_lock; // This is a lock that ensures safety in case of concurrent access
 
+    int m_batchDepth{0}; // Number of nested playlist batches
+
 protected:
     std::shared_ptr<EffectStackModel> m_effectStack;
 };
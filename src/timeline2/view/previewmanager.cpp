@@ -30,6 +30,7 @@
 #include <QProcess>
 #include <QStandardPaths>
 #include <QCollator>
+#include <QThread>
 
 PreviewManager::PreviewManager(TimelineController *controller, Mlt::Tractor *tractor)
     : QObject()
@@ -39,12 +40,12 @@ PreviewManager::PreviewManager(TimelineController *controller, Mlt::Tractor *tra
     , m_previewTrack(nullptr)
     , m_overlayTrack(nullptr)
     , m_previewTrackIndex(-1)
+    , m_abortingWorkers(false)
+    , m_workerCrashed(false)
     , m_initialized(false)
 {
     m_previewGatherTimer.setSingleShot(true);
     m_previewGatherTimer.setInterval(200);
-    QObject::connect(&m_previewProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &PreviewManager::processEnded);
-
 
     // Find path for Kdenlive renderer
 #ifdef Q_OS_WIN
@@ -58,8 +59,6 @@ PreviewManager::PreviewManager(TimelineController *controller, Mlt::Tractor *tra
             m_renderer = QStringLiteral("kdenlive_render");
         }
     }
-    connect(this, &PreviewManager::abortPreview, &m_previewProcess, &QProcess::kill, Qt::DirectConnection);
-    connect(&m_previewProcess, &QProcess::readyReadStandardError, this, &PreviewManager::receivedStderr);
 }
 
 PreviewManager::~PreviewManager()
@@ -468,12 +467,12 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
     if (add) {
         qDebug() << "CHUNKS CHANGED: " << m_dirtyChunks;
         m_controller->dirtyChunksChanged();
-        if (m_previewProcess.state() == QProcess::NotRunning && KdenliveSettings::autopreview()) {
+        if (!isRendering() && KdenliveSettings::autopreview()) {
             m_previewTimer.start();
         }
     } else {
         // Remove processed chunks
-        bool isRendering = m_previewProcess.state() != QProcess::NotRunning;
+        bool wasRendering = isRendering();
         m_previewGatherTimer.stop();
         abortRendering();
         m_tractor->lock();
@@ -495,24 +494,40 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
         m_controller->renderedChunksChanged();
         m_controller->dirtyChunksChanged();
         m_tractor->unlock();
-        if (isRendering || KdenliveSettings::autopreview()) {
+        if (wasRendering || KdenliveSettings::autopreview()) {
             m_previewTimer.start();
         }
     }
 }
 
+bool PreviewManager::isRendering() const
+{
+    for (auto it = m_workers.constBegin(); it != m_workers.constEnd(); ++it) {
+        if (it.key()->state() != QProcess::NotRunning) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void PreviewManager::abortRendering()
 {
-    if (m_previewProcess.state() == QProcess::NotRunning) {
+    if (!isRendering()) {
         return;
     }
     qDebug() << "/// ABORTING RENDEIGN 1\nRRRRRRRRRR";
+    m_abortingWorkers = true;
     emit abortPreview();
-    m_previewProcess.waitForFinished();
-    if (m_previewProcess.state() != QProcess::NotRunning) {
-        m_previewProcess.kill();
-        m_previewProcess.waitForFinished();
+    // Finished workers are removed from m_workers by processEnded, so iterate on a copy
+    const QList<QProcess *> workers = m_workers.keys();
+    for (QProcess *worker : workers) {
+        worker->waitForFinished();
+        if (worker->state() != QProcess::NotRunning) {
+            worker->kill();
+            worker->waitForFinished();
+        }
     }
+    m_abortingWorkers = false;
     // Re-init time estimation
     emit previewRender(-1, QString(), 1000);
 }
@@ -537,17 +552,25 @@ void PreviewManager::startPreviewRender()
     }
 }
 
-void PreviewManager::receivedStderr()
+void PreviewManager::receivedStderr(QProcess *worker)
 {
-    QStringList resultList = QString::fromLocal8Bit(m_previewProcess.readAllStandardError()).split(QLatin1Char('\n'));
+    QStringList resultList = QString::fromLocal8Bit(worker->readAllStandardError()).split(QLatin1Char('\n'));
     for (auto &result : resultList) {
         qDebug() << "GOT PROCESS RESULT: " << result;
         if (result.startsWith(QLatin1String("START:"))) {
             workingPreview = result.section(QLatin1String("START:"), 1).simplified().toInt();
             qDebug() << "// GOT START INFO: " << workingPreview;
+            if (m_workers.contains(worker)) {
+                m_workers[worker].currentChunk = workingPreview;
+            }
             m_controller->workingPreviewChanged();
         } else if (result.startsWith(QLatin1String("DONE:"))) {
             int chunk = result.section(QLatin1String("DONE:"), 1).simplified().toInt();
+            if (m_workers.contains(worker)) {
+                PreviewWorker &info = m_workers[worker];
+                info.pendingChunks.removeAll(QString::number(chunk));
+                info.currentChunk = -1;
+            }
             m_processedChunks++;
             QString fileName = QStringLiteral("%1.%2").arg(chunk).arg(m_extension);
             qDebug() << "---------------\nJOB PROGRRESS: " << m_chunksToRender << ", " << m_processedChunks << " = "
@@ -559,56 +582,135 @@ void PreviewManager::receivedStderr()
     }
 }
 
+int PreviewManager::workerCount(int chunks) const
+{
+    int workers = KdenliveSettings::previewworkers();
+    if (workers <= 0) {
+        // Automatic mode: share the cores between the encoders
+        int consumerThreads = 0;
+        for (const QString &param : m_consumerParams) {
+            if (param.startsWith(QLatin1String("threads="))) {
+                consumerThreads = param.section(QLatin1Char('='), 1).toInt();
+            }
+        }
+        if (consumerThreads <= 0) {
+            consumerThreads = qMax(1, KdenliveSettings::previewworkerthreads());
+        }
+        workers = QThread::idealThreadCount() / consumerThreads;
+    }
+    return qBound(1, workers, qMax(1, chunks));
+}
+
 void PreviewManager::doPreviewRender(const QString &scene)
 {
     // initialize progress bar
-    std::sort(m_dirtyChunks.begin(), m_dirtyChunks.end());
     if (m_dirtyChunks.isEmpty()) {
         return;
     }
-    Q_ASSERT(m_previewProcess.state() == QProcess::NotRunning);
-
-    QStringList chunks;
-    for (QVariant &frame : m_dirtyChunks) {
-        chunks << frame.toString();
-    }
+    Q_ASSERT(!isRendering());
+    int chunkSize = KdenliveSettings::timelinechunks();
+    // Render the chunks closest to the playhead first
+    int position = pCore->getTimelinePosition();
+    position -= position % chunkSize;
+    std::sort(m_dirtyChunks.begin(), m_dirtyChunks.end(), [position](const QVariant &a, const QVariant &b) {
+        int distA = qAbs(a.toInt() - position);
+        int distB = qAbs(b.toInt() - position);
+        return distA < distB || (distA == distB && a.toInt() < b.toInt());
+    });
     m_chunksToRender = m_dirtyChunks.count();
     m_processedChunks = 0;
+    m_workerCrashed = false;
+    m_sceneList = scene;
+    // Deal the chunks to the workers so that each of them starts near the playhead
+    int workers = workerCount(m_chunksToRender);
+    QVector<QStringList> shards(workers);
+    for (int i = 0; i < m_dirtyChunks.count(); i++) {
+        shards[i % workers] << m_dirtyChunks.at(i).toString();
+    }
+    std::sort(m_dirtyChunks.begin(), m_dirtyChunks.end());
+    pCore->currentDoc()->previewProgress(0);
+    for (const QStringList &shard : shards) {
+        startWorker(shard, 0);
+    }
+}
+
+void PreviewManager::startWorker(const QStringList &chunks, int restarts)
+{
     int chunkSize = KdenliveSettings::timelinechunks();
+    QStringList consumerParams = m_consumerParams;
+    int workers = workerCount(m_chunksToRender);
+    if (workers > 1) {
+        bool hasThreads = false;
+        for (const QString &param : consumerParams) {
+            if (param.startsWith(QLatin1String("threads="))) {
+                hasThreads = true;
+                break;
+            }
+        }
+        if (!hasThreads) {
+            // Don't let each encoder use all cores
+            consumerParams << QStringLiteral("threads=%1").arg(qMax(1, QThread::idealThreadCount() / workers));
+        }
+    }
     QStringList args{KdenliveSettings::rendererpath(),
-                     scene,
+                     m_sceneList,
                      m_cacheDir.absolutePath(),
                      QStringLiteral("-split"),
                      chunks.join(QLatin1Char(',')),
                      QString::number(chunkSize - 1),
                      pCore->getCurrentProfilePath(),
                      m_extension,
-                     m_consumerParams.join(QLatin1Char(' '))};
+                     consumerParams.join(QLatin1Char(' '))};
     qDebug() << " -  - -STARTING PREVIEW JOBS: " << args;
-    pCore->currentDoc()->previewProgress(0);
-    m_previewProcess.start(m_renderer, args);
-    if (m_previewProcess.waitForStarted()) {
+    auto *worker = new QProcess(this);
+    PreviewWorker info;
+    info.pendingChunks = chunks;
+    info.restarts = restarts;
+    m_workers.insert(worker, info);
+    connect(this, &PreviewManager::abortPreview, worker, &QProcess::kill, Qt::DirectConnection);
+    connect(worker, &QProcess::readyReadStandardError, this, [this, worker]() { receivedStderr(worker); });
+    connect(worker, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, worker](int, QProcess::ExitStatus status) { processEnded(worker, status); });
+    worker->start(m_renderer, args);
+    if (worker->waitForStarted()) {
         qDebug() << " -  - -STARTING PREVIEW JOBS . . . STARTED";
     }
 }
 
-void PreviewManager::processEnded(int, QProcess::ExitStatus status)
+void PreviewManager::processEnded(QProcess *worker, QProcess::ExitStatus status)
 {
     qDebug() << "// PROCESS IS FINISHED!!!";
-    const QString sceneList = m_cacheDir.absoluteFilePath(QStringLiteral("preview.mlt"));
-    QFile::remove(sceneList);
+    if (!m_workers.contains(worker)) {
+        return;
+    }
+    PreviewWorker info = m_workers.take(worker);
+    worker->deleteLater();
     if (status == QProcess::QProcess::CrashExit) {
         qDebug() << "// PROCESS CRASHED!!!!!!";
-        pCore->currentDoc()->previewProgress(-1);
-        if (workingPreview >= 0) {
-            const QString fileName = QStringLiteral("%1.%2").arg(workingPreview).arg(m_extension);
+        if (info.currentChunk >= 0) {
+            const QString fileName = QStringLiteral("%1.%2").arg(info.currentChunk).arg(m_extension);
             if (m_cacheDir.exists(fileName)) {
                 m_cacheDir.remove(fileName);
             }
+            // Skip the chunk that caused the crash, it stays dirty
+            info.pendingChunks.removeAll(QString::number(info.currentChunk));
+        }
+        if (!m_abortingWorkers) {
+            m_workerCrashed = true;
+            if (!info.pendingChunks.isEmpty() && info.restarts < 2) {
+                // Restart a worker for the rest of this shard
+                startWorker(info.pendingChunks, info.restarts + 1);
+                return;
+            }
         }
-    } else {
-        pCore->currentDoc()->previewProgress(1000);
     }
+    if (!m_workers.isEmpty()) {
+        // Other workers are still busy
+        return;
+    }
+    QFile::remove(m_sceneList);
+    // Aborted workers did not finish their chunks either
+    pCore->currentDoc()->previewProgress(m_workerCrashed || m_abortingWorkers ? -1 : 1000);
     workingPreview = -1;
     m_controller->workingPreviewChanged();
 }
@@ -748,8 +850,13 @@ void PreviewManager::gotPreviewRender(int frame, const QString &file, int progre
 
 void PreviewManager::corruptedChunk(int frame, const QString &fileName)
 {
+    m_abortingWorkers = true;
     emit abortPreview();
-    m_previewProcess.waitForFinished();
+    const QList<QProcess *> workers = m_workers.keys();
+    for (QProcess *worker : workers) {
+        worker->waitForFinished();
+    }
+    m_abortingWorkers = false;
     if (workingPreview >= 0) {
         workingPreview = -1;
         m_controller->workingPreviewChanged();
@@ -24,6 +24,7 @@
 
 #include <QDir>
 #include <QFuture>
+#include <QHash>
 #include <QMutex>
 #include <QProcess>
 #include <QTimer>
@@ -84,7 +85,7 @@ public:
     int setOverlayTrack(Mlt::Playlist *overlay);
     /** @brief Remove the effect compare overlay track */
     void removeOverlayTrack();
-    /** @brief The current preview chunk being processed, -1 if none */
+    /** @brief The last preview chunk started by one of the workers, -1 if none */
     int workingPreview;
     /** @brief Returns the list of existing chunks */
     QPair<QStringList, QStringList> previewChunks() const;
@@ -100,8 +101,24 @@ private:
     int m_previewTrackIndex;
     /** @brief: The kdenlive renderer app. */
     QString m_renderer;
-    /** @brief: The kdenlive timeline preview process. */
-    QProcess m_previewProcess;
+    /** @brief: A kdenlive_render process rendering a shard of the dirty chunks. */
+    struct PreviewWorker
+    {
+        /** @brief: The chunks assigned to this worker that are not rendered yet, in render order */
+        QStringList pendingChunks;
+        /** @brief: The chunk currently processed by this worker, -1 if none */
+        int currentChunk = -1;
+        /** @brief: How many times this shard was restarted after a crash */
+        int restarts = 0;
+    };
+    /** @brief: The running timeline preview processes. */
+    QHash<QProcess *, PreviewWorker> m_workers;
+    /** @brief: The playlist rendered by the current workers, kept until all of them are finished. */
+    QString m_sceneList;
+    /** @brief: True while we are killing the workers, so that they are not restarted. */
+    bool m_abortingWorkers;
+    /** @brief: True if one of the workers of the current batch crashed. */
+    bool m_workerCrashed;
     /** @brief: The directory used to store the preview files. */
     QDir m_cacheDir;
     /** @brief: The directory used to store undo history of preview files (child of m_cacheDir). */
@@ -130,19 +147,25 @@ private:
     void enable();
     /** @brief: Temporarily disable timeline preview track. */
     void disable();
+    /** @brief: Returns true if at least one preview worker is running. */
+    bool isRendering() const;
+    /** @brief: Number of renderer processes to use for @param chunks dirty chunks. */
+    int workerCount(int chunks) const;
+    /** @brief: Start a renderer process for the given chunks. */
+    void startWorker(const QStringList &chunks, int restarts);
 
 private slots:
     /** @brief: To avoid filling the hard drive, remove preview undo history after 5 steps. */
     void doCleanupOldPreviews();
-    /** @brief: Start the real rendering process. */
+    /** @brief: Start the real rendering processes, chunks nearest to the playhead first. */
     void doPreviewRender(const QString &scene); // std::shared_ptr<Mlt::Producer> sourceProd);
     /** @brief: If user does an undo, then makes a new timeline operation, delete undo history of more recent stack . */
     void slotRemoveInvalidUndo(int ix);
     /** @brief: When the timer collecting invalid zones is done, process. */
     void slotProcessDirtyChunks();
-    /** @brief: Process preview rendering output. */
-    void receivedStderr();
-    void processEnded(int, QProcess::ExitStatus status);
+    /** @brief: Process preview rendering output of a worker. */
+    void receivedStderr(QProcess *worker);
+    void processEnded(QProcess *worker, QProcess::ExitStatus status);
 
 public slots:
     /** @brief: Prepare and start rendering. */
@@ -23,10 +23,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "kdenlivesettings.h"
 #include "core.h"
 #include "bin/projectitemmodel.h"
+#include "lib/audio/audioPeaks.h"
 #include <QPainter>
 #include <QPainterPath>
 #include <QQuickPaintedItem>
 #include <QElapsedTimer>
+#include <algorithm>
 #include <cmath>
 
 const QStringList chanelNames{"L", "R", "C", "LFE", "BL", "BR"};
@@ -97,12 +99,11 @@ public:
         // setClip(true);
         setEnabled(false);
         m_showItem = false;
-        m_precisionFactor = 1;
         //setRenderTarget(QQuickPaintedItem::FramebufferObject);
         //setMipmap(true);
         setTextureSize(QSize(1, 1));
         connect(this, &TimelineWaveform::levelsChanged, [&]() {
-            if (!m_binId.isEmpty() && m_audioLevels.isEmpty() && m_stream >= 0) {
+            if (!m_binId.isEmpty() && !m_peaks && m_stream >= 0) {
                 update();
             }
         });
@@ -131,75 +132,63 @@ public:
         if (!m_showItem || m_binId.isEmpty()) {
             return;
         }
-        if (m_audioLevels.isEmpty() && m_stream >= 0) {
-            m_audioLevels = pCore->projectItemModel()->getAudioLevelsByBinID(m_binId, m_stream);
-            if (m_audioLevels.isEmpty()) {
+        if (!m_peaks && m_stream >= 0) {
+            m_peaks = pCore->projectItemModel()->getAudioPeaksByBinID(m_binId, m_stream);
+            if (!m_peaks) {
                 return;
             }
         }
-        qreal indicesPrPixel = qreal(m_outPoint - m_inPoint) / width() * m_precisionFactor;
-        //qDebug()<<"== GOT DIMENSIONS FOR WAVE: "<<(m_outPoint - m_inPoint)<<", WID: "<<width();
+        if (!m_peaks || m_channels <= 0 || width() <= 0) {
+            return;
+        }
+        // In and out points are expressed in frames * channels, out is before in for reversed clips
+        const double framesPrPixel = qreal(m_outPoint - m_inPoint) / m_channels / width();
+        const double startFrame = qreal(m_inPoint) / m_channels;
+        const double samplesPerFrame = m_peaks->samplesPerFrame();
+        // Only read the pyramid level matching the zoom, so that the cost depends on the item width
+        const int level = m_peaks->levelFor(qAbs(framesPrPixel) * samplesPerFrame);
+        const int channels = qMin(m_channels, m_peaks->channels());
+        const int firstPixel = qMax(0, m_drawInPoint);
+        const int lastPixel = qMin(int(ceil(width())), m_drawOutPoint);
+        if (lastPixel <= firstPixel) {
+            return;
+        }
+        auto sampleRange = [&](int x, double &start, double &end) {
+            start = (startFrame + x * framesPrPixel) * samplesPerFrame;
+            end = (startFrame + (x + 1) * framesPrPixel) * samplesPerFrame;
+        };
         QPen pen = painter->pen();
         pen.setColor(m_color);
+        pen.setWidthF(0);
         painter->setBrush(m_color);
-        pen.setCapStyle(Qt::FlatCap);
-        double increment = qMax(1., 1. / qAbs(indicesPrPixel));
-        int h = height();
-        double offset = 0;
-        bool pathDraw = increment > 1.2;
-        if (increment > 1. && !pathDraw) {
-            pen.setWidth(ceil(increment));
-            offset = pen.width() / 2.;
-        } else if (pathDraw) {
-            pen.setWidthF(0);
-        }
         painter->setPen(pen);
-        QPainterPath path;
+        double start;
+        double end;
         if (!KdenliveSettings::displayallchannels()) {
             // Draw merged channels
-            double i = 0;
-            double level;
-            int j = 0;
-            if (m_drawInPoint > 0) {
-                j = m_drawInPoint / increment;
-            }
-            if (pathDraw) {
-                path.moveTo(j - 1, height());
-            }
-            for (; i <= width() && i < m_drawOutPoint; j++) {
-                i = j * increment;
-                int idx = m_precisionFactor * m_inPoint + int(i * indicesPrPixel);
-                idx += idx % m_channels;
-                i -= offset;
-                if (idx + m_channels >= m_audioLevels.length() || idx < 0) {
-                    break;
-                }
-                level = m_audioLevels.at(idx) / 255.;
-                for (int k = 1; k < m_channels; k++) {
-                    level = qMax(level, m_audioLevels.at(idx + k) / 255.);
+            const double h = height();
+            QPainterPath path;
+            path.moveTo(firstPixel, h);
+            for (int x = firstPixel; x <= lastPixel; x++) {
+                sampleRange(x, start, end);
+                int rms = 0;
+                for (int k = 0; k < channels; k++) {
+                    rms = qMax(rms, int(m_peaks->peak(level, k, start, end).rms));
                 }
-                if (pathDraw) {
-                    path.lineTo(i, height() - level * height());
-                } else {
-                    painter->drawLine(i, h, i, h - (h * level));
-                }
-            }
-            if (pathDraw) {
-                path.lineTo(i, height());
-                painter->drawPath(path);
+                path.lineTo(x, h - h * rms / 255.);
             }
+            path.lineTo(lastPixel, h);
+            painter->drawPath(path);
         } else {
             double channelHeight = (double)height() / m_channels;
             // Draw separate channels
-            double i = 0;
-            double level;
             QRectF bgRect(0, 0, width(), channelHeight);
-            // Path for vector drawing
             //qDebug()<<"==== DRAWING FROM: "<<m_drawInPoint<<" - "<<m_drawOutPoint<<", FIRST: "<<m_firstChunk;
+            QPolygonF upper;
+            QPolygonF lower;
             for (int channel = 0; channel < m_channels; channel++) {
                 // y is channel median pos
                 double y = (channel * channelHeight) + channelHeight / 2;
-                path.moveTo(-1, y);
                 painter->setOpacity(0.2);
                 if (channel % 2 == 0) {
                     // Add dark background on odd channels
@@ -208,40 +197,21 @@ public:
                 }
                 // Draw channel median line
                 painter->setOpacity(0.5);
-                pen.setWidthF(0);
-                painter->setPen(pen);
                 painter->drawLine(QLineF(0., y, width(), y));
-                pen.setWidth(ceil(increment));
-                painter->setPen(pathDraw ? Qt::NoPen : pen);
                 painter->setOpacity(1);
-                i = 0;
-                int j = 0;
-                if (m_drawInPoint > 0) {
-                    j = m_drawInPoint / increment;
-                }
-                if (pathDraw) {
-                    path.moveTo(m_drawInPoint - 1, y);
-                }
-                for (; i <= width() && i < m_drawOutPoint; j++) {
-                    i = j * increment;
-                    int idx = m_precisionFactor * m_inPoint + ceil(i * indicesPrPixel);
-                    idx += idx % m_channels;
-                    i -= offset;
-                    idx += channel;
-                    if (idx >= m_audioLevels.length() || idx < 0) break;
-                    if (pathDraw) {
-                        level = m_audioLevels.at(idx) * channelHeight / 510.;
-                        path.lineTo(i, y - level);
-                    } else {
-                        level = m_audioLevels.at(idx) * channelHeight / 510.; // divide height by 510 (2*255) to get height
-                        painter->drawLine(i, y - level, i, y + level);
+                if (channel < channels) {
+                    // Draw the real waveform envelope, from the sample minimum to maximum
+                    const double scale = channelHeight / 254.;
+                    upper.clear();
+                    lower.clear();
+                    for (int x = firstPixel; x <= lastPixel; x++) {
+                        sampleRange(x, start, end);
+                        AudioPeaks::Peak p = m_peaks->peak(level, channel, start, end);
+                        upper << QPointF(x, y - p.max * scale);
+                        lower << QPointF(x, y - p.min * scale);
                     }
-                }
-                if (pathDraw) {
-                    path.lineTo(i, y);
-                    painter->drawPath(path);
-                    QTransform tr(1, 0, 0, -1, 0, 2 * y);
-                    painter->drawPath(tr.map(path));
+                    std::reverse(lower.begin(), lower.end());
+                    painter->drawPolygon(upper + lower);
                 }
                 if (m_firstChunk && m_channels > 1 && m_channels < 7) {
                     painter->drawText(2, y + channelHeight / 2, chanelNames[channel]);
@@ -258,7 +228,7 @@ signals:
     void audioChannelsChanged();
 
 private:
-    QVector<uint8_t> m_audioLevels;
+    std::shared_ptr<AudioPeaks> m_peaks;
     int m_inPoint;
     int m_outPoint;
     // Pixels outside the view, can be dropped
@@ -269,7 +239,6 @@ private:
     bool m_format;
     bool m_showItem;
     int m_channels;
-    int m_precisionFactor;
     int m_stream;
     bool m_firstChunk;
 };
@@ -21,45 +21,168 @@
 #include "bin/projectitemmodel.h"
 #include "core.h"
 #include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailproducerpool.hpp"
 #include "doc/kthumb.h"
 
 #include <QCryptographicHash>
 #include <QDebug>
-#include <QQuickImageProvider>
+#include <QtConcurrent>
+#include <algorithm>
 #include <mlt++/MltFilter.h>
 #include <mlt++/MltProfile.h>
 
+ThumbnailResponse::ThumbnailResponse(int frameNumber, bool exact, const QSize &requestedSize)
+    : m_frameNumber(frameNumber)
+    , m_exact(exact)
+    , m_requestedSize(requestedSize)
+{
+}
+
+QQuickTextureFactory *ThumbnailResponse::textureFactory() const
+{
+    return QQuickTextureFactory::textureFactoryForImage(m_image);
+}
+
+void ThumbnailResponse::cancel()
+{
+    m_canceled = true;
+}
+
+bool ThumbnailResponse::isCanceled() const
+{
+    return m_canceled;
+}
+
+int ThumbnailResponse::frameNumber() const
+{
+    return m_frameNumber;
+}
+
+bool ThumbnailResponse::exact() const
+{
+    return m_exact;
+}
+
+QSize ThumbnailResponse::requestedSize() const
+{
+    return m_requestedSize;
+}
+
+void ThumbnailResponse::finish(const QImage &image)
+{
+    m_image = image;
+    emit finished();
+}
+
 ThumbnailProvider::ThumbnailProvider()
-    : QQuickImageProvider(QQmlImageProviderBase::Image, QQmlImageProviderBase::ForceAsynchronousImageLoading)
+    : QQuickAsyncImageProvider()
 {
+    m_threadPool.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
 }
 
-ThumbnailProvider::~ThumbnailProvider() = default;
+ThumbnailProvider::~ThumbnailProvider()
+{
+    {
+        QMutexLocker lk(&m_mutex);
+        for (auto &requests : m_pending) {
+            for (ThumbnailResponse *response : requests) {
+                response->cancel();
+            }
+        }
+    }
+    m_threadPool.waitForDone();
+}
 
-QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+QQuickImageResponse *ThumbnailProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
 {
-    QImage result;
-    // id is binID/#frameNumber
+    // id is binID/#frameNumber, or binID/#frameNumber/exact when the view shows single frames.
+    // Otherwise the thumbnail can be extracted from the next keyframe, which is much faster for long GOP footage
     QString binId = id.section('/', 0, 0);
+    const QString frame = id.section('#', -1);
     bool ok;
-    int frameNumber = id.section('#', -1).toInt(&ok);
-    if (ok) {
-        if (ThumbnailCache::get()->hasThumbnail(binId, frameNumber, false)) {
-            result = ThumbnailCache::get()->getThumbnail(binId, frameNumber);
-            *size = result.size();
-            return result;
+    int frameNumber = frame.section('/', 0, 0).toInt(&ok);
+    bool exact = frame.section('/', 1) == QLatin1String("exact");
+    auto *response = new ThumbnailResponse(ok ? frameNumber : -1, exact, requestedSize);
+    // Even cached thumbnails go through a worker, the view expects the finished signal after this method returned
+    QMutexLocker lk(&m_mutex);
+    m_pending[binId].append(response);
+    int &workers = m_workers[binId];
+    if (workers < ThumbnailProducerPool::MaxProducersPerClip) {
+        workers++;
+        QtConcurrent::run(&m_threadPool, this, &ThumbnailProvider::processRequests, binId);
+    }
+    return response;
+}
+
+QList<ThumbnailResponse *> ThumbnailProvider::takeBatch(const QString &binId)
+{
+    auto pending = m_pending.find(binId);
+    if (pending == m_pending.end() || pending->isEmpty()) {
+        return {};
+    }
+    QList<ThumbnailResponse *> &requests = pending.value();
+    std::sort(requests.begin(), requests.end(), [](ThumbnailResponse *a, ThumbnailResponse *b) { return a->frameNumber() < b->frameNumber(); });
+    // Share the requests between the workers of this clip, each one getting a contiguous range of frames
+    int workers = qMax(1, m_workers.value(binId));
+    int count = (requests.size() + workers - 1) / workers;
+    QList<ThumbnailResponse *> batch = requests.mid(0, count);
+    requests.erase(requests.begin(), requests.begin() + count);
+    if (requests.isEmpty()) {
+        m_pending.erase(pending);
+    }
+    return batch;
+}
+
+void ThumbnailProvider::processRequests(const QString &binId)
+{
+    std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(binId);
+    std::shared_ptr<Mlt::Producer> prod;
+    bool fastProducer = false;
+    int lastFrame = 0;
+    while (true) {
+        QList<ThumbnailResponse *> batch;
+        {
+            QMutexLocker lk(&m_mutex);
+            batch = takeBatch(binId);
+            if (batch.isEmpty()) {
+                if (--m_workers[binId] <= 0) {
+                    m_workers.remove(binId);
+                }
+                break;
+            }
         }
-        std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(binId);
-        if (binClip) {
-            std::shared_ptr<Mlt::Producer> prod = binClip->thumbProducer();
+        for (ThumbnailResponse *response : qAsConst(batch)) {
+            int frameNumber = response->frameNumber();
+            if (response->isCanceled() || frameNumber < 0) {
+                response->finish(QImage());
+                continue;
+            }
+            const bool exact = response->exact();
+            if (ThumbnailCache::get()->hasThumbnail(binId, frameNumber, false, exact)) {
+                response->finish(ThumbnailCache::get()->getThumbnail(binId, frameNumber, false, exact));
+                continue;
+            }
+            QImage result;
+            if (prod && fastProducer == exact) {
+                // Give back the producer before taking one of the other kind, we must never hold two
+                ThumbnailProducerPool::get()->release(binId, prod, lastFrame);
+                prod.reset();
+            }
+            if (binClip && !prod) {
+                prod = ThumbnailProducerPool::get()->acquire(binClip, frameNumber, !exact);
+                fastProducer = !exact;
+            }
             if (prod && prod->is_valid()) {
-                result = makeThumbnail(prod, frameNumber, requestedSize);
-                ThumbnailCache::get()->storeThumbnail(binId, frameNumber, result, false);
+                result = makeThumbnail(prod, frameNumber, response->requestedSize());
+                lastFrame = frameNumber;
+                ThumbnailCache::get()->storeThumbnail(binId, frameNumber, result, false, !exact);
             }
+            response->finish(result);
         }
     }
-    if (size) *size = result.size();
-    return result;
+    if (prod) {
+        ThumbnailProducerPool::get()->release(binId, prod, lastFrame);
+    }
 }
 
 QString ThumbnailProvider::cacheKey(Mlt::Properties &properties, const QString &service, const QString &resource, const QString &hash, int frameNumber)
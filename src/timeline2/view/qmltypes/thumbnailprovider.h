@@ -19,23 +19,59 @@
 #ifndef THUMBNAILPROVIDER_H
 #define THUMBNAILPROVIDER_H
 
-#include <KImageCache>
-#include <QCache>
+#include <QHash>
+#include <QMutex>
 #include <QQuickImageProvider>
+#include <QThreadPool>
+#include <atomic>
 #include <memory>
 #include <mlt++/MltProducer.h>
 #include <mlt++/MltProfile.h>
 
-class ThumbnailProvider : public QQuickImageProvider
+/** @brief A pending thumbnail request. It can be canceled by the view (for example when the clip scrolls out of view) until a worker handles it. */
+class ThumbnailResponse : public QQuickImageResponse
+{
+    Q_OBJECT
+public:
+    ThumbnailResponse(int frameNumber, bool exact, const QSize &requestedSize);
+    QQuickTextureFactory *textureFactory() const override;
+    void cancel() override;
+    bool isCanceled() const;
+    int frameNumber() const;
+    /** @brief Returns false if the image of a nearby keyframe is acceptable */
+    bool exact() const;
+    QSize requestedSize() const;
+    /** @brief Store the result and notify the view, must be called exactly once */
+    void finish(const QImage &image);
+
+private:
+    int m_frameNumber;
+    bool m_exact;
+    QSize m_requestedSize;
+    QImage m_image;
+    std::atomic_bool m_canceled{false};
+};
+
+class ThumbnailProvider : public QQuickAsyncImageProvider
 {
 public:
     explicit ThumbnailProvider();
     ~ThumbnailProvider() override;
-    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
 
 private:
     QImage makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frameNumber, const QSize &requestedSize);
     QString cacheKey(Mlt::Properties &properties, const QString &service, const QString &resource, const QString &hash, int frameNumber);
+    /** @brief Worker extracting the pending thumbnails of a clip, in frame order, until no request is left */
+    void processRequests(const QString &binId);
+    /** @brief Takes this worker's share of the pending requests of a clip, sorted by frame. m_mutex must be locked */
+    QList<ThumbnailResponse *> takeBatch(const QString &binId);
+    QThreadPool m_threadPool;
+    QMutex m_mutex;
+    /** @brief Pending requests per bin clip */
+    QHash<QString, QList<ThumbnailResponse *>> m_pending;
+    /** @brief Number of running workers per bin clip */
+    QHash<QString, int> m_workers;
 };
 
 #endif // THUMBNAILPROVIDER_H
@@ -2344,6 +2344,40 @@ void TimelineController::setAudioRef(int clipId)
             pCore->displayMessage(i18n("Cannot move clip to frame %1.", (pos + shift)), InformationMessage, 500);
         }
     });
+    connect(m_audioCorrelator.get(), &AudioCorrelation::gotAudioAlignBatch, this, [this](const QMap<int, int> &shifts) {
+        // Move all the aligned clips in one undo entry
+        Fun undo = []() { return true; };
+        Fun redo = []() { return true; };
+        const int refPos = m_model->getClipPosition(m_audioRef) - m_model->getClipIn(m_audioRef);
+        bool moved = false;
+        QMapIterator<int, int> i(shifts);
+        while (i.hasNext()) {
+            i.next();
+            const int cid = i.key();
+            if (!m_model->isClip(cid)) {
+                continue;
+            }
+            const int pos = refPos + i.value();
+            bool result;
+            if (m_model->m_groups->isInGroup(cid)) {
+                const int delta = pos - m_model->getClipPosition(cid);
+                if (delta == 0) {
+                    continue;
+                }
+                result = m_model->requestGroupMove(cid, m_model->m_groups->getRootId(cid), 0, delta, true, true, undo, redo);
+            } else {
+                result = m_model->requestClipMove(cid, m_model->getClipTrackId(cid), pos, true, true, true, true, undo, redo);
+            }
+            if (result) {
+                moved = true;
+            } else {
+                pCore->displayMessage(i18n("Cannot move clip to frame %1.", pos), InformationMessage, 500);
+            }
+        }
+        if (moved) {
+            pCore->pushUndo(undo, redo, i18n("Align clips"));
+        }
+    });
     connect(m_audioCorrelator.get(), &AudioCorrelation::displayMessage, pCore.get(), &Core::displayMessage);
 }
 
@@ -2370,6 +2404,7 @@ void TimelineController::alignAudio(int clipId)
         clipsToAnalyse.insert(clipId);
     }
     QList <int> processedGroups;
+    QList<AudioEnvelope *> envelopes;
     int processed = 0;
     for (int cid : clipsToAnalyse) {
         if (!m_model->isClip(cid) || cid == m_audioRef) {
@@ -2407,9 +2442,12 @@ void TimelineController::alignAudio(int clipId)
         }
         processed ++;
         // Perform audio calculation
-        AudioEnvelope *envelope = new AudioEnvelope(otherBinId, cid, (size_t)m_model->getClipIn(cid), (size_t)m_model->getClipPlaytime(cid),
-                                                (size_t)m_model->getClipPosition(cid));
-        m_audioCorrelator->addChild(envelope);
+        envelopes << new AudioEnvelope(otherBinId, cid, (size_t)m_model->getClipIn(cid), (size_t)m_model->getClipPlaytime(cid),
+                                       (size_t)m_model->getClipPosition(cid));
+    }
+    if (!envelopes.isEmpty()) {
+        // Analyse all clips of the group together
+        m_audioCorrelator->addChildren(envelopes);
     }
     if (processed == 0) {
         //TODO: improve feedback message after freeze
@@ -65,6 +65,8 @@ protected:
     /* @brief Returns the paths where the custom transitions' descriptions are stored */
     QStringList assetDirs() const override;
 
+    QString assetCacheName() const override;
+
     /* @brief Returns the path to the transitions' blacklist*/
     QString assetBlackListPath() const override;
 
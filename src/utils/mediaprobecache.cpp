@@ -0,0 +1,326 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "mediaprobecache.hpp"
+#include "bin/projectclip.h"
+#include "bin/projectitemmodel.h"
+#include "core.h"
+#include "doc/filesearchindex.h"
+#include "kdenlive_debug.h"
+#include "profiles/profilemodel.hpp"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <algorithm>
+#include <mlt++/MltProducer.h>
+#include <framework/mlt_version.h>
+
+namespace {
+const quint32 CacheMagic = 0x4b50524f; // "KPRO"
+const quint32 CacheVersion = 1;
+} // namespace
+
+std::unique_ptr<MediaProbeCache> MediaProbeCache::instance;
+std::once_flag MediaProbeCache::m_onceFlag;
+
+std::unique_ptr<MediaProbeCache> &MediaProbeCache::get()
+{
+    std::call_once(m_onceFlag, [] { instance.reset(new MediaProbeCache()); });
+    return instance;
+}
+
+MediaProbeCache::MediaProbeCache()
+{
+    // Revalidation must not compete with the clips being loaded or played
+    m_revalidationPool.setMaxThreadCount(1);
+}
+
+MediaProbeCache::~MediaProbeCache()
+{
+    cancelRevalidation();
+}
+
+// static
+QString MediaProbeCache::cachePath()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).absoluteFilePath(QStringLiteral("mediaprobe.cache"));
+}
+
+// static
+bool MediaProbeCache::isProbeProperty(const char *name)
+{
+    if (strncmp(name, "meta.", 5) == 0) {
+        return true;
+    }
+    static const char *probed[] = {"length", "video_index", "audio_index", "seekable", "creation_time", "source_fps"};
+    for (const char *prop : probed) {
+        if (strcmp(name, prop) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MediaProbeCache::load()
+{
+    m_loaded = true;
+    QFile file(cachePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    quint32 magic, version;
+    QString mltVersion;
+    stream >> magic >> version >> mltVersion;
+    // Another MLT version may probe files differently, start from scratch
+    if (magic != CacheMagic || version != CacheVersion || mltVersion != QString::fromLatin1(mlt_version_get_string())) {
+        return;
+    }
+    qint32 count;
+    stream >> count;
+    m_entries.reserve(size_t(qMax(0, count)));
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Entry entry;
+        stream >> path >> entry.size >> entry.modified >> entry.lastUsed >> entry.hash >> entry.properties;
+        m_entries[path] = entry;
+    }
+    if (stream.status() != QDataStream::Ok) {
+        qCDebug(KDENLIVE_LOG) << "Corrupted media probe cache, discarding it";
+        m_entries.clear();
+    }
+}
+
+void MediaProbeCache::save()
+{
+    QMutexLocker lk(&m_mutex);
+    if (!m_modified) {
+        return;
+    }
+    if (m_entries.size() > size_t(MaxEntries)) {
+        std::vector<std::pair<qint64, QString>> usage;
+        usage.reserve(m_entries.size());
+        for (const auto &entry : m_entries) {
+            usage.emplace_back(entry.second.lastUsed, entry.first);
+        }
+        auto last = usage.begin() + ptrdiff_t(m_entries.size() - size_t(MaxEntries));
+        std::nth_element(usage.begin(), last, usage.end());
+        for (auto it = usage.begin(); it != last; ++it) {
+            m_entries.erase(it->second);
+        }
+    }
+    QDir().mkpath(QFileInfo(cachePath()).absolutePath());
+    QSaveFile file(cachePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(KDENLIVE_LOG) << "Cannot write media probe cache" << file.fileName();
+        return;
+    }
+    QDataStream stream(&file);
+    stream << CacheMagic << CacheVersion << QString::fromLatin1(mlt_version_get_string()) << qint32(m_entries.size());
+    for (const auto &entry : m_entries) {
+        stream << entry.first << entry.second.size << entry.second.modified << entry.second.lastUsed << entry.second.hash << entry.second.properties;
+    }
+    if (file.commit()) {
+        m_modified = false;
+    }
+}
+
+MediaProbeCache::Entry *MediaProbeCache::validEntry(const QString &path, qint64 size, qint64 modified)
+{
+    if (!m_loaded) {
+        load();
+    }
+    auto it = m_entries.find(path);
+    if (it == m_entries.end()) {
+        return nullptr;
+    }
+    if (it->second.size != size || it->second.modified != modified) {
+        // The file was replaced, forget everything about it
+        m_entries.erase(it);
+        m_modified = true;
+        return nullptr;
+    }
+    it->second.lastUsed = QDateTime::currentMSecsSinceEpoch();
+    m_modified = true;
+    return &it->second;
+}
+
+bool MediaProbeCache::lookup(const QString &path, QMap<QString, QString> &properties)
+{
+    QFileInfo info(path);
+    if (!info.isFile()) {
+        return false;
+    }
+    QMutexLocker lk(&m_mutex);
+    Entry *entry = validEntry(path, info.size(), info.lastModified().toMSecsSinceEpoch());
+    if (entry == nullptr || entry->properties.isEmpty()) {
+        return false;
+    }
+    properties = entry->properties;
+    return true;
+}
+
+void MediaProbeCache::store(const QString &path, Mlt::Producer *producer, bool metaOnly)
+{
+    QFileInfo info(path);
+    if (!info.isFile() || producer == nullptr || !producer->is_valid()) {
+        return;
+    }
+    QMap<QString, QString> properties;
+    for (int i = 0; i < producer->count(); ++i) {
+        const char *name = producer->get_name(i);
+        const char *value = producer->get(i);
+        if (name != nullptr && value != nullptr && (metaOnly ? strncmp(name, "meta.", 5) == 0 : isProbeProperty(name))) {
+            properties.insert(QString::fromUtf8(name), QString::fromUtf8(value));
+        }
+    }
+    QMutexLocker lk(&m_mutex);
+    const qint64 size = info.size();
+    const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+    Entry *entry = validEntry(path, size, modified);
+    if (entry == nullptr) {
+        entry = &m_entries[path];
+        entry->size = size;
+        entry->modified = modified;
+        entry->lastUsed = QDateTime::currentMSecsSinceEpoch();
+    }
+    if (metaOnly) {
+        // Keep the length and stream indexes of a previous probe
+        for (auto it = properties.constBegin(); it != properties.constEnd(); ++it) {
+            entry->properties.insert(it.key(), it.value());
+        }
+    } else {
+        entry->properties = properties;
+    }
+    m_modified = true;
+}
+
+QString MediaProbeCache::fileHash(const QString &path, qint64 *size)
+{
+    QFileInfo info(path);
+    if (!info.isFile()) {
+        return QString();
+    }
+    const qint64 fileSize = info.size();
+    const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+    if (size) {
+        *size = fileSize;
+    }
+    {
+        QMutexLocker lk(&m_mutex);
+        Entry *entry = validEntry(path, fileSize, modified);
+        if (entry != nullptr && !entry->hash.isEmpty()) {
+            return entry->hash;
+        }
+    }
+    // Don't keep the lock while reading the file
+    const QString hash = FileSearchIndex::fileHash(path);
+    if (hash.isEmpty()) {
+        return hash;
+    }
+    QMutexLocker lk(&m_mutex);
+    Entry *entry = validEntry(path, fileSize, modified);
+    if (entry == nullptr) {
+        entry = &m_entries[path];
+        entry->size = fileSize;
+        entry->modified = modified;
+        entry->lastUsed = QDateTime::currentMSecsSinceEpoch();
+    }
+    entry->hash = hash;
+    m_modified = true;
+    return hash;
+}
+
+void MediaProbeCache::revalidate(const QString &binId, const QString &path)
+{
+    QMutexLocker lk(&m_mutex);
+    m_pendingRevalidation.append({binId, path});
+}
+
+void MediaProbeCache::startRevalidation()
+{
+    QMutexLocker lk(&m_mutex);
+    const int generation = m_generation;
+    for (const auto &pending : qAsConst(m_pendingRevalidation)) {
+        QtConcurrent::run(&m_revalidationPool, this, &MediaProbeCache::doRevalidate, pending.first, pending.second, generation);
+    }
+    m_pendingRevalidation.clear();
+}
+
+void MediaProbeCache::cancelRevalidation()
+{
+    ++m_generation;
+    {
+        QMutexLocker lk(&m_mutex);
+        m_pendingRevalidation.clear();
+    }
+    m_revalidationPool.clear();
+    m_revalidationPool.waitForDone();
+}
+
+void MediaProbeCache::doRevalidate(const QString &binId, const QString &path, int generation)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    Mlt::Producer producer(pCore->getCurrentProfile()->profile(), "avformat", path.toUtf8().constData());
+    if (!producer.is_valid() || generation != m_generation) {
+        return;
+    }
+    QMap<QString, QString> cached;
+    if (lookup(path, cached)) {
+        // An entry stored from a project only has the meta properties, the project provided the others
+        const bool metaOnly = !cached.contains(QStringLiteral("length"));
+        QMap<QString, QString> probed;
+        for (int i = 0; i < producer.count(); ++i) {
+            const char *name = producer.get_name(i);
+            const char *value = producer.get(i);
+            if (name != nullptr && value != nullptr && (metaOnly ? strncmp(name, "meta.", 5) == 0 : isProbeProperty(name))) {
+                probed.insert(QString::fromUtf8(name), QString::fromUtf8(value));
+            }
+        }
+        if (probed == cached) {
+            if (metaOnly) {
+                // Complete the entry with this probe
+                store(path, &producer);
+            }
+            return;
+        }
+    }
+    qCDebug(KDENLIVE_LOG) << "Cached media properties outdated for" << path << ", reloading clip";
+    store(path, &producer);
+    QMetaObject::invokeMethod(pCore.get(),
+                              [this, binId, generation]() {
+                                  if (generation != m_generation) {
+                                      return;
+                                  }
+                                  auto clip = pCore->projectItemModel()->getClipByBinID(binId);
+                                  if (clip) {
+                                      clip->reloadProducer(false);
+                                  }
+                              },
+                              Qt::QueuedConnection);
+}
@@ -0,0 +1,128 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#pragma once
+
+#include "definitions.h"
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Mlt {
+class Producer;
+}
+
+/** @brief This class is a persistent cache of what we learn when opening media files: the properties probed by MLT's avformat producer
+    (stream list, frame rate, size, length...) and the clip hash.
+    Entries are keyed by the file path and are only used while the file size and modification time match, so that project loading can create
+    lightweight avformat-novalidate producers for unchanged files instead of probing them again, and skip reading them to compute the hash.
+    Producers created from the cache are checked again by a low priority background thread, and the clip is reloaded if the file turned out to differ.
+    The cache is stored in the user's cache folder and shared by all projects.
+ * Note that this class is a Singleton
+ */
+
+class MediaProbeCache
+{
+
+public:
+    // Returns the instance of the Singleton
+    static std::unique_ptr<MediaProbeCache> &get();
+
+    ~MediaProbeCache();
+
+    /* @brief Retrieve the stored probe properties of a file
+       @param path is the absolute path of the file
+       @param properties is filled with the producer properties to apply
+       @returns false if the file is unknown or changed since it was probed. An entry only stored from a project has no length
+       and stream indexes, see store()
+    */
+    bool lookup(const QString &path, QMap<QString, QString> &properties);
+
+    /* @brief Store the probed properties of an avformat producer
+       @param path is the absolute path of the file opened by the producer
+       @param metaOnly if true, only the meta.* properties filled by the probe are merged in the entry. Used for producers restored
+       from a project, whose length and stream indexes may have been overridden by the project
+    */
+    void store(const QString &path, Mlt::Producer *producer, bool metaOnly = false);
+
+    /* @brief Returns the clip hash of a file, only reading the file if it changed since it was last hashed
+       @param size if not null, receives the file size
+    */
+    QString fileHash(const QString &path, qint64 *size = nullptr);
+
+    /* @brief Schedule a new probe of a file whose producer was created from the cache. If the result differs, the clip is reloaded
+       @param binId is the id of the clip using this file
+    */
+    void revalidate(const QString &binId, const QString &path);
+
+    /* @brief Start probing the scheduled files in a background thread. Called once the project is loaded, so that reloading a clip cannot
+       interfere with the timeline construction
+    */
+    void startRevalidation();
+
+    /* @brief Drop the pending revalidations, must be called before the clips of the current project are deleted */
+    void cancelRevalidation();
+
+    /* @brief Write the cache to disk if it was modified */
+    void save();
+
+    // Maximum number of files kept in the cache, the least recently used ones are dropped on save
+    static const int MaxEntries = 20000;
+
+protected:
+    // Constructor is protected because class is a Singleton
+    MediaProbeCache();
+
+    static std::unique_ptr<MediaProbeCache> instance;
+    static std::once_flag m_onceFlag; // flag to create the cache only once;
+
+    struct Entry
+    {
+        qint64 size{0};
+        qint64 modified{0}; // ms since epoch
+        qint64 lastUsed{0}; // ms since epoch
+        QString hash;
+        QMap<QString, QString> properties;
+    };
+
+    /* @brief Returns the entry of a file if its size and modification time still match, nullptr otherwise. Must be called with the lock held */
+    Entry *validEntry(const QString &path, qint64 size, qint64 modified);
+    /* @brief Probe a file and compare with the stored properties, runs in the revalidation thread */
+    void doRevalidate(const QString &binId, const QString &path, int generation);
+    /* @brief Read the cache file, called on first access */
+    void load();
+    static QString cachePath();
+    /* @brief The producer properties we store and restore */
+    static bool isProbeProperty(const char *name);
+
+    QMutex m_mutex;
+    bool m_loaded{false};
+    bool m_modified{false};
+    std::unordered_map<QString, Entry> m_entries;
+    QVector<QPair<QString, QString>> m_pendingRevalidation;
+    QThreadPool m_revalidationPool;
+    std::atomic<int> m_generation{0};
+};
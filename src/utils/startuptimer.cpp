@@ -0,0 +1,100 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "startuptimer.hpp"
+#include "kdenlive_debug.h"
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QStringList>
+#include <QVector>
+
+namespace {
+struct StartupPhases
+{
+    QMutex mutex;
+    QElapsedTimer timer;
+    qint64 lastMark{0};
+    bool reported{false};
+    QVector<QPair<QString, qint64>> phases;
+    QVector<QPair<QString, qint64>> tasks;
+};
+
+StartupPhases &phases()
+{
+    static StartupPhases instance;
+    return instance;
+}
+} // namespace
+
+void StartupTimer::start()
+{
+    StartupPhases &p = phases();
+    QMutexLocker lk(&p.mutex);
+    p.timer.start();
+    p.lastMark = 0;
+    p.phases.clear();
+    p.tasks.clear();
+}
+
+void StartupTimer::mark(const QString &phase)
+{
+    StartupPhases &p = phases();
+    QMutexLocker lk(&p.mutex);
+    if (!p.timer.isValid() || p.reported) {
+        return;
+    }
+    qint64 now = p.timer.elapsed();
+    p.phases.append({phase, now - p.lastMark});
+    p.lastMark = now;
+}
+
+void StartupTimer::record(const QString &task, qint64 ms)
+{
+    StartupPhases &p = phases();
+    QMutexLocker lk(&p.mutex);
+    if (!p.timer.isValid() || p.reported) {
+        return;
+    }
+    p.tasks.append({task, ms});
+}
+
+void StartupTimer::report()
+{
+    StartupPhases &p = phases();
+    QMutexLocker lk(&p.mutex);
+    if (!p.timer.isValid() || p.reported) {
+        return;
+    }
+    p.reported = true;
+    QStringList details;
+    for (const auto &phase : qAsConst(p.phases)) {
+        details << QStringLiteral("%1: %2 ms").arg(phase.first).arg(phase.second);
+    }
+    QStringList tasks;
+    for (const auto &task : qAsConst(p.tasks)) {
+        tasks << QStringLiteral("%1: %2 ms").arg(task.first).arg(task.second);
+    }
+    if (!tasks.isEmpty()) {
+        details << QStringLiteral("(%1)").arg(tasks.join(QStringLiteral(", ")));
+    }
+    qCInfo(KDENLIVE_LOG).noquote() << "Startup took" << p.timer.elapsed() << "ms -" << details.join(QStringLiteral(", "));
+}
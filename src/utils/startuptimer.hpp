@@ -0,0 +1,50 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QString>
+
+/** @brief This class measures the duration of the application startup phases.
+    Each call to mark() closes a phase, whose duration is the time elapsed since the previous mark.
+    The report is logged once the main window is shown, so that startup regressions are easy to spot.
+ */
+
+class StartupTimer
+{
+
+public:
+    /* @brief Start measuring, called first thing in main() */
+    static void start();
+
+    /* @brief Record the end of a startup phase
+       @param phase is the name of the phase that just ended
+    */
+    static void mark(const QString &phase);
+
+    /* @brief Record the duration of a task that is part of the current phase, it is reported separately
+       @param task is the name of the task
+       @param ms is the time it took
+    */
+    static void record(const QString &task, qint64 ms);
+
+    /* @brief Log the duration of all recorded phases. Phases marked afterwards are ignored */
+    static void report();
+};
@@ -24,8 +24,13 @@
 #include "bin/projectitemmodel.h"
 #include "core.h"
 #include "doc/kdenlivedoc.h"
+#include "kdenlivesettings.h"
+#include "thumbnailstrip.hpp"
 #include <QDir>
+#include <QHash>
 #include <QMutexLocker>
+#include <iterator>
+#include <limits>
 #include <list>
 
 std::unique_ptr<ThumbnailCache> ThumbnailCache::instance;
@@ -34,69 +39,144 @@ std::once_flag ThumbnailCache::m_onceFlag;
 class ThumbnailCache::Cache_t
 {
 public:
-    Cache_t(int maxCost)
-        : m_maxCost(maxCost)
+    bool contains(const QString &key, bool exactOnly = false) const
     {
+        auto found = m_cache.find(key);
+        return found != m_cache.end() && !(exactOnly && found->second->approximate);
     }
 
-    bool contains(const QString &key) const { return m_cache.count(key) > 0; }
+    bool isApproximate(const QString &key) const
+    {
+        auto found = m_cache.find(key);
+        return found != m_cache.end() && found->second->approximate;
+    }
 
-    void remove(const QString &key)
+    // Returns the memory freed
+    qint64 remove(const QString &key)
     {
-        if (!contains(key)) {
-            return;
+        auto found = m_cache.find(key);
+        if (found == m_cache.end()) {
+            return 0;
+        }
+        auto it = found->second;
+        auto clip = m_clipKeys.find(it->binId);
+        if (clip != m_clipKeys.end()) {
+            clip->second.erase(it->pos);
+            if (clip->second.empty()) {
+                m_clipKeys.erase(clip);
+            }
         }
-        auto it = m_cache.at(key);
-        m_currentCost -= (*it).second.second;
+        qint64 cost = it->cost;
+        m_currentCost -= cost;
+        m_cache.erase(found);
         m_data.erase(it);
-        m_cache.erase(key);
+        return cost;
     }
 
-    void insert(const QString &key, const QImage &img, int cost)
+    // Returns the memory used by the new entry, minus the one of the entry it replaces
+    qint64 insert(const QString &key, const QString &binId, int pos, const QImage &img, bool approximate, quint64 stamp)
     {
-        if (cost > m_maxCost) {
-            return;
-        }
-        m_data.push_front({key, {img, cost}});
-        auto it = m_data.begin();
-        m_cache[key] = it;
+        qint64 freed = remove(key);
+        qint64 cost = img.sizeInBytes();
+        m_data.push_front({key, binId, pos, img, approximate, cost, stamp});
+        m_cache[key] = m_data.begin();
+        m_clipKeys[binId][pos] = key;
         m_currentCost += cost;
-        while (m_currentCost > m_maxCost) {
-            remove(m_data.back().first);
-        }
+        return cost - freed;
     }
 
-    QImage get(const QString &key)
+    QImage get(const QString &key, quint64 stamp)
     {
-        if (!contains(key)) {
+        auto found = m_cache.find(key);
+        if (found == m_cache.end()) {
             return QImage();
         }
         // when a get operation occurs, we put the corresponding list item in front to remember last access
-        std::pair<QString, std::pair<QImage, int>> data;
-        auto it = m_cache.at(key);
-        std::swap(data, (*it));                                         // take data out without copy
-        QImage result = data.second.first;                              // a copy occurs here
-        m_data.erase(it);                                               // delete old iterator
-        m_cache[key] = m_data.emplace(m_data.begin(), std::move(data)); // reinsert without copy and store iterator
-        return result;
-    }
-    void clear()
+        m_data.splice(m_data.begin(), m_data, found->second);
+        found->second->stamp = stamp;
+        return found->second->image;
+    }
+
+    // Same as get, without changing the access order
+    QImage peek(const QString &key) const
+    {
+        auto found = m_cache.find(key);
+        return found == m_cache.end() ? QImage() : found->second->image;
+    }
+
+    // Removes all the thumbnails of a clip, returns the memory freed
+    qint64 removeClip(const QString &binId)
+    {
+        auto clip = m_clipKeys.find(binId);
+        if (clip == m_clipKeys.end()) {
+            return 0;
+        }
+        QStringList keys;
+        for (const auto &entry : clip->second) {
+            keys << entry.second;
+        }
+        qint64 freed = 0;
+        for (const QString &key : qAsConst(keys)) {
+            freed += remove(key);
+        }
+        return freed;
+    }
+
+    // Removes the least recently used thumbnail, returns the memory freed
+    qint64 removeOldest()
+    {
+        const QString key = m_data.back().key;
+        return remove(key);
+    }
+
+    bool isEmpty() const { return m_data.empty(); }
+
+    quint64 oldestStamp() const { return m_data.empty() ? std::numeric_limits<quint64>::max() : m_data.back().stamp; }
+
+    int count() const { return int(m_cache.size()); }
+
+    qint64 cost() const { return m_currentCost; }
+
+    // Returns the memory freed
+    qint64 clear()
     {
+        qint64 freed = m_currentCost;
         m_data.clear();
         m_cache.clear();
+        m_clipKeys.clear();
         m_currentCost = 0;
+        return freed;
     }
 
 protected:
-    int m_maxCost;
-    int m_currentCost{0};
+    struct Entry
+    {
+        QString key;
+        QString binId;
+        int pos;
+        QImage image;
+        bool approximate;
+        qint64 cost;
+        quint64 stamp;
+    };
+    qint64 m_currentCost{0};
 
-    std::list<std::pair<QString, std::pair<QImage, int>>> m_data; // the data is stored as (key,(image, cost))
+    std::list<Entry> m_data; // most recently used first
     std::unordered_map<QString, decltype(m_data.begin())> m_cache;
+    // keys of the thumbnails stored for each clip, by position
+    std::unordered_map<QString, std::unordered_map<int, QString>> m_clipKeys;
 };
 
+ThumbnailCache::Shard::Shard()
+    : volatileCache(new Cache_t())
+    , oldestStamp(std::numeric_limits<quint64>::max())
+{
+}
+
+ThumbnailCache::Shard::~Shard() = default;
+
 ThumbnailCache::ThumbnailCache()
-    : m_volatileCache(new Cache_t(10000000))
+    : m_memoryBudget(qint64(qMax(1, KdenliveSettings::thumbnailcachesize())) * 1024 * 1024)
 {
 }
 
@@ -106,43 +186,129 @@ std::unique_ptr<ThumbnailCache> &ThumbnailCache::get()
     return instance;
 }
 
-bool ThumbnailCache::hasThumbnail(const QString &binId, int pos, bool volatileOnly) const
+ThumbnailCache::Shard &ThumbnailCache::shard(const QString &binId) const
+{
+    return m_shards[qHash(binId) % ShardCount];
+}
+
+void ThumbnailCache::insertVolatile(Shard &s, const QString &key, const QString &binId, int pos, const QImage &img, bool approximate)
+{
+    if (img.sizeInBytes() > m_memoryBudget) {
+        return;
+    }
+    m_memoryUsed += s.volatileCache->insert(key, binId, pos, img, approximate, ++m_accessStamp);
+    s.oldestStamp = s.volatileCache->oldestStamp();
+}
+
+void ThumbnailCache::trim()
+{
+    while (m_memoryUsed > m_memoryBudget) {
+        // Find the shard holding the least recently used thumbnail
+        int selected = -1;
+        quint64 oldest = std::numeric_limits<quint64>::max();
+        for (int i = 0; i < ShardCount; i++) {
+            quint64 stamp = m_shards[i].oldestStamp;
+            if (stamp < oldest) {
+                oldest = stamp;
+                selected = i;
+            }
+        }
+        if (selected < 0) {
+            break;
+        }
+        Shard &s = m_shards[selected];
+        QMutexLocker locker(&s.mutex);
+        if (!s.volatileCache->isEmpty()) {
+            m_memoryUsed -= s.volatileCache->removeOldest();
+            m_evictions++;
+        }
+        s.oldestStamp = s.volatileCache->oldestStamp();
+    }
+}
+
+void ThumbnailCache::setMemoryBudget(qint64 bytes)
+{
+    m_memoryBudget = bytes;
+    trim();
+}
+
+ThumbnailCache::Statistics ThumbnailCache::statistics() const
+{
+    Statistics stats{m_hits, m_diskHits, m_misses, m_evictions, 0, m_memoryBudget, 0};
+    for (const Shard &s : m_shards) {
+        QMutexLocker locker(&s.mutex);
+        stats.memoryUsed += s.volatileCache->cost();
+        stats.count += s.volatileCache->count();
+    }
+    return stats;
+}
+
+bool ThumbnailCache::hasThumbnail(const QString &binId, int pos, bool volatileOnly, bool exactOnly) const
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
-    auto key = pos < 0 ? getAudioKey(binId, &ok).first() : getKey(binId, pos, &ok);
-    if (ok && m_volatileCache->contains(key)) {
-        return true;
+    const QString hash = pos < 0 ? QString() : getHash(binId, &ok);
+    auto key = pos < 0 ? getAudioKey(binId, &ok).first() : getKey(hash, pos);
+    if (!ok) {
+        return false;
     }
-    if (!ok || volatileOnly) {
+    Shard &s = shard(binId);
+    {
+        QMutexLocker locker(&s.mutex);
+        if (s.volatileCache->contains(key, exactOnly)) {
+            return true;
+        }
+    }
+    if (volatileOnly) {
         return false;
     }
+    if (pos >= 0) {
+        auto thumbs = strip(hash);
+        if (thumbs && thumbs->contains(pos, exactOnly)) {
+            return true;
+        }
+    }
+    // Audio thumbnails, or video thumbnails stored by an older version
     QDir thumbFolder = getDir(pos < 0, &ok);
     return ok && thumbFolder.exists(key);
 }
 
 QImage ThumbnailCache::getAudioThumbnail(const QString &binId, bool volatileOnly) const
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
     auto key = getAudioKey(binId, &ok).first();
-    if (ok && m_volatileCache->contains(key)) {
-        return m_volatileCache->get(key);
+    if (!ok) {
+        m_misses++;
+        return QImage();
+    }
+    Shard &s = shard(binId);
+    {
+        QMutexLocker locker(&s.mutex);
+        if (s.volatileCache->contains(key)) {
+            m_hits++;
+            QImage result = s.volatileCache->get(key, ++m_accessStamp);
+            s.oldestStamp = s.volatileCache->oldestStamp();
+            return result;
+        }
     }
-    if (!ok || volatileOnly) {
+    if (volatileOnly) {
+        m_misses++;
         return QImage();
     }
     QDir thumbFolder = getDir(true, &ok);
     if (ok && thumbFolder.exists(key)) {
-        m_storedOnDisk[binId].push_back(-1);
+        m_diskHits++;
+        {
+            QMutexLocker locker(&s.mutex);
+            s.storedOnDisk[binId].insert(-1);
+        }
         return QImage(thumbFolder.absoluteFilePath(key));
     }
+    m_misses++;
     return QImage();
 }
 
 const QList <QUrl> ThumbnailCache::getAudioThumbPath(const QString &binId) const
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
     auto key = getAudioKey(binId, &ok);
     QDir thumbFolder = getDir(true, &ok);
@@ -157,122 +323,211 @@ const QList <QUrl> ThumbnailCache::getAudioThumbPath(const QString &binId) const
     return pathList;
 }
 
-QImage ThumbnailCache::getThumbnail(const QString &binId, int pos, bool volatileOnly) const
+QImage ThumbnailCache::getThumbnail(const QString &binId, int pos, bool volatileOnly, bool exactOnly) const
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
-    auto key = getKey(binId, pos, &ok);
-    if (ok && m_volatileCache->contains(key)) {
-        return m_volatileCache->get(key);
+    const QString hash = getHash(binId, &ok);
+    if (!ok) {
+        m_misses++;
+        return QImage();
     }
-    if (!ok || volatileOnly) {
+    const QString key = getKey(hash, pos);
+    Shard &s = shard(binId);
+    {
+        QMutexLocker locker(&s.mutex);
+        if (s.volatileCache->contains(key, exactOnly)) {
+            m_hits++;
+            QImage result = s.volatileCache->get(key, ++m_accessStamp);
+            s.oldestStamp = s.volatileCache->oldestStamp();
+            return result;
+        }
+    }
+    if (volatileOnly) {
+        m_misses++;
         return QImage();
     }
-    QDir thumbFolder = getDir(false, &ok);
-    if (ok && thumbFolder.exists(key)) {
-        m_storedOnDisk[binId].push_back(pos);
-        return QImage(thumbFolder.absoluteFilePath(key));
+    QImage result;
+    if (auto thumbs = strip(hash)) {
+        result = thumbs->image(pos, exactOnly);
     }
-    return QImage();
+    if (result.isNull()) {
+        result = migrateLegacyThumbnail(key, hash, pos);
+    }
+    if (result.isNull()) {
+        m_misses++;
+    } else {
+        m_diskHits++;
+    }
+    return result;
 }
 
-void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage &img, bool persistent)
+void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage &img, bool persistent, bool approximate)
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
-    const QString key = getKey(binId, pos, &ok);
+    const QString hash = getHash(binId, &ok);
     if (!ok) {
         return;
     }
+    const QString key = getKey(hash, pos);
+    Shard &s = shard(binId);
     if (persistent) {
-        QDir thumbFolder = getDir(false, &ok);
-        if (ok) {
-            if (!img.save(thumbFolder.absoluteFilePath(key))) {
-                qDebug() << ".............\n!!!!!!!! ERROR SAVING THUMB in: "<<thumbFolder.absoluteFilePath(key);
-            }
-            m_storedOnDisk[binId].push_back(pos);
-            // if volatile cache also contains this entry, update it
-            if (m_volatileCache->contains(key)) {
-                m_volatileCache->remove(key);
-            } else {
-                m_storedVolatile[binId].push_back(pos);
-            }
-            m_volatileCache->insert(key, img, (int)img.sizeInBytes());
+        auto thumbs = strip(hash);
+        if (!thumbs) {
+            return;
+        }
+        if (!thumbs->append(pos, img, approximate)) {
+            qDebug() << ".............\n!!!!!!!! ERROR SAVING THUMB for: " << key;
         }
+        QMutexLocker locker(&s.mutex);
+        // if volatile cache also contains this entry, it is replaced
+        insertVolatile(s, key, binId, pos, img, approximate);
     } else {
-        m_volatileCache->insert(key, img, (int)img.sizeInBytes());
-        m_storedVolatile[binId].push_back(pos);
+        QMutexLocker locker(&s.mutex);
+        insertVolatile(s, key, binId, pos, img, approximate);
     }
+    trim();
 }
 
 void ThumbnailCache::saveCachedThumbs(QStringList keys)
 {
-    bool ok;
-    QDir thumbFolder = getDir(false, &ok);
-    if (!ok) {
-        return;
-    }
-    for (const QString &key : keys) {
-        if (!thumbFolder.exists(key) && m_volatileCache->contains(key)) {
-            QImage img = m_volatileCache->get(key);
-            if (!img.save(thumbFolder.absoluteFilePath(key))) {
-                qDebug() << "// Error writing thumbnails to " << thumbFolder.absolutePath();
-                break;
+    // Keys don't tell which clip they belong to, so look in all shards
+    struct CachedThumb
+    {
+        QString key;
+        QImage image;
+        bool approximate;
+    };
+    QList<CachedThumb> images;
+    for (Shard &s : m_shards) {
+        QMutexLocker locker(&s.mutex);
+        for (const QString &key : qAsConst(keys)) {
+            if (s.volatileCache->contains(key)) {
+                images.append({key, s.volatileCache->peek(key), s.volatileCache->isApproximate(key)});
             }
         }
     }
+    for (const auto &image : qAsConst(images)) {
+        // Keys are built as hash#pos.png
+        const QString hash = image.key.section(QLatin1Char('#'), 0, 0);
+        bool ok = false;
+        int pos = image.key.section(QLatin1Char('#'), 1).section(QLatin1Char('.'), 0, 0).toInt(&ok);
+        if (!ok) {
+            continue;
+        }
+        auto thumbs = strip(hash);
+        if (!thumbs) {
+            return;
+        }
+        if (!thumbs->contains(pos, !image.approximate) && !thumbs->append(pos, image.image, image.approximate)) {
+            qDebug() << "// Error writing thumbnails for " << hash;
+            break;
+        }
+    }
 }
 
 void ThumbnailCache::invalidateThumbsForClip(const QString &binId, bool reloadAudio)
 {
-    QMutexLocker locker(&m_mutex);
-    if (m_storedVolatile.find(binId) != m_storedVolatile.end()) {
-        bool ok = false;
-        for (int pos : m_storedVolatile.at(binId)) {
-            auto key = getKey(binId, pos, &ok);
-            if (ok) {
-                m_volatileCache->remove(key);
-            }
+    std::unordered_set<int> storedOnDisk;
+    Shard &s = shard(binId);
+    {
+        QMutexLocker locker(&s.mutex);
+        m_memoryUsed -= s.volatileCache->removeClip(binId);
+        s.oldestStamp = s.volatileCache->oldestStamp();
+        auto stored = s.storedOnDisk.find(binId);
+        if (stored != s.storedOnDisk.end()) {
+            storedOnDisk = std::move(stored->second);
+            s.storedOnDisk.erase(stored);
         }
-        m_storedVolatile.erase(binId);
     }
     bool ok = false;
     // Video thumbs
-    QDir thumbFolder = getDir(false, &ok);
+    const QString hash = getHash(binId, &ok);
+    if (ok) {
+        if (auto thumbs = strip(hash)) {
+            thumbs->invalidate();
+        }
+        // Thumbnails stored by an older version
+        QDir thumbFolder = getDir(false, &ok);
+        if (ok) {
+            const QStringList legacy = thumbFolder.entryList({hash + QStringLiteral("#*.png")}, QDir::Files);
+            for (const QString &file : legacy) {
+                QFile::remove(thumbFolder.absoluteFilePath(file));
+            }
+        }
+    }
     QDir audioThumbFolder = getDir(true, &ok);
-    if (ok && m_storedOnDisk.find(binId) != m_storedOnDisk.end()) {
+    if (ok && reloadAudio && storedOnDisk.count(-1) > 0) {
         // Remove persistent cache
-        for (int pos : m_storedOnDisk.at(binId)) {
-            if (pos < 0) {
-                if (reloadAudio) {
-                    auto key = getAudioKey(binId, &ok);
-                    if (ok) {
-                        for (const QString &p : key) {
-                            QFile::remove(audioThumbFolder.absoluteFilePath(p));
-                        }
-                    }
-                }
-            } else {
-                auto key = getKey(binId, pos, &ok);
-                if (ok) {
-                    QFile::remove(thumbFolder.absoluteFilePath(key));
-                }
+        auto key = getAudioKey(binId, &ok);
+        if (ok) {
+            for (const QString &p : key) {
+                QFile::remove(audioThumbFolder.absoluteFilePath(p));
             }
         }
-        m_storedOnDisk.erase(binId);
     }
 }
 
 void ThumbnailCache::clearCache()
 {
-    QMutexLocker locker(&m_mutex);
-    m_volatileCache->clear();
-    m_storedVolatile.clear();
-    m_storedOnDisk.clear();
+    for (Shard &s : m_shards) {
+        QMutexLocker locker(&s.mutex);
+        m_memoryUsed -= s.volatileCache->clear();
+        s.storedOnDisk.clear();
+        s.oldestStamp = s.volatileCache->oldestStamp();
+    }
+    // The strips of the next project live in another folder
+    QMutexLocker locker(&m_stripsMutex);
+    m_strips.clear();
+    m_stripsByPath.clear();
+}
+
+std::shared_ptr<ThumbnailStrip> ThumbnailCache::strip(const QString &hash) const
+{
+    bool ok = false;
+    QDir thumbFolder = getDir(false, &ok);
+    if (!ok) {
+        return nullptr;
+    }
+    const QString path = thumbFolder.absoluteFilePath(hash + QStringLiteral(".thumbs"));
+    QMutexLocker locker(&m_stripsMutex);
+    auto found = m_stripsByPath.find(path);
+    if (found != m_stripsByPath.end()) {
+        m_strips.splice(m_strips.begin(), m_strips, found->second);
+        return found->second->second;
+    }
+    m_strips.push_front({path, std::make_shared<ThumbnailStrip>(path)});
+    m_stripsByPath[path] = m_strips.begin();
+    if ((int)m_strips.size() > MaxOpenStrips) {
+        // Close the least recently used file that is not being accessed, so that a file never has two writers
+        for (auto it = std::prev(m_strips.end()); it != m_strips.begin(); --it) {
+            if (it->second.use_count() == 1) {
+                m_stripsByPath.erase(it->first);
+                m_strips.erase(it);
+                break;
+            }
+        }
+    }
+    return m_strips.front().second;
+}
+
+QImage ThumbnailCache::migrateLegacyThumbnail(const QString &key, const QString &hash, int pos) const
+{
+    bool ok = false;
+    QDir thumbFolder = getDir(false, &ok);
+    if (!ok || !thumbFolder.exists(key)) {
+        return QImage();
+    }
+    const QString path = thumbFolder.absoluteFilePath(key);
+    QImage img(path);
+    auto thumbs = strip(hash);
+    if (!img.isNull() && thumbs && thumbs->append(pos, img)) {
+        QFile::remove(path);
+    }
+    return img;
 }
 
 // static
-QString ThumbnailCache::getKey(const QString &binId, int pos, bool *ok)
+QString ThumbnailCache::getHash(const QString &binId, bool *ok)
 {
     if (binId.isEmpty()) {
         *ok = false;
@@ -280,7 +535,13 @@ QString ThumbnailCache::getKey(const QString &binId, int pos, bool *ok)
     }
     auto binClip = pCore->projectItemModel()->getClipByBinID(binId);
     *ok = binClip != nullptr;
-    return *ok ? binClip->hash() + QLatin1Char('#') + QString::number(pos) + QStringLiteral(".png") : QString();
+    return *ok ? binClip->hash() : QString();
+}
+
+// static
+QString ThumbnailCache::getKey(const QString &hash, int pos)
+{
+    return hash + QLatin1Char('#') + QString::number(pos) + QStringLiteral(".png");
 }
 
 // static
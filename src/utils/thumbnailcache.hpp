@@ -26,17 +26,30 @@
 #include <QUrl>
 #include <QImage>
 #include <QMutex>
+#include <array>
+#include <atomic>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+class ThumbnailStrip;
+
 /** @brief This class class is an interface to the caches that store thumbnails.
     In Kdenlive, we use two such caches, a persistent that is stored on disk to allow thumbnails to be reused when reopening.
+    The persistent cache stores the video thumbnails of each clip in a single ThumbnailStrip file. Thumbnails stored by older versions
+    as one PNG file per frame are moved to the strip when they are first read.
+    Thumbnails can be approximate: extracted in fast mode from a keyframe close to the requested frame. They are returned for normal
+    queries, and ignored by queries asking for the exact frame, which then replace them.
     The other one is a volatile LRU cache that lives in memory.
     Note that for the volatile cache uses a custom implementation.
     QCache is not suitable since it operates on pointers and since the object is removed from the cache when accessed.
     KImageCache is not suitable since it lacks a way to remove objects from the cache.
+    The volatile cache is split in shards selected by the clip's bin id, each one with its own lock, so that
+    threads loading thumbnails of different clips don't contend. All shards share one memory budget: when it is exceeded,
+    the least recently used thumbnail of all shards is dropped.
  * Note that this class is a Singleton
  */
 
@@ -51,15 +64,17 @@ public:
        @param binId is the id of the queried clip
        @param pos is the position where we query
        @param volatileOnly if true, we only check the volatile cache (no disk access)
+       @param exactOnly if true, approximate thumbnails are ignored
      */
-    bool hasThumbnail(const QString &binId, int pos, bool volatileOnly = false) const;
+    bool hasThumbnail(const QString &binId, int pos, bool volatileOnly = false, bool exactOnly = false) const;
 
     /* @brief Get a given thumbnail from the cache
        @param binId is the id of the queried clip
        @param pos is the position where we query
        @param volatileOnly if true, we only check the volatile cache (no disk access)
+       @param exactOnly if true, approximate thumbnails are ignored
     */
-    QImage getThumbnail(const QString &binId, int pos, bool volatileOnly = false) const;
+    QImage getThumbnail(const QString &binId, int pos, bool volatileOnly = false, bool exactOnly = false) const;
     QImage getAudioThumbnail(const QString &binId, bool volatileOnly = false) const;
     const QList <QUrl> getAudioThumbPath(const QString &binId) const;
 
@@ -67,8 +82,9 @@ public:
        @param binId is the id of the queried clip
        @param pos is the position where we query
        @param persistent if true, we store the image in the persistent cache, which generates a disk access
+       @param approximate is true if the image was extracted from a keyframe close to pos (see ThumbnailProducerPool::acquire)
     */
-    void storeThumbnail(const QString &binId, int pos, const QImage &img, bool persistent = false);
+    void storeThumbnail(const QString &binId, int pos, const QImage &img, bool persistent = false, bool approximate = false);
 
     /* @brief Removes all the thumbnails for a given clip */
     void invalidateThumbsForClip(const QString &binId, bool reloadAudio);
@@ -79,12 +95,31 @@ public:
     /* @brief Reset cache (discarding all thumbs stored in memory) */
     void clearCache();
 
+    /* @brief Set the maximum memory used by the volatile cache, in bytes. Thumbnails are dropped if needed.
+       Called when the thumbnailcachesize setting changes */
+    void setMemoryBudget(qint64 bytes);
+
+    struct Statistics
+    {
+        quint64 hits;      // thumbnails found in memory
+        quint64 diskHits;  // thumbnails loaded from the persistent cache
+        quint64 misses;    // thumbnails not found
+        quint64 evictions; // thumbnails dropped from memory to respect the budget
+        qint64 memoryUsed;
+        qint64 memoryBudget;
+        int count; // number of thumbnails in memory
+    };
+    /* @brief Returns the usage counters of the cache, for diagnostics */
+    Statistics statistics() const;
+
 protected:
     // Constructor is protected because class is a Singleton
     ThumbnailCache();
 
-    // Return the key associated to a thumbnail
-    static QString getKey(const QString &binId, int pos, bool *ok);
+    // Return the hash of a clip, which identifies its thumbnails
+    static QString getHash(const QString &binId, bool *ok);
+    // Return the key associated to a thumbnail. This is also the file name used by older versions to store it
+    static QString getKey(const QString &hash, int pos);
     static QStringList getAudioKey(const QString &binId, bool *ok);
 
     // Return the dir where the persistent cache lives
@@ -94,11 +129,42 @@ protected:
     static std::once_flag m_onceFlag; // flag to create the repository only once;
 
     class Cache_t;
-    std::unique_ptr<Cache_t> m_volatileCache;
-    mutable QMutex m_mutex;
-
-    // the following maps keeps track of the positions that we store for each clip in volatile caches.
-    // Note that we don't track deletions due to items dropped from the cache. So the maps can contain more items that are currently stored.
-    std::unordered_map<QString, std::vector<int>> m_storedVolatile;
-    mutable std::unordered_map<QString, std::vector<int>> m_storedOnDisk;
+    struct Shard
+    {
+        Shard();
+        ~Shard();
+        mutable QMutex mutex;
+        std::unique_ptr<Cache_t> volatileCache;
+        // keeps track of the clips whose audio thumbnail is in the persistent cache (position -1)
+        std::unordered_map<QString, std::unordered_set<int>> storedOnDisk;
+        // access stamp of the least recently used thumbnail of this shard, used to select the shard to evict from
+        std::atomic<quint64> oldestStamp;
+    };
+    static const int ShardCount = 16;
+    mutable std::array<Shard, ShardCount> m_shards;
+    Shard &shard(const QString &binId) const;
+    // Store the thumbnail in the shard's volatile cache, the shard must be locked
+    void insertVolatile(Shard &s, const QString &key, const QString &binId, int pos, const QImage &img, bool approximate);
+    // Drop least recently used thumbnails until the budget is respected. No shard must be locked by the caller
+    void trim();
+
+    /* @brief Returns the thumbnail file of the clip with given hash
+       Returns a null pointer if the project has no thumbnail folder
+    */
+    std::shared_ptr<ThumbnailStrip> strip(const QString &hash) const;
+    // Load a thumbnail stored by an older version, and move it to the clip's strip
+    QImage migrateLegacyThumbnail(const QString &key, const QString &hash, int pos) const;
+    // Keep a limited number of strip files open
+    static const int MaxOpenStrips = 64;
+    mutable QMutex m_stripsMutex;
+    mutable std::list<std::pair<QString, std::shared_ptr<ThumbnailStrip>>> m_strips; // most recently used first
+    mutable std::unordered_map<QString, decltype(m_strips.begin())> m_stripsByPath;
+
+    std::atomic<qint64> m_memoryBudget;
+    std::atomic<qint64> m_memoryUsed{0};
+    mutable std::atomic<quint64> m_accessStamp{0};
+    mutable std::atomic<quint64> m_hits{0};
+    mutable std::atomic<quint64> m_diskHits{0};
+    mutable std::atomic<quint64> m_misses{0};
+    std::atomic<quint64> m_evictions{0};
 };
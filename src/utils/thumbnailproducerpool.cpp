@@ -0,0 +1,119 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "thumbnailproducerpool.hpp"
+#include "bin/projectclip.h"
+#include <QMutexLocker>
+#include <mlt++/MltProducer.h>
+
+std::unique_ptr<ThumbnailProducerPool> ThumbnailProducerPool::instance;
+std::once_flag ThumbnailProducerPool::m_onceFlag;
+
+std::unique_ptr<ThumbnailProducerPool> &ThumbnailProducerPool::get()
+{
+    std::call_once(m_onceFlag, [] { instance.reset(new ThumbnailProducerPool()); });
+    return instance;
+}
+
+std::shared_ptr<Mlt::Producer> ThumbnailProducerPool::acquire(const std::shared_ptr<ProjectClip> &clip, int frame, bool fast)
+{
+    const QString binId = clip->clipId();
+    QMutexLocker locker(&m_mutex);
+    while (true) {
+        // Prefer the producer that stopped right before the requested frame, then the closest one
+        auto best = m_idle.end();
+        int bestDistance = 0;
+        for (auto it = m_idle.begin(); it != m_idle.end(); ++it) {
+            if (it->binId != binId || it->fast != fast) {
+                continue;
+            }
+            int distance = frame >= it->frame ? frame - it->frame : 2 * (it->frame - frame);
+            if (best == m_idle.end() || distance < bestDistance) {
+                best = it;
+                bestDistance = distance;
+            }
+        }
+        ClipInfo &info = m_clips[binId];
+        if (best != m_idle.end()) {
+            std::shared_ptr<Mlt::Producer> producer = best->producer;
+            m_idle.erase(best);
+            info.busy++;
+            m_leased[producer.get()] = {info.generation, fast};
+            return producer;
+        }
+        if (info.busy < MaxProducersPerClip) {
+            break;
+        }
+        m_released.wait(&m_mutex);
+    }
+    // Create a new producer, without blocking the other clips
+    ClipInfo &info = m_clips[binId];
+    info.busy++;
+    int generation = info.generation;
+    locker.unlock();
+    std::shared_ptr<Mlt::Producer> producer = clip->createThumbProducer(fast);
+    locker.relock();
+    if (!producer || !producer->is_valid()) {
+        m_clips[binId].busy--;
+        m_released.wakeAll();
+        return nullptr;
+    }
+    m_leased[producer.get()] = {generation, fast};
+    return producer;
+}
+
+void ThumbnailProducerPool::release(const QString &binId, const std::shared_ptr<Mlt::Producer> &producer, int frame)
+{
+    if (!producer) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    auto leased = m_leased.find(producer.get());
+    int generation = -1;
+    bool fast = false;
+    if (leased != m_leased.end()) {
+        generation = leased->second.generation;
+        fast = leased->second.fast;
+        m_leased.erase(leased);
+    }
+    ClipInfo &info = m_clips[binId];
+    info.busy = qMax(0, info.busy - 1);
+    if (generation == info.generation) {
+        m_idle.push_front({binId, producer, frame, fast});
+        while (m_idle.size() > MaxIdleProducers) {
+            m_idle.pop_back();
+        }
+    }
+    m_released.wakeAll();
+}
+
+void ThumbnailProducerPool::invalidateClip(const QString &binId)
+{
+    QMutexLocker locker(&m_mutex);
+    auto info = m_clips.find(binId);
+    if (info != m_clips.end()) {
+        info->second.generation++;
+        if (info->second.busy == 0) {
+            m_clips.erase(info);
+        }
+    }
+    m_idle.remove_if([&binId](const IdleProducer &idle) { return idle.binId == binId; });
+    m_released.wakeAll();
+}
@@ -0,0 +1,105 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#pragma once
+
+#include "definitions.h"
+#include <QMutex>
+#include <QWaitCondition>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+class ProjectClip;
+namespace Mlt {
+class Producer;
+}
+
+/** @brief This class keeps a bounded set of thumbnail producers for each clip, so that thumbnails of one clip
+    can be extracted concurrently instead of seeking a single shared decoder back and forth.
+    Idle producers of all clips are kept in a LRU list, the least recently used one is closed when the list is full.
+ * Note that this class is a Singleton
+ */
+
+class ThumbnailProducerPool
+{
+
+public:
+    // Returns the instance of the Singleton
+    static std::unique_ptr<ThumbnailProducerPool> &get();
+
+    /* @brief Returns a thumbnail producer for the clip. If several are idle, we return the one whose last frame is the closest before
+       the requested one, so that decoding can continue forward. Blocks while all the producers allowed for the clip are in use,
+       so it must only be called from threads reserved for thumbnails (the thumbnail job lane, the timeline thumbnail provider).
+       The producer must be given back with release().
+       @param frame is the first frame that will be extracted
+       @param fast if true, the producer only decodes keyframes: the image of a frame is the one of the next keyframe
+    */
+    std::shared_ptr<Mlt::Producer> acquire(const std::shared_ptr<ProjectClip> &clip, int frame, bool fast = false);
+
+    /* @brief Gives back a producer obtained with acquire()
+       @param frame is the last frame extracted with this producer
+    */
+    void release(const QString &binId, const std::shared_ptr<Mlt::Producer> &producer, int frame);
+
+    /* @brief Close the producers of a clip, for example when its source changed. Producers in use are closed when released */
+    void invalidateClip(const QString &binId);
+
+    // Maximum number of producers used at the same time for one clip
+    static const int MaxProducersPerClip = 3;
+    // Maximum number of idle producers kept for all clips
+    static const int MaxIdleProducers = 12;
+
+protected:
+    // Constructor is protected because class is a Singleton
+    ThumbnailProducerPool() = default;
+
+    static std::unique_ptr<ThumbnailProducerPool> instance;
+    static std::once_flag m_onceFlag; // flag to create the pool only once;
+
+    struct IdleProducer
+    {
+        QString binId;
+        std::shared_ptr<Mlt::Producer> producer;
+        int frame;
+        bool fast;
+    };
+    struct ClipInfo
+    {
+        int busy = 0;
+        // Incremented when the clip is invalidated, producers created before are not reused
+        int generation = 0;
+    };
+
+    QMutex m_mutex;
+    QWaitCondition m_released;
+    // Idle producers, most recently used first
+    std::list<IdleProducer> m_idle;
+    std::unordered_map<QString, ClipInfo> m_clips;
+    struct Lease
+    {
+        // Generation of the clip when the producer was created
+        int generation;
+        bool fast;
+    };
+    // Producers in use
+    std::unordered_map<Mlt::Producer *, Lease> m_leased;
+};
@@ -0,0 +1,227 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "thumbnailstrip.hpp"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <cstring>
+#include <utility>
+
+namespace {
+const quint32 StripMagic = 0x4b544842; // "KTHB"
+const quint32 StripVersion = 2;
+const qint64 FileHeaderSize = 8;
+
+// Each record starts with: frame, width, height, image format, bytes per line, flags, compressed size (all 32 bits little endian)
+const int RecordFields = 7;
+const int SizeField = RecordFields - 1;
+const quint32 ApproximateFlag = 0x1;
+const qint64 RecordHeaderSize = RecordFields * 4;
+
+quint32 field(const uchar *record, int i)
+{
+    return qFromLittleEndian<quint32>(record + 4 * i);
+}
+} // namespace
+
+ThumbnailStrip::ThumbnailStrip(QString path)
+    : m_path(std::move(path))
+    , m_file(m_path)
+    , m_map(nullptr)
+    , m_mapSize(0)
+    , m_indexed(false)
+    , m_end(FileHeaderSize)
+{
+}
+
+ThumbnailStrip::~ThumbnailStrip()
+{
+    close();
+}
+
+void ThumbnailStrip::close()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_mapSize = 0;
+    m_file.close();
+    m_index.clear();
+    m_indexed = false;
+    m_end = FileHeaderSize;
+}
+
+bool ThumbnailStrip::map()
+{
+    qint64 size = m_file.size();
+    if (m_map && m_mapSize == size) {
+        return true;
+    }
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+        m_mapSize = 0;
+    }
+    if (size == 0) {
+        return false;
+    }
+    m_map = m_file.map(0, size);
+    if (m_map == nullptr) {
+        qDebug() << "// Cannot map thumbnail file" << m_path << m_file.errorString();
+        return false;
+    }
+    m_mapSize = size;
+    return true;
+}
+
+bool ThumbnailStrip::open(bool create)
+{
+    if (m_indexed) {
+        if (m_file.isOpen() || !create) {
+            return m_file.isOpen();
+        }
+    } else if (!create && !m_file.exists()) {
+        // Nothing stored yet, don't create the file for a lookup
+        m_indexed = true;
+        return false;
+    }
+    if (!m_file.isOpen() && !m_file.open(QIODevice::ReadWrite)) {
+        qDebug() << "// Cannot open thumbnail file" << m_path << m_file.errorString();
+        m_indexed = true;
+        return false;
+    }
+    m_index.clear();
+    m_end = FileHeaderSize;
+    m_indexed = true;
+    if (map() && m_mapSize >= FileHeaderSize && field(m_map, 0) == StripMagic && field(m_map, 1) == StripVersion) {
+        qint64 offset = FileHeaderSize;
+        while (offset + RecordHeaderSize <= m_mapSize) {
+            const uchar *record = m_map + offset;
+            qint64 next = offset + RecordHeaderSize + field(record, SizeField);
+            if (next > m_mapSize) {
+                break;
+            }
+            m_index[int(field(record, 0))] = {offset, (field(record, 5) & ApproximateFlag) != 0};
+            offset = next;
+        }
+        m_end = offset;
+        return true;
+    }
+    // New or unreadable file, start it again
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+        m_mapSize = 0;
+    }
+    uchar header[FileHeaderSize];
+    qToLittleEndian<quint32>(StripMagic, header);
+    qToLittleEndian<quint32>(StripVersion, header + 4);
+    if (!m_file.resize(0) || m_file.write(reinterpret_cast<const char *>(header), FileHeaderSize) != FileHeaderSize || !m_file.flush()) {
+        qDebug() << "// Cannot write thumbnail file" << m_path << m_file.errorString();
+        close();
+        m_indexed = true;
+        return false;
+    }
+    return true;
+}
+
+bool ThumbnailStrip::contains(int pos, bool exactOnly)
+{
+    QMutexLocker locker(&m_mutex);
+    open(false);
+    auto found = m_index.find(pos);
+    return found != m_index.end() && !(exactOnly && found->second.approximate);
+}
+
+QImage ThumbnailStrip::image(int pos, bool exactOnly)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!open(false)) {
+        return QImage();
+    }
+    auto found = m_index.find(pos);
+    if (found == m_index.end() || (exactOnly && found->second.approximate)) {
+        return QImage();
+    }
+    const qint64 offset = found->second.offset;
+    if (offset + RecordHeaderSize > m_mapSize && !map()) {
+        return QImage();
+    }
+    const uchar *record = m_map + offset;
+    const int width = int(field(record, 1));
+    const int height = int(field(record, 2));
+    const auto format = QImage::Format(field(record, 3));
+    const int bytesPerLine = int(field(record, 4));
+    const quint32 size = field(record, SizeField);
+    if (offset + RecordHeaderSize + size > m_mapSize && !map()) {
+        return QImage();
+    }
+    record = m_map + offset;
+    QByteArray pixels = qUncompress(record + RecordHeaderSize, int(size));
+    QImage img(width, height, format);
+    if (img.isNull() || pixels.size() != bytesPerLine * height || bytesPerLine < img.bytesPerLine()) {
+        qDebug() << "// Invalid thumbnail" << pos << "in" << m_path;
+        return QImage();
+    }
+    for (int y = 0; y < height; ++y) {
+        memcpy(img.scanLine(y), pixels.constData() + y * bytesPerLine, size_t(img.bytesPerLine()));
+    }
+    return img;
+}
+
+bool ThumbnailStrip::append(int pos, const QImage &img, bool approximate)
+{
+    if (img.isNull()) {
+        return false;
+    }
+    // Compress before locking, this is the expensive part
+    const QByteArray pixels = qCompress(img.constBits(), int(img.sizeInBytes()), 1);
+    uchar header[RecordHeaderSize];
+    const quint32 fields[RecordFields] = {quint32(pos), quint32(img.width()), quint32(img.height()), quint32(img.format()), quint32(img.bytesPerLine()),
+                                          approximate ? ApproximateFlag : 0, quint32(pixels.size())};
+    for (int i = 0; i < RecordFields; ++i) {
+        qToLittleEndian<quint32>(fields[i], header + 4 * i);
+    }
+    QMutexLocker locker(&m_mutex);
+    if (!open(true)) {
+        return false;
+    }
+    // Drop a possibly incomplete trailing record
+    if (m_file.size() != m_end && !m_file.resize(m_end)) {
+        return false;
+    }
+    if (!m_file.seek(m_end) || m_file.write(reinterpret_cast<const char *>(header), RecordHeaderSize) != RecordHeaderSize ||
+        m_file.write(pixels) != pixels.size() || !m_file.flush()) {
+        qDebug() << "// Cannot write thumbnail file" << m_path << m_file.errorString();
+        return false;
+    }
+    m_index[pos] = {m_end, approximate};
+    m_end += RecordHeaderSize + pixels.size();
+    return true;
+}
+
+void ThumbnailStrip::invalidate()
+{
+    QMutexLocker locker(&m_mutex);
+    close();
+    QFile::remove(m_path);
+}
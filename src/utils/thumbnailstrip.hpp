@@ -0,0 +1,86 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QFile>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <unordered_map>
+
+/** @brief This class is the persistent storage of the video thumbnails of one clip: a single file holding all the thumbnails,
+    instead of one image file per frame.
+    Thumbnails are appended to the file as zlib compressed raw pixels (which is much cheaper to write and read than PNG), each one
+    preceded by a small header giving its frame, size and whether it is approximate (extracted from a keyframe close to the frame).
+    The file is memory mapped for reading and the index of the thumbnails is built on the first access by walking the headers. An incomplete trailing record (for example after a crash) is ignored and
+    overwritten by the next append. If a frame is stored twice, the last record wins.
+    All methods are thread safe.
+ */
+
+class ThumbnailStrip
+{
+
+public:
+    explicit ThumbnailStrip(QString path);
+    ~ThumbnailStrip();
+
+    /* @brief Returns true if the thumbnail of given frame is stored
+       @param exactOnly if true, approximate thumbnails are ignored
+    */
+    bool contains(int pos, bool exactOnly = false);
+
+    /* @brief Returns the thumbnail of given frame, or a null image if it is not stored
+       @param exactOnly if true, approximate thumbnails are ignored
+    */
+    QImage image(int pos, bool exactOnly = false);
+
+    /* @brief Stores the thumbnail of given frame at the end of the file
+       @param approximate is true if the image was extracted from a keyframe close to the frame
+       @returns false if the file could not be written
+    */
+    bool append(int pos, const QImage &img, bool approximate = false);
+
+    /* @brief Removes all the thumbnails. The file is deleted, which is atomic for other readers of the cache folder */
+    void invalidate();
+
+protected:
+    // Builds the index if needed. The file is only created if create is true. The mutex must be locked
+    bool open(bool create);
+    // Maps the file up to its current end. The mutex must be locked
+    bool map();
+    void close();
+
+    const QString m_path;
+    QMutex m_mutex;
+    QFile m_file;
+    uchar *m_map;
+    qint64 m_mapSize;
+    bool m_indexed;
+    // end of the last complete record
+    qint64 m_end;
+    struct Record
+    {
+        qint64 offset;
+        bool approximate;
+    };
+    // record of each frame
+    std::unordered_map<int, Record> m_index;
+};
@@ -0,0 +1,109 @@
+#include "catch.hpp"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QVector>
+#include <cstdlib>
+
+#include "lib/audio/audioPeaks.h"
+
+TEST_CASE("Audio peak files", "[AudioPeaks]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("test_audio.peaks"));
+
+    // 100 frames at 25fps, 48kHz stereo. The first channel is a square wave of amplitude 16000 for 2 seconds, then 8000.
+    // The second channel has an amplitude of 4000. Only 150000 samples are streamed, the end of the clip is silent.
+    const int frequency = 48000;
+    const int channels = 2;
+    const int streamed = 150000;
+    AudioPeaksBuilder builder(channels, frequency, 25, 100);
+    REQUIRE(builder.isEmpty());
+    QVector<qint16> block;
+    for (int i = 0; i < streamed; i++) {
+        const int sign = i % 2 == 0 ? 1 : -1;
+        block << qint16(sign * (i < 96000 ? 16000 : 8000)) << qint16(sign * 4000);
+        // Odd block size, so that buckets span several blocks
+        if (block.size() == 2 * 999 || i == streamed - 1) {
+            builder.addSamples(block.constData(), block.size() / channels);
+            block.clear();
+        }
+    }
+    REQUIRE_FALSE(builder.isEmpty());
+    REQUIRE(builder.save(path));
+
+    AudioPeaks peaks;
+    REQUIRE(peaks.open(path));
+    REQUIRE(peaks.isValid());
+    REQUIRE(peaks.channels() == channels);
+    REQUIRE(peaks.frames() == 100);
+    REQUIRE(peaks.samplesPerFrame() == Approx(1920));
+    // Buckets of 128, 512, 2048, 8192, 32768 and 131072 samples
+    REQUIRE(peaks.levelCount() == 6);
+    REQUIRE(peaks.levelFor(100) == 0);
+    REQUIRE(peaks.levelFor(600) == 1);
+    REQUIRE(peaks.levelFor(1e9) == 5);
+
+    SECTION("Values are normalized with the loudest bucket of all channels")
+    {
+        AudioPeaks::Peak p = peaks.peak(0, 0, 0, 128);
+        REQUIRE(p.min == -127);
+        REQUIRE(p.max == 127);
+        REQUIRE(p.rms == 255);
+        p = peaks.peak(0, 0, 96000, 96128);
+        REQUIRE(p.min == -63);
+        REQUIRE(p.max == 63);
+        REQUIRE(p.rms == 127);
+        p = peaks.peak(0, 1, 0, 128);
+        REQUIRE(p.max == 31);
+        // Padding after the end of the stream
+        p = peaks.peak(0, 0, 160000, 192000);
+        REQUIRE(p.min == 0);
+        REQUIRE(p.max == 0);
+        REQUIRE(p.rms == 0);
+    }
+
+    SECTION("Coarser levels match the finest one")
+    {
+        double bucketSize = 128;
+        for (int level = 1; level < peaks.levelCount(); level++) {
+            bucketSize *= 4;
+            // One bucket of this level around the amplitude change
+            const double start = bucketSize * int(96000 / bucketSize);
+            const double end = start + bucketSize;
+            AudioPeaks::Peak coarse = peaks.peak(level, 0, start, end);
+            AudioPeaks::Peak fine = peaks.peak(0, 0, start, end);
+            REQUIRE(coarse.min == fine.min);
+            REQUIRE(coarse.max == fine.max);
+            REQUIRE(std::abs(int(coarse.rms) - int(fine.rms)) <= 1);
+        }
+        AudioPeaks::Peak all = peaks.peak(peaks.levelCount() - 1, 0, 0, 192000);
+        REQUIRE(all.min == -127);
+        REQUIRE(all.max == 127);
+    }
+
+    SECTION("Invalid files are rejected")
+    {
+        const QString invalidPath = dir.filePath(QStringLiteral("invalid_audio.peaks"));
+        QFile invalid(invalidPath);
+        REQUIRE(invalid.open(QIODevice::WriteOnly));
+        invalid.write(QByteArray(256, 'x'));
+        invalid.close();
+        AudioPeaks other;
+        REQUIRE_FALSE(other.open(invalidPath));
+        REQUIRE_FALSE(other.isValid());
+        // Opening another file releases the previous one
+        REQUIRE(other.open(path));
+        REQUIRE(other.levelCount() == 6);
+        REQUIRE_FALSE(other.open(invalidPath));
+        REQUIRE_FALSE(other.isValid());
+    }
+
+    SECTION("A file can be opened again")
+    {
+        REQUIRE(peaks.open(path));
+        REQUIRE(peaks.levelCount() == 6);
+        REQUIRE(peaks.peak(0, 0, 0, 128).max == 127);
+    }
+}
@@ -0,0 +1,41 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include "monitor/scopes/audiosamplequeue.h"
+
+TEST_CASE("Audio meter sums of squares", "[AudioSampleQueue]")
+{
+    // Odd sample counts leave a tail after the vectorized part
+    for (int channels : {1, 2, 3, 6, 8, 16, 20}) {
+        for (int samples : {1, 7, 1920, 2001}) {
+            AudioSampleQueue::Block block;
+            block.channels = channels;
+            block.samples = samples;
+            block.data.resize(size_t(channels * samples));
+            for (int i = 0; i < samples; ++i) {
+                for (int c = 0; c < channels; ++c) {
+                    // A different amplitude per channel, so that mixing up channels is detected
+                    block.data[size_t(i * channels + c)] = float(std::sin(i * 0.01 + c)) * float(c + 1) / float(channels + 1);
+                }
+            }
+            std::vector<double> sums;
+            AudioSampleQueue::sumSquares(block, sums);
+            REQUIRE(sums.size() == size_t(channels));
+            for (int c = 0; c < channels; ++c) {
+                double expected = 0;
+                for (int i = 0; i < samples; ++i) {
+                    const double value = block.data[size_t(i * channels + c)];
+                    expected += value * value;
+                }
+                REQUIRE(sums[size_t(c)] == Approx(expected).epsilon(1e-5));
+            }
+        }
+    }
+
+    AudioSampleQueue::Block empty;
+    std::vector<double> sums{1., 2.};
+    AudioSampleQueue::sumSquares(empty, sums);
+    REQUIRE(sums.empty());
+}
@@ -3,6 +3,7 @@
 #include "test_utils.hpp"
 
 #include <QString>
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <tuple>
@@ -81,6 +82,30 @@ TEST_CASE("Effects stack", "[Effects]")
         REQUIRE(model->rowCount() == 1);
     }
 
+    SECTION("Effect instances share their parameter definitions")
+    {
+        std::vector<std::shared_ptr<EffectItemModel>> instances;
+        instances.reserve(10000);
+        BENCHMARK("Build 10000 effects")
+        {
+            for (int i = 0; i < 10000; ++i) {
+                instances.push_back(EffectItemModel::construct(anEffect, model));
+            }
+        }
+        REQUIRE(instances.size() == 10000);
+        auto descriptor = EffectsRepository::get()->getDescriptor(anEffect);
+        REQUIRE(descriptor->rowCount() == instances.front()->rowCount());
+        bool shared = std::all_of(instances.begin(), instances.end(), [&](const std::shared_ptr<EffectItemModel> &effect) { return effect->getDescriptor() == descriptor; });
+        REQUIRE(shared);
+
+        // Values are still stored per instance
+        const QString paramName = descriptor->row(0).name;
+        int defaultValue = instances.back()->filter().get_int(paramName.toUtf8().constData());
+        instances.front()->internalSetParameter(paramName, QString::number(defaultValue + 1));
+        REQUIRE(instances.front()->filter().get_int(paramName.toUtf8().constData()) == defaultValue + 1);
+        REQUIRE(instances.back()->filter().get_int(paramName.toUtf8().constData()) == defaultValue);
+    }
+
     SECTION("Create cut with fade in")
     {
         auto clipModel = timeline->getClipPtr(cid1)->m_effectStack;
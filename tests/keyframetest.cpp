@@ -251,6 +251,32 @@ TEST_CASE("Keyframe model", "[KeyframeModel]")
         undoStack->undo();
         state1(6.1);
     }
+
+    SECTION("Interpolation matches MLT")
+    {
+        REQUIRE(model->addKeyframe(GenTime(1.), KeyframeType::Curve, 10));
+        REQUIRE(model->addKeyframe(GenTime(3.), KeyframeType::Linear, 80));
+        REQUIRE(model->addKeyframe(GenTime(5.), KeyframeType::Discrete, 20));
+        REQUIRE(model->addKeyframe(GenTime(7.), KeyframeType::Curve, 60));
+        REQUIRE(model->addKeyframe(GenTime(8.), KeyframeType::Linear, 5));
+        auto check = [&]() {
+            Mlt::Properties mlt_prop;
+            mlt_prop.set("key", model->getAnimProperty().toUtf8().constData());
+            int last = GenTime(9.).frames(pCore->getCurrentFps());
+            for (int frame = 0; frame <= last; frame++) {
+                double expected = mlt_prop.anim_get_double("key", frame);
+                REQUIRE(qAbs(model->getInterpolatedValue(frame).toDouble() - expected) < 1e-6);
+            }
+        };
+        check();
+        // Edits must invalidate the compiled keyframes
+        REQUIRE(model->updateKeyframe(GenTime(3.), 30));
+        check();
+        undoStack->undo();
+        check();
+        REQUIRE(model->removeKeyframe(GenTime(5.)));
+        check();
+    }
     pCore->m_projectManager = nullptr;
     Logger::print_trace();
 }
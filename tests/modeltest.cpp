@@ -346,6 +346,32 @@ TEST_CASE("Clip manipulation", "[ClipModel]")
         CHECK_MOVE(Once);
     }
 
+    SECTION("Check move feasibility without moving")
+    {
+        int pos2 = binModel->getClipByBinID(binId)->frameDuration();
+        REQUIRE(timeline->requestClipMove(cid1, tid1, 0));
+        REQUIRE(timeline->requestClipMove(cid2, tid1, pos2));
+        REQUIRE(timeline->checkConsistency());
+        CHECK_INSERT(2);
+
+        using Feasibility = TimelineModel::MoveFeasibility;
+        REQUIRE(timeline->checkClipMove(cid1, tid1, 0) == Feasibility::Possible);
+        REQUIRE(timeline->checkClipMove(cid1, tid1, 2) == Feasibility::Impossible);
+        REQUIRE(timeline->checkClipMove(cid1, tid1, -1) == Feasibility::Impossible);
+        REQUIRE(timeline->checkClipMove(cid1, tid1, 2 * pos2) == Feasibility::Possible);
+        REQUIRE(timeline->checkClipMove(cid1, tid2, pos2 + 2) == Feasibility::Possible);
+        REQUIRE(timeline->checkClipMove(cid3, tid1, pos2 - 2) == Feasibility::Impossible);
+        REQUIRE(timeline->requestClipMoveAttempt(cid1, tid2, 3));
+        REQUIRE_FALSE(timeline->requestClipMoveAttempt(cid2, tid1, 1));
+
+        // Nothing was modified
+        REQUIRE(timeline->getClipTrackId(cid1) == tid1);
+        REQUIRE(timeline->getClipPosition(cid1) == 0);
+        REQUIRE(timeline->getClipPosition(cid2) == pos2);
+        REQUIRE(timeline->checkConsistency());
+        NO_OTHERS();
+    }
+
     int length = binModel->getClipByBinID(binId)->frameDuration();
     SECTION("Insert consecutive clips")
     {
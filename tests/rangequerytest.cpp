@@ -0,0 +1,85 @@
+#include "test_utils.hpp"
+
+using namespace fakeit;
+Mlt::Profile profile_range;
+
+TEST_CASE("Range queries on large tracks", "[TrackModel]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    std::shared_ptr<TimelineItemModel> timeline = TimelineItemModel::construct(&profile_range, guideModel, undoStack);
+
+    const int clipLength = 20;
+    QString binId = createProducer(profile_range, "red", binModel, clipLength);
+    int tid = TrackModel::construct(timeline);
+    auto track = timeline->getTrackById(tid);
+
+    // Fill the track with adjacent clips, leaving a blank every 10 clips
+    auto fillTrack = [&](int count) {
+        int existing = timeline->getTrackClipsCount(tid);
+        for (int i = existing; i < count; i++) {
+            int cid = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+            REQUIRE(timeline->requestClipMove(cid, tid, i * clipLength + (i / 10) * 5, true, false, false));
+        }
+    };
+
+    // Reference implementation, scanning all clips
+    auto bruteForce = [&](int position, int end) {
+        std::unordered_set<int> ids;
+        for (const auto &clp : track->m_allClips) {
+            int pos = clp.second->getPosition();
+            if (pos < end && pos + clp.second->getPlaytime() - 1 >= position) {
+                ids.insert(clp.first);
+            }
+        }
+        return ids;
+    };
+
+    std::default_random_engine gen(42);
+    const int queries = 2000;
+    for (int count : {1000, 10000}) {
+        fillTrack(count);
+        REQUIRE(timeline->getTrackClipsCount(tid) == count);
+        REQUIRE(timeline->checkConsistency());
+        int duration = track->trackDuration();
+        std::uniform_int_distribution<int> dist(0, duration);
+        std::vector<int> positions;
+        for (int i = 0; i < queries; i++) {
+            positions.push_back(dist(gen));
+        }
+
+        // Check results against the reference
+        for (int i = 0; i < 200; i++) {
+            int pos = positions[(size_t)i];
+            REQUIRE(track->getClipsInRange(pos, pos + 50) == bruteForce(pos, pos + 50));
+            int cid = track->getClipByPosition(pos);
+            auto expected = bruteForce(pos, pos + 1);
+            if (expected.empty()) {
+                REQUIRE(cid == -1);
+            } else {
+                REQUIRE(expected.count(cid) == 1);
+            }
+        }
+
+        size_t found = 0;
+        const std::string label = std::to_string(queries) + " range queries on " + std::to_string(count) + " clips";
+        BENCHMARK(label)
+        {
+            for (int pos : positions) {
+                found += track->getClipsInRange(pos, pos + 50).size();
+                found += track->getClipByPosition(pos) >= 0 ? 1 : 0;
+            }
+        }
+        REQUIRE(found > 0);
+    }
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
@@ -0,0 +1,51 @@
+#include "catch.hpp"
+
+#include <QDomDocument>
+#include <QVector>
+
+#include "dialogs/renderwidget.h"
+
+TEST_CASE("Segmented render boundaries", "[RenderWidget]")
+{
+    const double fps = 25;
+    // Track cuts at 0, 240, 340 and 740. The bin playlist is not part of the timeline and its cut at 500 is ignored.
+    QDomDocument doc;
+    REQUIRE(doc.setContent(QStringLiteral("<mlt>"
+                                          "<playlist id=\"main_bin\"><entry producer=\"p\" in=\"0\" out=\"499\"/><entry producer=\"p\" in=\"0\" out=\"499\"/></playlist>"
+                                          "<playlist id=\"playlist0\"><entry producer=\"p\" in=\"0\" out=\"239\"/><blank length=\"00:00:04.000\"/>"
+                                          "<entry producer=\"p\" in=\"10\" out=\"409\"/></playlist>"
+                                          "</mlt>")));
+
+    SECTION("Split points snap to close cuts and guides")
+    {
+        // Ideal split points are 250, 500 and 750
+        REQUIRE(RenderWidget::segmentBoundaries(doc, 0, 999, 4, fps, {520}) == QVector<int>({0, 240, 520, 740, 1000}));
+        // Without a close cut, the ideal split point is kept
+        REQUIRE(RenderWidget::segmentBoundaries(doc, 0, 999, 4, fps, {}) == QVector<int>({0, 240, 500, 740, 1000}));
+        REQUIRE(RenderWidget::segmentBoundaries(QDomDocument(), 0, 999, 4, fps, {}) == QVector<int>({0, 250, 500, 750, 1000}));
+    }
+
+    SECTION("Boundaries start at in and end after out")
+    {
+        // Split points are relative to the zone start: 350, 600 and 850
+        REQUIRE(RenderWidget::segmentBoundaries(doc, 100, 1099, 4, fps, {}) == QVector<int>({100, 340, 600, 850, 1100}));
+        // Cuts far from the split point are not used
+        REQUIRE(RenderWidget::segmentBoundaries(doc, 260, 759, 2, fps, {}) == QVector<int>({260, 510, 760}));
+    }
+
+    SECTION("Short zones are not split")
+    {
+        // Segments are at least 10 seconds long
+        REQUIRE(RenderWidget::segmentBoundaries(doc, 0, 249, 4, fps, {}) == QVector<int>({0, 250}));
+        REQUIRE(RenderWidget::segmentBoundaries(doc, 0, 499, 4, fps, {}) == QVector<int>({0, 240, 500}));
+        REQUIRE(RenderWidget::segmentBoundaries(doc, 0, 999, 1, fps, {}) == QVector<int>({0, 1000}));
+    }
+
+    SECTION("Segment file names")
+    {
+        REQUIRE(RenderWidget::segmentFileName(QStringLiteral("/tmp/render.mp4"), QStringLiteral("-part1")) == QStringLiteral("/tmp/render-part1.mp4"));
+        // Dots in folder names and files without extension
+        REQUIRE(RenderWidget::segmentFileName(QStringLiteral("/tmp/a.b/render"), QStringLiteral("-part2")) == QStringLiteral("/tmp/a.b/render-part2"));
+        REQUIRE(RenderWidget::segmentFileName(QStringLiteral("/tmp/my.render.mkv"), QStringLiteral("-seg3")) == QStringLiteral("/tmp/my.render-seg3.mkv"));
+    }
+}
@@ -0,0 +1,79 @@
+#include "catch.hpp"
+
+#include <QString>
+#include <vector>
+
+#include "jobs/scenedetector.hpp"
+
+TEST_CASE("Scene detection scores and cuts", "[SceneDetector]")
+{
+    const int width = 64;
+    const int height = 36;
+    auto plane = [&](uchar value) { return std::vector<uchar>(size_t(width * height), value); };
+
+    SECTION("Frame scores")
+    {
+        std::vector<uchar> gray = plane(128);
+        std::vector<uchar> black = plane(16);
+        std::vector<uchar> white = plane(235);
+        auto graySignature = SceneDetector::signature(gray.data(), width, height, 1, width);
+        REQUIRE(graySignature.valid);
+        // A frame too small for the grid has no signature
+        REQUIRE_FALSE(SceneDetector::signature(gray.data(), 4, 4, 1, 4).valid);
+        REQUIRE(SceneDetector::score(graySignature, graySignature) == 0.f);
+        REQUIRE(SceneDetector::score(SceneDetector::Signature(), graySignature) == 0.f);
+
+        auto blackSignature = SceneDetector::signature(black.data(), width, height, 1, width);
+        auto whiteSignature = SceneDetector::signature(white.data(), width, height, 1, width);
+        REQUIRE(SceneDetector::score(blackSignature, whiteSignature) == Approx(1.f));
+
+        // A slight brightness change keeps the histogram bins and gives a low score
+        std::vector<uchar> lighter = plane(130);
+        auto lighterSignature = SceneDetector::signature(lighter.data(), width, height, 1, width);
+        REQUIRE(SceneDetector::score(graySignature, lighterSignature) < 0.05f);
+
+        // Packed samples give the same signature as a planar luma
+        std::vector<uchar> packed(size_t(2 * width * height), 128);
+        auto packedSignature = SceneDetector::signature(packed.data(), width, height, 2, 2 * width);
+        REQUIRE(SceneDetector::score(graySignature, packedSignature) == 0.f);
+    }
+
+    SECTION("Cuts")
+    {
+        std::vector<float> scores{0.f, 0.1f, 0.5f, 0.8f, 0.1f, 0.f, 0.9f, 0.f};
+        // The transition on frames 12 and 13 is cut at its peak
+        REQUIRE(SceneDetector::cuts(scores, 10, 0.3f, 0) == QVector<int>({13, 16}));
+        REQUIRE(SceneDetector::cuts(scores, 10, 0.85f, 0) == QVector<int>({16}));
+        REQUIRE(SceneDetector::cuts(scores, 10, 0.3f, 5) == QVector<int>({16}));
+        REQUIRE(SceneDetector::cuts(scores, 10, 0.3f, 10).isEmpty());
+    }
+
+    SECTION("Stored scores")
+    {
+        std::vector<float> scores{0.f, 0.02f, 0.5f, 0.8f, 0.1234f, 0.f};
+        const QString hash = QStringLiteral("0123456789abcdef");
+        const QString data = SceneDetector::serializeScores(scores, 20, hash);
+        std::vector<float> parsed;
+        REQUIRE(SceneDetector::parseScores(data, hash, 20, 25, parsed));
+        REQUIRE(parsed.size() == scores.size());
+        // Scores below the minimum threshold are dropped
+        REQUIRE(parsed[1] == 0.f);
+        REQUIRE(parsed[2] == Approx(0.5f));
+        REQUIRE(parsed[3] == Approx(0.8f));
+        REQUIRE(parsed[4] == Approx(0.123f));
+
+        // A sub range can be read back
+        REQUIRE(SceneDetector::parseScores(data, hash, 22, 24, parsed));
+        REQUIRE(parsed.size() == 3);
+        REQUIRE(parsed[1] == Approx(0.8f));
+
+        // Frames outside of the stored range are not available
+        REQUIRE_FALSE(SceneDetector::parseScores(data, hash, 19, 25, parsed));
+        REQUIRE_FALSE(SceneDetector::parseScores(data, hash, 20, 26, parsed));
+        REQUIRE_FALSE(SceneDetector::parseScores(QString(), hash, 20, 25, parsed));
+
+        // Scores of a replaced file are not reused
+        REQUIRE_FALSE(SceneDetector::parseScores(data, QStringLiteral("fedcba9876543210"), 20, 25, parsed));
+        REQUIRE_FALSE(SceneDetector::parseScores(data, QString(), 20, 25, parsed));
+    }
+}
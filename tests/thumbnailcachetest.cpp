@@ -0,0 +1,79 @@
+#include "test_utils.hpp"
+#include "kdenlivesettings.h"
+#include "utils/thumbnailcache.hpp"
+
+Mlt::Profile profile_thumbs;
+
+TEST_CASE("Thumbnail cache memory budget", "[ThumbnailCache]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+
+    // Clips spread over several shards, each with its own hash
+    const int clipCount = 8;
+    std::vector<QString> binIds;
+    std::unordered_set<uint> shards;
+    for (int i = 0; i < clipCount; i++) {
+        QString binId = createProducer(profile_thumbs, "red", binModel);
+        binModel->getClipByBinID(binId)->setProducerProperty(QStringLiteral("kdenlive:file_hash"), QStringLiteral("thumbcachetest%1").arg(i));
+        binIds.push_back(binId);
+        shards.insert(qHash(binId) % ThumbnailCache::ShardCount);
+    }
+    REQUIRE(shards.size() > 1);
+
+    QImage image(64, 36, QImage::Format_RGB32);
+    image.fill(Qt::red);
+    const qint64 cost = image.sizeInBytes();
+    auto &cache = ThumbnailCache::get();
+    cache->clearCache();
+    REQUIRE(cache->m_memoryUsed == 0);
+    cache->setMemoryBudget(10 * cost);
+    const ThumbnailCache::Statistics initial = cache->statistics();
+
+    // Store the thumbnails of all clips for each position, so that consecutive thumbnails go to different shards
+    std::vector<std::pair<QString, int>> order;
+    for (int pos = 0; pos < 4; pos++) {
+        for (const QString &binId : binIds) {
+            cache->storeThumbnail(binId, pos, image);
+            order.emplace_back(binId, pos);
+        }
+    }
+    // Only the most recent thumbnails are kept, whatever their shard
+    REQUIRE(cache->m_memoryUsed == 10 * cost);
+    ThumbnailCache::Statistics stats = cache->statistics();
+    REQUIRE(stats.evictions - initial.evictions == order.size() - 10);
+    REQUIRE(stats.count == 10);
+    REQUIRE(stats.memoryUsed == 10 * cost);
+    REQUIRE(stats.memoryBudget == 10 * cost);
+    for (size_t i = 0; i < order.size(); i++) {
+        REQUIRE(cache->hasThumbnail(order[i].first, order[i].second, true) == (i >= order.size() - 10));
+    }
+
+    // Reading a thumbnail makes it the most recently used one
+    const auto oldest = order[order.size() - 10];
+    REQUIRE_FALSE(cache->getThumbnail(oldest.first, oldest.second, true).isNull());
+    REQUIRE(cache->statistics().hits == stats.hits + 1);
+    REQUIRE(cache->getThumbnail(order.front().first, order.front().second, true).isNull());
+    REQUIRE(cache->statistics().misses == stats.misses + 1);
+
+    // Reducing the budget drops the least recently used thumbnails of all shards
+    cache->setMemoryBudget(3 * cost);
+    REQUIRE(cache->m_memoryUsed == 3 * cost);
+    REQUIRE(cache->statistics().evictions - initial.evictions == order.size() - 3);
+    REQUIRE(cache->hasThumbnail(oldest.first, oldest.second, true));
+    REQUIRE(cache->hasThumbnail(order[order.size() - 1].first, order[order.size() - 1].second, true));
+    REQUIRE(cache->hasThumbnail(order[order.size() - 2].first, order[order.size() - 2].second, true));
+    REQUIRE_FALSE(cache->hasThumbnail(order[order.size() - 3].first, order[order.size() - 3].second, true));
+
+    // A thumbnail larger than the budget is not stored
+    QImage large(256, 256, QImage::Format_RGB32);
+    large.fill(Qt::blue);
+    cache->storeThumbnail(binIds.front(), 100, large);
+    REQUIRE_FALSE(cache->hasThumbnail(binIds.front(), 100, true));
+    REQUIRE(cache->m_memoryUsed == 3 * cost);
+
+    cache->clearCache();
+    REQUIRE(cache->m_memoryUsed == 0);
+    cache->setMemoryBudget(qint64(qMax(1, KdenliveSettings::thumbnailcachesize())) * 1024 * 1024);
+    binModel->clean();
+}
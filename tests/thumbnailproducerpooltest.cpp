@@ -0,0 +1,92 @@
+#include "test_utils.hpp"
+#include "utils/thumbnailproducerpool.hpp"
+
+#include <QtConcurrent>
+
+Mlt::Profile profile_producerpool;
+
+TEST_CASE("Thumbnail producer reuse", "[ThumbnailProducerPool]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    QString binId = createProducer(profile_producerpool, "red", binModel, 200);
+    std::shared_ptr<ProjectClip> clip = binModel->getClipByBinID(binId);
+    REQUIRE(clip != nullptr);
+    auto &pool = ThumbnailProducerPool::get();
+
+    std::shared_ptr<Mlt::Producer> first = pool->acquire(clip, 10);
+    std::shared_ptr<Mlt::Producer> second = pool->acquire(clip, 100);
+    REQUIRE(first != nullptr);
+    REQUIRE(second != nullptr);
+    REQUIRE(first != second);
+    REQUIRE(pool->m_clips[binId].busy == 2);
+    pool->release(binId, first, 20);
+    pool->release(binId, second, 110);
+    REQUIRE(pool->m_clips[binId].busy == 0);
+    REQUIRE(pool->m_idle.size() == 2);
+
+    SECTION("The producer that stopped right before the frame is reused")
+    {
+        std::shared_ptr<Mlt::Producer> prod = pool->acquire(clip, 120);
+        REQUIRE(prod == second);
+        pool->release(binId, prod, 120);
+        prod = pool->acquire(clip, 30);
+        REQUIRE(prod == first);
+        pool->release(binId, prod, 30);
+        // Going backward is more expensive than going forward
+        prod = pool->acquire(clip, 70);
+        REQUIRE(prod == first);
+        pool->release(binId, prod, 70);
+        // Keyframe only producers are separate
+        prod = pool->acquire(clip, 70, true);
+        REQUIRE(prod != first);
+        REQUIRE(prod != second);
+        pool->release(binId, prod, 70);
+        REQUIRE(pool->m_idle.size() == 3);
+    }
+
+    SECTION("Invalidated producers are not reused")
+    {
+        std::shared_ptr<Mlt::Producer> leased = pool->acquire(clip, 20);
+        REQUIRE(leased == first);
+        pool->invalidateClip(binId);
+        // Idle producers are closed at once, the leased one when it is released
+        REQUIRE(pool->m_idle.empty());
+        REQUIRE(pool->m_clips[binId].busy == 1);
+        pool->release(binId, leased, 30);
+        REQUIRE(pool->m_idle.empty());
+        REQUIRE(pool->m_clips[binId].busy == 0);
+        std::shared_ptr<Mlt::Producer> prod = pool->acquire(clip, 30);
+        REQUIRE(prod != nullptr);
+        REQUIRE(prod != first);
+        REQUIRE(prod != second);
+        pool->release(binId, prod, 30);
+        REQUIRE(pool->m_idle.size() == 1);
+    }
+
+    SECTION("Acquire waits while all the producers of the clip are in use")
+    {
+        std::vector<std::shared_ptr<Mlt::Producer>> leased;
+        for (int i = 0; i < ThumbnailProducerPool::MaxProducersPerClip; i++) {
+            leased.push_back(pool->acquire(clip, 10 * i));
+            REQUIRE(leased.back() != nullptr);
+        }
+        QThreadPool thumbnailThreads;
+        QFuture<std::shared_ptr<Mlt::Producer>> waiting =
+            QtConcurrent::run(&thumbnailThreads, [&pool, clip]() { return pool->acquire(clip, 150); });
+        QThread::msleep(100);
+        REQUIRE_FALSE(waiting.isFinished());
+        pool->release(binId, leased.back(), 140);
+        waiting.waitForFinished();
+        REQUIRE(waiting.result() == leased.back());
+        leased.back() = waiting.result();
+        for (const auto &prod : leased) {
+            pool->release(binId, prod, 0);
+        }
+        REQUIRE(pool->m_clips[binId].busy == 0);
+    }
+
+    pool->invalidateClip(binId);
+    REQUIRE(pool->m_clips.count(binId) == 0);
+    binModel->clean();
+}
@@ -0,0 +1,90 @@
+#include "test_utils.hpp"
+#include <mlt++/MltEvent.h>
+
+using namespace fakeit;
+Mlt::Profile profile_batch;
+
+namespace {
+void countRefresh(mlt_properties, int *count)
+{
+    ++(*count);
+}
+} // namespace
+
+TEST_CASE("Batched playlist edits of group moves", "[TrackModel]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    std::shared_ptr<TimelineItemModel> timeline = TimelineItemModel::construct(&profile_batch, guideModel, undoStack);
+
+    const int clipLength = 20;
+    const int clipCount = 5;
+    const int delta = 7;
+    QString binId = createProducer(profile_batch, "red", binModel, clipLength);
+    int tid1 = TrackModel::construct(timeline);
+    int tid2 = TrackModel::construct(timeline);
+
+    // Same layout on both tracks
+    std::vector<int> clips1;
+    std::vector<int> clips2;
+    for (int i = 0; i < clipCount; i++) {
+        for (auto track : {std::make_pair(tid1, &clips1), std::make_pair(tid2, &clips2)}) {
+            int cid = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+            REQUIRE(timeline->requestClipMove(cid, track.first, i * 30, true, false, false));
+            track.second->push_back(cid);
+        }
+    }
+    int gid = timeline->requestClipsGroup(std::unordered_set<int>(clips1.begin(), clips1.end()));
+    REQUIRE(gid > 0);
+
+    // Count the length refreshes of the track multitrack, which are triggered by its playlists
+    auto listenRefresh = [&](int tid, int *count) {
+        auto track = timeline->getTrackById(tid);
+        Mlt::Properties multitrack(MLT_MULTITRACK_PROPERTIES(mlt_tractor_multitrack(track->m_track->get_tractor())));
+        return std::unique_ptr<Mlt::Event>(multitrack.listen("producer-changed", count, (mlt_listener)countRefresh));
+    };
+    int batchedRefresh = 0;
+    int singleRefresh = 0;
+    auto batchedEvent = listenRefresh(tid1, &batchedRefresh);
+    auto singleEvent = listenRefresh(tid2, &singleRefresh);
+
+    REQUIRE(timeline->requestGroupMove(clips1.front(), gid, 0, delta));
+    // Move the clips of the other track one by one, starting from the last one so that they don't overlap
+    for (int i = clipCount - 1; i >= 0; i--) {
+        REQUIRE(timeline->requestClipMove(clips2[(size_t)i], tid2, i * 30 + delta, true, true, false));
+    }
+    batchedEvent.reset();
+    singleEvent.reset();
+    REQUIRE(batchedRefresh >= 1);
+    REQUIRE(batchedRefresh < singleRefresh);
+
+    auto checkTracks = [&](int offset) {
+        REQUIRE(timeline->checkConsistency());
+        for (int i = 0; i < clipCount; i++) {
+            REQUIRE(timeline->getClipPosition(clips1[(size_t)i]) == i * 30 + offset);
+            REQUIRE(timeline->getClipPosition(clips2[(size_t)i]) == i * 30 + delta);
+        }
+        auto track = timeline->getTrackById(tid1);
+        // The tractor length was refreshed at the end of the batch
+        REQUIRE(track->m_track->get_length() == (clipCount - 1) * 30 + clipLength + offset);
+        REQUIRE(track->trackDuration() == track->m_track->get_length());
+    };
+    checkTracks(delta);
+    REQUIRE(timeline->getTrackById(tid1)->trackDuration() == timeline->getTrackById(tid2)->trackDuration());
+
+    undoStack->undo();
+    checkTracks(0);
+    undoStack->redo();
+    checkTracks(delta);
+
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
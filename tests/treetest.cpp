@@ -185,3 +185,80 @@ TEST_CASE("Basic tree testing", "[TreeModel]")
         state();
     }
 }
+
+TEST_CASE("Tree indexing on large bins", "[TreeModel]")
+{
+    auto model = AbstractTreeModel::construct();
+    auto root = model->getRoot();
+
+    SECTION("Flat bin")
+    {
+        const int count = 6000;
+        std::vector<std::shared_ptr<TreeItem>> items;
+        items.reserve(count);
+        BENCHMARK("Append 6000 items to a folder")
+        {
+            for (int i = 0; i < count; ++i) {
+                items.push_back(root->appendChild(QList<QVariant>{QString::number(i)}));
+            }
+        }
+        REQUIRE(model->rowCount() == count);
+
+        int errors = 0;
+        BENCHMARK("Index and parent of 6000 items")
+        {
+            for (int i = 0; i < count; ++i) {
+                QModelIndex ix = model->index(i, 0);
+                if (model->getItemById((int)ix.internalId()) != items[(size_t)i] || model->parent(ix).isValid() ||
+                    model->getIndexFromItem(items[(size_t)i]) != ix) {
+                    errors++;
+                }
+            }
+        }
+        REQUIRE(errors == 0);
+
+        // Removing and inserting in the middle of the folder shifts the following rows
+        root->removeChild(items[10]);
+        REQUIRE(items[11]->row() == 10);
+        REQUIRE(items.back()->row() == count - 2);
+        REQUIRE(root->appendChild(items[10]));
+        REQUIRE(items[10]->row() == count - 1);
+        root->moveChild(0, items[10]);
+        REQUIRE(items[10]->row() == 0);
+        REQUIRE(items[9]->row() == 10);
+        REQUIRE(items[11]->row() == 11);
+        REQUIRE(items.back()->row() == count - 1);
+        REQUIRE(model->checkConsistency());
+    }
+
+    SECTION("Deep bin")
+    {
+        // 60 nested folders of 100 items each
+        std::vector<std::shared_ptr<TreeItem>> folders;
+        auto current = root;
+        for (int depth = 0; depth < 60; ++depth) {
+            for (int i = 0; i < 99; ++i) {
+                current->appendChild(QList<QVariant>{QString::number(i)});
+            }
+            current = current->appendChild(QList<QVariant>{QStringLiteral("folder")});
+            folders.push_back(current);
+        }
+        REQUIRE(folders.back()->depth() == 60);
+
+        int errors = 0;
+        BENCHMARK("Index of the last item of 60 nested folders")
+        {
+            for (const auto &folder : folders) {
+                QModelIndex ix = model->getIndexFromItem(folder);
+                while (ix.isValid()) {
+                    if (ix.row() != 99) {
+                        errors++;
+                    }
+                    ix = model->parent(ix);
+                }
+            }
+        }
+        REQUIRE(errors == 0);
+        REQUIRE(model->checkConsistency());
+    }
+}